@@ -0,0 +1,101 @@
+// Host benchmark of the analog filter kernels (src/AnalogFilter.h): time per burst and the error left by the plain
+// mean, the median and the trimmed mean on synthetic ADC noise with spikes.
+//
+// The samples are drawn around a constant value with gaussian noise and a fraction of spikes to either end of the
+// 12-bit range, which is what the ESP32 ADC looks like on a steady input. The timings are for the host, the ESP32 is
+// one to two orders of magnitude slower, so they only compare the kernels with each other and with std::sort.
+//
+//   g++ -O2 -std=gnu++17 -Isrc scripts/analog_filter_benchmark.cpp -o analog_filter_benchmark
+//   ./analog_filter_benchmark
+
+#include "AnalogFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define TRUE_VALUE 2000
+#define NOISE_SIGMA 8.0
+#define SPIKE_RATE 0.03
+#define TRIM_PERCENT 20
+#define BURSTS 200000
+
+// Returns the bursts of samples, all of them concatenated
+static std::vector<uint16_t> generate(uint16_t count, std::mt19937 &random)
+{
+  std::normal_distribution<double> noise(TRUE_VALUE, NOISE_SIGMA);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<uint16_t> samples((size_t)count * BURSTS);
+  for (uint16_t &sample : samples)
+  {
+    double u = uniform(random);
+    if (u < SPIKE_RATE / 2)
+    {
+      sample = 0;
+    }
+    else if (u < SPIKE_RATE)
+    {
+      sample = 4095;
+    }
+    else
+    {
+      sample = (uint16_t)std::lround(std::min(4095.0, std::max(0.0, noise(random))));
+    }
+  }
+  return samples;
+}
+
+// Runs the kernel on copies of every burst, returns the nanoseconds per burst and the RMS error of the values
+template <typename Kernel>
+static void measure(const char *name, uint16_t count, const std::vector<uint16_t> &samples, Kernel kernel)
+{
+  std::vector<uint16_t> work(samples);
+  std::vector<float> values(BURSTS);
+  auto started = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < BURSTS; i++)
+  {
+    values[i] = kernel(work.data() + i * count, count);
+  }
+  auto finished = std::chrono::steady_clock::now();
+
+  double squares = 0;
+  for (float value : values)
+  {
+    squares += (value - TRUE_VALUE) * (value - TRUE_VALUE);
+  }
+  double nanoseconds = std::chrono::duration<double, std::nano>(finished - started).count() / BURSTS;
+  printf("%-22s %6u %12.0f %12.2f\n", name, count, nanoseconds, std::sqrt(squares / BURSTS));
+}
+
+int main()
+{
+  std::mt19937 random(42);
+  printf("noise sigma %.1f, %.0f%% spikes, trim %d%%\n\n", NOISE_SIGMA, SPIKE_RATE * 100, TRIM_PERCENT);
+  printf("%-22s %6s %12s %12s\n", "kernel", "count", "ns/burst", "rms error");
+
+  for (uint16_t count : {8, 16, 48, 64})
+  {
+    std::vector<uint16_t> samples = generate(count, random);
+    measure("mean", count, samples, [](uint16_t *values, uint16_t count)
+            { return analogTrimmedMean(values, count, 0).value; });
+    measure("median", count, samples, [](uint16_t *values, uint16_t count)
+            { return analogMedian(values, count); });
+    measure("trimmed mean", count, samples, [](uint16_t *values, uint16_t count)
+            { return analogTrimmedMean(values, count, TRIM_PERCENT).value; });
+    measure("std::sort + trim", count, samples, [](uint16_t *values, uint16_t count)
+            {
+              std::sort(values, values + count);
+              uint16_t trim = (uint32_t)count * TRIM_PERCENT / 100;
+              uint32_t sum = 0;
+              for (uint16_t i = trim; i < count - trim; i++)
+              {
+                sum += values[i];
+              }
+              return (float)sum / (count - 2 * trim); });
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""
+Decoder for the samples sent via Serial when the board has no network.
+
+The board sends lines of JSON by default or binary frames (see src/SerialFrame.h) when built with
+-DSERIAL_FORMAT_BINARY=1 or asked to with the FORMAT BINARY command. FrameDecoder accepts both and
+produces the same dictionaries, with the JSON keys, so a consumer does not depend on the format.
+
+Used as a script, it asks the board for binary frames at a faster rate and prints each sample as a
+line of JSON, e.g. to feed the rpiarduino stream of mqtt-io through a pipe:
+
+    python3 scripts/fufarm_serial.py /dev/ttyACM0 --baud 115200
+
+Requires pyserial (pip install pyserial) when used as a script.
+"""
+
+import argparse
+import json
+import sys
+import time
+
+SYNC = 0xA5
+VERSION = 1
+
+# bit -> (JSON key, decimals, kind), must match the bits in src/SensorRegistry.h
+NUMBER, PROBES, BINARY = range(3)
+FIELDS = {
+    0: ("tempair", 2, NUMBER),
+    1: ("humidity", 2, NUMBER),
+    2: ("aqi", 0, NUMBER),
+    3: ("tvoc", 0, NUMBER),
+    4: ("eco2", 0, NUMBER),
+    5: ("tempwet", 2, PROBES),
+    6: ("co2", 0, NUMBER),
+    7: ("ec", 2, NUMBER),
+    8: ("ph", 2, NUMBER),
+    9: ("flow", 2, NUMBER),
+    10: ("flow_total", 2, NUMBER),
+    11: ("light", 0, NUMBER),
+    12: ("moisture", 0, NUMBER),
+    13: ("water_level", 0, BINARY),
+}
+
+# defaults of the board, restored when it has not heard from the host for a while
+DEFAULT_BAUD = 9600
+KEEPALIVE_SECONDS = 60  # less than SERIAL_LINK_IDLE_MILLIS
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as serialFrameCrc() in src/SerialFrame.cpp."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def _read_varint(payload, offset):
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(payload):
+            raise ValueError("truncated value")
+        byte = payload[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, offset
+
+
+def _read_value(payload, offset, decimals):
+    encoded, offset = _read_varint(payload, offset)
+    if encoded == 0:
+        return None, offset
+    zigzag = encoded - 1
+    value = (zigzag >> 1) ^ -(zigzag & 1)
+    if decimals:
+        return round(value / 10**decimals, decimals), offset
+    return value, offset
+
+
+def decode_payload(payload):
+    """Decodes the payload of a frame (presence bitmap to sequence number) into (sample, sequence)."""
+    presence = payload[0] | (payload[1] << 8)
+    offset = 2
+    sample = {}
+    for bit in range(16):
+        if not presence & (1 << bit):
+            continue
+        if bit not in FIELDS:
+            raise ValueError("unknown bit %d" % bit)
+        key, decimals, kind = FIELDS[bit]
+        if kind == PROBES:
+            count, offset = _read_varint(payload, offset)
+            for i in range(count):
+                value, offset = _read_value(payload, offset, decimals)
+                # additional probes are numbered from 2 e.g. tempwet2, tempwet3
+                sample[key if i == 0 else "%s%d" % (key, i + 1)] = value
+        else:
+            value, offset = _read_value(payload, offset, decimals)
+            sample[key] = bool(value) if kind == BINARY else value
+    if offset + 2 != len(payload):
+        raise ValueError("unexpected length")
+    sequence = payload[offset] | (payload[offset + 1] << 8)
+    return sample, sequence
+
+
+class FrameDecoder:
+    """
+    Extracts the samples from the bytes received via Serial, whether they are frames or lines of JSON.
+    Other lines (e.g. logs or the answers to commands) are available in `lines`.
+    """
+
+    def __init__(self):
+        self._buffer = bytearray()
+        self._text = bytearray()
+        self._sequence = None
+        self.lines = []
+        self.crc_errors = 0
+        self.lost = 0
+
+    def feed(self, data):
+        """Adds received bytes and returns the samples that are complete."""
+        self._buffer += data
+        samples = []
+        while self._buffer:
+            if self._buffer[0] != SYNC:
+                self._text_byte(self._buffer.pop(0), samples)
+                continue
+            if len(self._buffer) < 3:
+                break
+            total = 3 + self._buffer[2] + 2
+            if len(self._buffer) < total:
+                break
+            frame = bytes(self._buffer[:total])
+            crc = frame[-2] | (frame[-1] << 8)
+            if frame[1] != VERSION or crc16(frame[1:-2]) != crc:
+                # not a frame or a corrupted one, look for the next sync byte
+                self.crc_errors += 1
+                del self._buffer[0]
+                continue
+            del self._buffer[:total]
+            try:
+                sample, sequence = decode_payload(frame[3:-2])
+            except ValueError:
+                self.crc_errors += 1
+                continue
+            if self._sequence is not None:
+                self.lost += (sequence - self._sequence - 1) & 0xFFFF
+            self._sequence = sequence
+            samples.append(sample)
+        return samples
+
+    def _text_byte(self, byte, samples):
+        if byte not in (0x0A, 0x0D):
+            self._text.append(byte)
+            return
+        line = self._text.decode("utf-8", "replace").strip()
+        self._text.clear()
+        if not line:
+            return
+        try:
+            sample = json.loads(line)
+        except ValueError:
+            sample = None
+        # the answers to commands are JSON too but only carry the settings of the link
+        if isinstance(sample, dict) and not set(sample) <= {"baud", "format"}:
+            samples.append(sample)
+        else:
+            self.lines.append(line)
+
+
+def _negotiate(port, baud, binary):
+    """Sends the commands to the board and switches the port to the rate once acknowledged."""
+    if binary:
+        port.write(b"FORMAT BINARY\n")
+    if baud != port.baudrate:
+        port.write(b"BAUD %d\n" % baud)
+        port.flush()
+        # the board answers at the current rate then switches
+        deadline = time.monotonic() + 2
+        while time.monotonic() < deadline:
+            line = port.readline().strip()
+            if line == b'{"baud":%d}' % baud:
+                port.baudrate = baud
+                return
+        # no answer: the board may already be at the rate, e.g. the host restarted
+        port.baudrate = baud
+        if binary:
+            port.write(b"FORMAT BINARY\n")
+        port.write(b"BAUD %d\n" % baud)
+    else:
+        port.write(b"BAUD %d\n" % baud)
+
+
+def main():
+    import serial  # pyserial
+
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("device", help="serial device e.g. /dev/ttyACM0")
+    parser.add_argument("--baud", type=int, default=DEFAULT_BAUD, help="rate to ask for (default: %(default)s)")
+    parser.add_argument("--json", action="store_true", help="keep the JSON format instead of binary frames")
+    args = parser.parse_args()
+
+    decoder = FrameDecoder()
+    with serial.Serial(args.device, DEFAULT_BAUD, timeout=1) as port:
+        _negotiate(port, args.baud, not args.json)
+        keepalive = time.monotonic()
+        while True:
+            for sample in decoder.feed(port.read(port.in_waiting or 1)):
+                print(json.dumps(sample, separators=(",", ":")), flush=True)
+            for line in decoder.lines:
+                print(line, file=sys.stderr)
+            decoder.lines.clear()
+
+            # the board restores its defaults when it has not heard from us for a while
+            if time.monotonic() - keepalive >= KEEPALIVE_SECONDS:
+                keepalive = time.monotonic()
+                port.write(b"BAUD %d\n" % args.baud)
+                if not args.json:
+                    port.write(b"FORMAT BINARY\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+Imports the samples replayed by the boards after an outage into the long-term statistics of Home Assistant.
+
+A board built with -DUSE_SAMPLE_SPOOL=1 keeps the samples it takes while the broker is unreachable and replays
+them once reconnected on <prefix>/<device id>/history (see src/HomeAssistant.h), e.g.
+{"time":1735689600,"tempair":21.5,...}. Home Assistant records the states of MQTT entities at the time they are
+received, so it cannot take them as states. This subscribes to that topic, groups the samples of each value by
+hour and imports their mean, minimum and maximum as the external statistic fufarm:<device id>_<key> via the
+recorder/import_statistics API of Home Assistant. Add them to a Statistics graph card next to the entities.
+
+Home Assistant upserts the statistics of an hour, so an hour is imported again as more of its samples arrive.
+Keep it running while the boards replay: the hours are grouped in memory, and a restart in the middle of an
+hour re-imports it from the samples received after the restart only.
+
+    HA_TOKEN=<long-lived access token> python3 scripts/history_importer.py --mqtt-host 192.168.1.10 \\
+        --ha-url ws://homeassistant.local:8123/api/websocket
+
+Requires paho-mqtt 2 and websocket-client (pip install paho-mqtt websocket-client).
+"""
+
+import argparse
+import json
+import os
+import sys
+import threading
+import time
+from datetime import datetime, timezone
+
+# key -> unit, must match the JSON keys and units in src/SensorRegistry.h, probes are numbered from 2 (tempwet2)
+UNITS = {
+    "tempair": "°C",
+    "humidity": "%",
+    "aqi": None,
+    "tvoc": "ppb",
+    "eco2": "ppm",
+    "tempwet": "°C",
+    "co2": "ppm",
+    "ec": "mS/cm",
+    "ph": None,
+    "flow": "L/min",
+    "flow_total": "L",
+    "light": "lx",
+    "moisture": "%",
+}
+
+# the values that can be below zero, their failures are reported from -1000 instead of with -1
+SIGNED = ("tempair", "tempwet")
+
+AIR_QUALITY_INVALID = 65535
+
+# how often the hours that received samples are imported
+IMPORT_INTERVAL_SECONDS = 10
+
+
+def registry_key(key):
+    """Returns the key of the registry for a key of the JSON, e.g. tempwet for tempwet2."""
+    base = key.rstrip("0123456789")
+    return base if base in UNITS else key
+
+
+def valid(key, value):
+    """Whether a value is a reading rather than a failure, as sensorValueValid() in src/sensors.h."""
+    if isinstance(value, bool) or not isinstance(value, (int, float)):
+        return False
+    if key in SIGNED:
+        return value > -1000
+    if key in ("aqi", "tvoc", "eco2"):
+        return value != AIR_QUALITY_INVALID
+    return value >= 0
+
+
+class HourlyStatistics:
+    """Mean, minimum and maximum of the values of each statistic per hour."""
+
+    def __init__(self):
+        self._hours = {}  # (statistic id, hour start) -> [count, sum, min, max]
+        self._dirty = set()
+        self._units = {}
+        self._lock = threading.Lock()
+
+    def add(self, device, sample):
+        """Adds a sample from the history topic, returns false if it has no time."""
+        if "time" not in sample:
+            return False
+        hour = int(sample["time"]) // 3600 * 3600
+        with self._lock:
+            for key, value in sample.items():
+                base = registry_key(key)
+                if base not in UNITS or not valid(base, value):
+                    continue  # e.g. time, variance, water_level or a failed read
+                statistic = "fufarm:%s_%s" % (device.lower(), key)
+                self._units[statistic] = UNITS[base]
+                bucket = self._hours.setdefault((statistic, hour), [0, 0.0, value, value])
+                bucket[0] += 1
+                bucket[1] += value
+                bucket[2] = min(bucket[2], value)
+                bucket[3] = max(bucket[3], value)
+                self._dirty.add((statistic, hour))
+        return True
+
+    def take_dirty(self):
+        """Returns the statistics to import, {statistic id: (unit, [hours], [rows])}, and forgets that they changed."""
+        imports = {}
+        with self._lock:
+            for statistic, hour in sorted(self._dirty):
+                count, total, minimum, maximum = self._hours[(statistic, hour)]
+                row = {
+                    "start": datetime.fromtimestamp(hour, tz=timezone.utc).isoformat(),
+                    "mean": total / count,
+                    "min": minimum,
+                    "max": maximum,
+                }
+                unit, hours, rows = imports.setdefault(statistic, (self._units[statistic], [], []))
+                hours.append(hour)
+                rows.append(row)
+            self._dirty.clear()
+        return imports
+
+    def mark_dirty(self, statistic, hours):
+        """Imports the hours again with the next take_dirty(), e.g. after a failure."""
+        with self._lock:
+            self._dirty.update((statistic, hour) for hour in hours)
+
+
+class HomeAssistantApi:
+    """Minimal client of the WebSocket API of Home Assistant."""
+
+    def __init__(self, url, token):
+        import websocket  # websocket-client
+
+        self._socket = websocket.create_connection(url)
+        self._id = 0
+        if json.loads(self._socket.recv())["type"] != "auth_required":
+            raise RuntimeError("unexpected greeting")
+        self._socket.send(json.dumps({"type": "auth", "access_token": token}))
+        answer = json.loads(self._socket.recv())
+        if answer["type"] != "auth_ok":
+            raise RuntimeError("authentication failed: %s" % answer.get("message"))
+
+    def call(self, message):
+        self._id += 1
+        message = dict(message, id=self._id)
+        self._socket.send(json.dumps(message))
+        while True:
+            answer = json.loads(self._socket.recv())
+            if answer.get("id") == self._id:
+                if not answer.get("success"):
+                    raise RuntimeError(answer.get("error"))
+                return answer.get("result")
+
+    def import_statistics(self, statistic, unit, rows):
+        source, name = statistic.split(":", 1)
+        self.call(
+            {
+                "type": "recorder/import_statistics",
+                "metadata": {
+                    "source": source,
+                    "statistic_id": statistic,
+                    "name": name,
+                    "unit_of_measurement": unit,
+                    "has_mean": True,
+                    "has_sum": False,
+                },
+                "stats": rows,
+            }
+        )
+
+
+def main():
+    import paho.mqtt.client as mqtt
+
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--mqtt-host", required=True, help="address of the broker")
+    parser.add_argument("--mqtt-port", type=int, default=1883, help="port of the broker (default: %(default)s)")
+    parser.add_argument("--mqtt-username", help="user name on the broker")
+    parser.add_argument("--mqtt-password", help="password on the broker")
+    parser.add_argument("--prefix", default="homeassistant", help="HOME_ASSISTANT_DATA_PREFIX (default: %(default)s)")
+    parser.add_argument("--ha-url", required=True, help="WebSocket API e.g. ws://homeassistant.local:8123/api/websocket")
+    parser.add_argument("--token", default=os.environ.get("HA_TOKEN"), help="long-lived access token (default: $HA_TOKEN)")
+    args = parser.parse_args()
+    if not args.token:
+        parser.error("a Home Assistant access token is needed, via --token or HA_TOKEN")
+
+    statistics = HourlyStatistics()
+    # connected once up front so that a wrong URL or token is reported straight away
+    api = HomeAssistantApi(args.ha_url, args.token)
+
+    def on_connect(client, userdata, flags, reason, properties):
+        client.subscribe(args.prefix + "/+/history", qos=1)
+
+    def on_message(client, userdata, message):
+        device = message.topic.split("/")[-2]
+        try:
+            sample = json.loads(message.payload)
+        except ValueError:
+            print("Not JSON on %s" % message.topic, file=sys.stderr)
+            return
+        if not statistics.add(device, sample):
+            # taken before the board obtained the time, there is no telling when
+            print("Sample of %s without a time skipped" % device, file=sys.stderr)
+
+    client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2)
+    if args.mqtt_username:
+        client.username_pw_set(args.mqtt_username, args.mqtt_password)
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.mqtt_host, args.mqtt_port)
+    client.loop_start()
+
+    while True:
+        time.sleep(IMPORT_INTERVAL_SECONDS)
+        for statistic, (unit, hours, rows) in statistics.take_dirty().items():
+            try:
+                if api is None:
+                    api = HomeAssistantApi(args.ha_url, args.token)
+                api.import_statistics(statistic, unit, rows)
+            except Exception as error:
+                # e.g. Home Assistant restarted, tried again with the next import
+                print("Could not import %s: %s" % (statistic, error), file=sys.stderr)
+                statistics.mark_dirty(statistic, hours)
+                api = None
+                continue
+            print("Imported %d hours of %s" % (len(rows), statistic), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,201 @@
+// Host benchmark of the serial JSON output: JsonWriter against the ArduinoJson JsonDocument it replaces.
+// It also checks that both produce the same bytes for random samples, including invalid (-1) and NaN values.
+//
+// ArduinoJson is only a dependency of the benchmark environment, fetched with pio pkg install --environment benchmark:
+//   g++ -O2 -std=gnu++17 -Isrc -I.pio/libdeps/benchmark/ArduinoJson/src scripts/json_benchmark.cpp src/JsonWriter.cpp -o json_benchmark
+//   ./json_benchmark
+// Without ArduinoJson in the include path, only JsonWriter is measured and the outputs are not compared.
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#endif
+#include "JsonWriter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+
+#define ITERATIONS 200000
+#define PROBES 3
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Same types as FuFarmSensorsData with every sensor enabled
+struct Sample
+{
+  float tempair, humidity;
+  uint16_t aqi, tvoc, eco2;
+  float tempwet[PROBES];
+  uint8_t tempwetCount;
+  int32_t co2;
+  float ec, ph, flow, flowTotal;
+  int32_t light, moisture;
+  bool waterLevel;
+};
+
+static Sample randomSample(std::mt19937 &rng)
+{
+  std::uniform_real_distribution<float> temperature(-10, 45), percent(0, 100), small(0, 14), total(0, 1e6f);
+  std::uniform_int_distribution<int32_t> analog(-1, 4095);
+  std::uniform_int_distribution<int> invalid(0, 9);
+
+  Sample s;
+  s.tempair = invalid(rng) ? temperature(rng) : -1;
+  s.humidity = percent(rng);
+  s.aqi = (uint16_t)analog(rng);
+  s.tvoc = (uint16_t)analog(rng);
+  s.eco2 = (uint16_t)analog(rng);
+  for (int i = 0; i < PROBES; i++)
+  {
+    s.tempwet[i] = invalid(rng) ? temperature(rng) : -1000;
+  }
+  s.tempwetCount = PROBES;
+  s.co2 = analog(rng);
+  s.ec = small(rng);
+  s.ph = invalid(rng) ? small(rng) : NAN;
+  s.flow = invalid(rng) ? small(rng) : 0;
+  s.flowTotal = total(rng);
+  s.light = analog(rng);
+  s.moisture = analog(rng);
+  s.waterLevel = invalid(rng) > 4;
+  return s;
+}
+
+#ifdef HAVE_ARDUINOJSON
+static JsonDocument doc;
+
+static size_t withJsonDocument(const Sample &s, char *out, size_t capacity)
+{
+  doc["tempair"] = s.tempair;
+  doc["humidity"] = s.humidity;
+  doc["aqi"] = s.aqi;
+  doc["tvoc"] = s.tvoc;
+  doc["eco2"] = s.eco2;
+  doc["tempwet"] = s.tempwet[0];
+  for (uint8_t i = 1; i < s.tempwetCount; i++)
+  {
+    char key[12];
+    snprintf(key, sizeof(key), "tempwet%u", i + 1);
+    doc[key] = s.tempwet[i];
+  }
+  doc["co2"] = s.co2;
+  doc["ec"] = s.ec;
+  doc["ph"] = s.ph;
+  doc["flow"] = s.flow;
+  doc["flow_total"] = s.flowTotal;
+  doc["light"] = s.light;
+  doc["moisture"] = s.moisture;
+  doc["water_level"] = s.waterLevel;
+  return serializeJson(doc, out, capacity);
+}
+#endif
+
+static size_t withJsonWriter(const Sample &s, char *out, size_t capacity)
+{
+  JsonWriter json(out, capacity);
+  json.beginObject();
+  json.key("tempair");
+  json.value(s.tempair);
+  json.key("humidity");
+  json.value(s.humidity);
+  json.key("aqi");
+  json.value(s.aqi);
+  json.key("tvoc");
+  json.value(s.tvoc);
+  json.key("eco2");
+  json.value(s.eco2);
+  json.key("tempwet");
+  json.value(s.tempwet[0]);
+  for (uint8_t i = 1; i < s.tempwetCount; i++)
+  {
+    json.key("tempwet", i + 1);
+    json.value(s.tempwet[i]);
+  }
+  json.key("co2");
+  json.value(s.co2);
+  json.key("ec");
+  json.value(s.ec);
+  json.key("ph");
+  json.value(s.ph);
+  json.key("flow");
+  json.value(s.flow);
+  json.key("flow_total");
+  json.value(s.flowTotal);
+  json.key("light");
+  json.value(s.light);
+  json.key("moisture");
+  json.value(s.moisture);
+  json.key("water_level");
+  json.value(s.waterLevel);
+  json.endObject();
+  return json.length();
+}
+
+typedef size_t (*Serializer)(const Sample &, char *, size_t);
+
+static void run(const char *name, Serializer serialize, const Sample *samples, size_t count)
+{
+  char out[512];
+  size_t bytes = 0;
+  size_t before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ITERATIONS; i++)
+  {
+    bytes += serialize(samples[i % count], out, sizeof(out));
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("%-13s %8.1f ns/sample %6.2f allocations/sample (%zu bytes)\n", name, elapsed / ITERATIONS,
+         (double)(allocations - before) / ITERATIONS, bytes);
+}
+
+int main()
+{
+  const size_t count = 1000;
+  static Sample samples[count];
+  std::mt19937 rng(42);
+  for (size_t i = 0; i < count; i++)
+  {
+    samples[i] = randomSample(rng);
+  }
+
+#ifdef HAVE_ARDUINOJSON
+  // the output must not change for the consumers of the serial stream (e.g. mqtt-io)
+  for (size_t i = 0; i < count; i++)
+  {
+    char expected[512], actual[512];
+    withJsonDocument(samples[i], expected, sizeof(expected));
+    withJsonWriter(samples[i], actual, sizeof(actual));
+    if (strcmp(expected, actual) != 0)
+    {
+      printf("Mismatch for sample %zu:\n  JsonDocument: %s\n  JsonWriter:   %s\n", i, expected, actual);
+      return 1;
+    }
+  }
+  printf("Outputs identical for %zu samples\n", count);
+
+  run("JsonDocument", withJsonDocument, samples, count);
+#else
+  printf("ArduinoJson not found, the outputs are not compared\n");
+#endif
+  run("JsonWriter", withJsonWriter, samples, count);
+  return 0;
+}
@@ -0,0 +1,231 @@
+// Host benchmark of the compressed time series blocks (src/TimeSeriesBlock.h): bytes per point and encode/decode
+// throughput, with a check that every point is decoded bit for bit.
+//
+// The trace is read from a file of JSON lines, one sample per line, as printed via Serial without a network or
+// published on <prefix>/<device id>/history, e.g.
+//   mosquitto_sub -h <broker> -t 'homeassistant/+/history' > trace.jsonl
+//   python3 scripts/fufarm_serial.py /dev/ttyACM0 > trace.jsonl
+// Samples without a "time" are assumed to be taken every SAMPLE_SECONDS. Without a file, a synthetic week of
+// samples is generated instead, so the numbers then only give an idea.
+//
+//   g++ -O2 -std=gnu++17 -Isrc scripts/timeseries_benchmark.cpp src/TimeSeriesBlock.cpp -o timeseries_benchmark
+//   ./timeseries_benchmark [trace.jsonl]
+
+#include "TimeSeriesBlock.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define SAMPLE_SECONDS 60
+#define ITERATIONS 20
+
+struct Series
+{
+  std::vector<uint32_t> times;
+  std::vector<float> values;
+};
+
+// Reads the members of a flat JSON object, numbers, booleans and null (NaN), there is no nesting in the samples
+static bool parseLine(const char *line, std::map<std::string, double> &members)
+{
+  const char *p = strchr(line, '{');
+  if (!p)
+  {
+    return false;
+  }
+  members.clear();
+  while ((p = strchr(p, '"')))
+  {
+    const char *end = strchr(p + 1, '"');
+    if (!end || end[1] != ':')
+    {
+      return false;
+    }
+    std::string key(p + 1, end - p - 1);
+    p = end + 2;
+    if (!strncmp(p, "null", 4))
+    {
+      members[key] = NAN;
+    }
+    else if (!strncmp(p, "true", 4) || !strncmp(p, "false", 5))
+    {
+      members[key] = *p == 't';
+    }
+    else
+    {
+      char *parsed;
+      members[key] = strtod(p, &parsed);
+      if (parsed == p)
+      {
+        return false; // e.g. a string, not a sample
+      }
+    }
+  }
+  return !members.empty();
+}
+
+static std::map<std::string, Series> readTrace(const char *path)
+{
+  std::map<std::string, Series> series;
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    perror(path);
+    exit(1);
+  }
+
+  char line[4096];
+  std::map<std::string, double> members;
+  uint32_t time = 0;
+  while (fgets(line, sizeof(line), file))
+  {
+    // the answers to the commands of the serial link only carry its settings
+    if (!parseLine(line, members) || members.count("baud") || members.count("format"))
+    {
+      continue;
+    }
+    auto t = members.find("time");
+    time = t != members.end() ? (uint32_t)t->second : time + SAMPLE_SECONDS;
+    for (auto &member : members)
+    {
+      if (member.first != "time")
+      {
+        series[member.first].times.push_back(time);
+        series[member.first].values.push_back((float)member.second);
+      }
+    }
+  }
+  fclose(file);
+  return series;
+}
+
+// A week of one minute samples that roughly behave like the sensors: slow cycles, noise at the resolution of
+// the sensor, a little jitter on the time and the odd missing value
+static std::map<std::string, Series> syntheticTrace()
+{
+  std::map<std::string, Series> series;
+  std::mt19937 rng(42);
+  std::normal_distribution<float> noise(0, 1);
+  std::uniform_int_distribution<int> jitter(-1, 1), missing(0, 999);
+
+  uint32_t time = 1735689600; // 2025-01-01
+  for (int i = 0; i < 7 * 24 * 60; i++)
+  {
+    time += SAMPLE_SECONDS + (i % 17 == 0 ? jitter(rng) : 0);
+    float day = sinf(2 * M_PI * (time % 86400) / 86400.0f);
+    auto add = [&](const char *key, float value) {
+      series[key].times.push_back(time);
+      series[key].values.push_back(missing(rng) ? value : NAN);
+    };
+    add("tempair", roundf((22 + 3 * day + 0.05f * noise(rng)) * 100) / 100);
+    add("humidity", roundf((60 - 10 * day + 0.2f * noise(rng)) * 100) / 100);
+    add("tempwet", roundf((20 + day + 0.02f * noise(rng)) * 16) / 16); // DS18S20 resolution
+    add("ph", roundf((6.2f + 0.01f * (i / 1440) + 0.02f * noise(rng)) * 100) / 100);
+    add("ec", roundf((1.8f - 0.02f * (i / 1440) + 0.01f * noise(rng)) * 100) / 100);
+    add("light", day > 0 ? roundf(800 * day + 5 * noise(rng)) : 0);
+    add("co2", roundf(450 + 50 * day + 3 * noise(rng)));
+    add("water_level", i % 2000 < 1900);
+  }
+  return series;
+}
+
+// Encodes a series into as many blocks as needed, returns the bytes used
+static size_t encode(const Series &series, std::vector<std::vector<uint8_t>> &blocks)
+{
+  blocks.clear();
+  size_t bytes = 0;
+  size_t i = 0;
+  while (i < series.times.size())
+  {
+    blocks.emplace_back(TIME_SERIES_BLOCK_SIZE);
+    TimeSeriesEncoder encoder(blocks.back().data(), TIME_SERIES_BLOCK_SIZE);
+    while (i < series.times.size() && encoder.append(series.times[i], series.values[i]))
+    {
+      i++;
+    }
+    blocks.back().resize(encoder.size());
+    bytes += encoder.size();
+  }
+  return bytes;
+}
+
+static size_t decode(const std::vector<std::vector<uint8_t>> &blocks, const Series *expected)
+{
+  size_t points = 0;
+  for (auto &block : blocks)
+  {
+    TimeSeriesDecoder decoder(block.data(), block.size());
+    uint32_t time;
+    float value;
+    while (decoder.next(&time, &value))
+    {
+      if (expected && (time != expected->times[points] || memcmp(&value, &expected->values[points], sizeof(value))))
+      {
+        fprintf(stderr, "mismatch at point %zu\n", points);
+        exit(1);
+      }
+      points++;
+    }
+  }
+  return points;
+}
+
+int main(int argc, char **argv)
+{
+  std::map<std::string, Series> trace = argc > 1 ? readTrace(argv[1]) : syntheticTrace();
+  if (trace.empty())
+  {
+    fprintf(stderr, "no samples\n");
+    return 1;
+  }
+  printf("%s trace, blocks of %d bytes\n\n", argc > 1 ? argv[1] : "synthetic", TIME_SERIES_BLOCK_SIZE);
+  printf("%-16s %8s %8s %12s %10s\n", "series", "points", "blocks", "bytes/point", "ratio");
+
+  size_t totalPoints = 0, totalBytes = 0;
+  double encodeSeconds = 0, decodeSeconds = 0;
+  std::vector<std::vector<uint8_t>> blocks;
+  for (auto &entry : trace)
+  {
+    const Series &series = entry.second;
+    size_t bytes = encode(series, blocks);
+    if (decode(blocks, &series) != series.times.size())
+    {
+      fprintf(stderr, "%s: points lost\n", entry.first.c_str());
+      return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+      encode(series, blocks);
+    }
+    auto encoded = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+      decode(blocks, nullptr);
+    }
+    auto decoded = std::chrono::steady_clock::now();
+    encodeSeconds += std::chrono::duration<double>(encoded - started).count();
+    decodeSeconds += std::chrono::duration<double>(decoded - encoded).count();
+
+    // compared with a time and a float as they are, 8 bytes per point
+    double perPoint = (double)bytes / series.times.size();
+    printf("%-16s %8zu %8zu %12.2f %9.1fx\n", entry.first.c_str(), series.times.size(), blocks.size(), perPoint,
+           8 / perPoint);
+    totalPoints += series.times.size();
+    totalBytes += bytes;
+  }
+
+  printf("%-16s %8zu %8s %12.2f %9.1fx\n\n", "total", totalPoints, "", (double)totalBytes / totalPoints,
+         8.0 * totalPoints / totalBytes);
+  printf("encode: %.1f M points/s\n", totalPoints * ITERATIONS / encodeSeconds / 1e6);
+  printf("decode: %.1f M points/s\n", totalPoints * ITERATIONS / decodeSeconds / 1e6);
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include "AHT20Sensor.h"
+
+#define AHT20_CMD_INITIALIZE 0xBE
+#define AHT20_CMD_TRIGGER 0xAC
+#define AHT20_CMD_SOFT_RESET 0xBA
+
+#define AHT20_STATUS_BUSY 0x80
+#define AHT20_STATUS_CALIBRATED 0x08
+
+AHT20Sensor::AHT20Sensor(I2CBus &bus) : _bus(bus)
+{
+}
+
+uint8_t AHT20Sensor::begin()
+{
+  if (!_bus.probe(AHT20_I2C_ADDRESS))
+  {
+    return 1;
+  }
+
+  if ((readStatus() & AHT20_STATUS_CALIBRATED) == 0)
+  {
+    const uint8_t command[] = {AHT20_CMD_INITIALIZE, 0x08, 0x00};
+    _bus.write(AHT20_I2C_ADDRESS, command, sizeof(command));
+    delay(10); // as per datasheet
+
+    if ((readStatus() & AHT20_STATUS_CALIBRATED) == 0)
+    {
+      return 2;
+    }
+  }
+
+  return 0;
+}
+
+void AHT20Sensor::reset()
+{
+  const uint8_t command = AHT20_CMD_SOFT_RESET;
+  _bus.write(AHT20_I2C_ADDRESS, &command, 1);
+}
+
+bool AHT20Sensor::trigger()
+{
+  const uint8_t command[] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
+  return _bus.write(AHT20_I2C_ADDRESS, command, sizeof(command));
+}
+
+bool AHT20Sensor::read(float *temperature, float *humidity)
+{
+  // status, 5 bytes of data (20 bits humidity, 20 bits temperature), crc
+  uint8_t data[7];
+  if (!_bus.read(AHT20_I2C_ADDRESS, data, sizeof(data)))
+  {
+    return false;
+  }
+
+  if ((data[0] & AHT20_STATUS_BUSY) != 0 || crc8(data, 6) != data[6])
+  {
+    return false;
+  }
+
+  uint32_t rawHumidity = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
+  uint32_t rawTemperature = (((uint32_t)data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+  *humidity = rawHumidity * 100.0f / 1048576.0f;
+  *temperature = rawTemperature * 200.0f / 1048576.0f - 50.0f;
+  return true;
+}
+
+uint8_t AHT20Sensor::readStatus()
+{
+  uint8_t status;
+  if (!_bus.read(AHT20_I2C_ADDRESS, &status, 1))
+  {
+    return 0;
+  }
+  return status;
+}
+
+// CRC-8, polynomial 0x31 (x^8 + x^5 + x^4 + 1), initial value 0xFF
+uint8_t AHT20Sensor::crc8(const uint8_t *data, uint8_t length)
+{
+  uint8_t crc = 0xFF;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,64 @@
+#ifndef AHT20_SENSOR_H
+#define AHT20_SENSOR_H
+
+#include "I2CBus.h"
+
+#define AHT20_I2C_ADDRESS 0x38
+
+// Time the sensor needs to complete a measurement after it has been triggered (datasheet says 75ms)
+#define AHT20_MEASUREMENT_MILLIS 80
+
+/**
+ * Driver for the AHT20 temperature and humidity sensor.
+ * Unlike DFRobot_AHT20, triggering a measurement and reading the result are separate calls
+ * so that the 80ms conversion can overlap with other work.
+ *
+ * Inspired by https://github.com/DFRobot/DFRobot_AHT20
+ */
+class AHT20Sensor
+{
+public:
+  /**
+   * Creates a new instance of the AHT20Sensor class.
+   *
+   * @param bus The I2C bus the sensor is connected to.
+   */
+  AHT20Sensor(I2CBus &bus);
+
+  /**
+   * Initializes the sensor, loading the calibration if the sensor is not yet calibrated.
+   *
+   * @return 0 on success, 1 if the sensor did not respond, 2 if the sensor could not be calibrated.
+   */
+  uint8_t begin();
+
+  /**
+   * Performs a soft reset of the sensor. The sensor needs 20ms before it can be used again.
+   */
+  void reset();
+
+  /**
+   * Triggers a measurement. The result is available after AHT20_MEASUREMENT_MILLIS.
+   *
+   * @return true if the command was acknowledged by the sensor.
+   */
+  bool trigger();
+
+  /**
+   * Reads the result of the last triggered measurement.
+   *
+   * @param temperature Destination for the temperature in °C.
+   * @param humidity Destination for the relative humidity in %.
+   * @return true if the values were read, false if the sensor is still busy or the data is corrupted.
+   */
+  bool read(float *temperature, float *humidity);
+
+private:
+  I2CBus &_bus;
+
+private:
+  uint8_t readStatus();
+  static uint8_t crc8(const uint8_t *data, uint8_t length);
+};
+
+#endif // AHT20_SENSOR_H
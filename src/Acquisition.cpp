@@ -0,0 +1,119 @@
+#include "Acquisition.h"
+
+AcquisitionEngine::AcquisitionEngine(uint32_t timeoutMs)
+    : _count(0), _active(false), _pending(0), _timeoutMs(timeoutMs), _startedAt(0),
+      _serialDuration(0), _timeouts(0), _lastDuration(0), _lastSerialDuration(0), _lastTimeouts(0)
+{
+}
+
+bool AcquisitionEngine::add(AcquisitionTask *task)
+{
+  if (task == nullptr || _count >= ACQUISITION_MAX_TASKS)
+  {
+    return false;
+  }
+
+  _tasks[_count++] = task;
+  return true;
+}
+
+void AcquisitionEngine::start(uint32_t now)
+{
+  if (_active)
+  {
+    return;
+  }
+
+  _active = true;
+  _pending = 0;
+  _startedAt = now;
+  _serialDuration = 0;
+  _timeouts = 0;
+
+  // Kick off every conversion before collecting any of them so that they overlap
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    int32_t wait = _tasks[i]->start(now);
+    if (wait >= 0)
+    {
+      _dueAt[i] = now + (uint32_t)wait;
+      _pending |= (1 << i);
+    }
+  }
+}
+
+bool AcquisitionEngine::poll(uint32_t now)
+{
+  if (!_active)
+  {
+    return false;
+  }
+
+  bool timedOut = (now - _startedAt) >= _timeoutMs;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if ((_pending & (1 << i)) == 0)
+    {
+      continue;
+    }
+
+    // subtraction keeps the comparison correct when millis() wraps around
+    if ((int32_t)(now - _dueAt[i]) >= 0 && _tasks[i]->collect(now))
+    {
+      complete(i, now);
+    }
+    else if (timedOut)
+    {
+      _tasks[i]->abort();
+      _timeouts++;
+      complete(i, now);
+    }
+  }
+
+  if (_pending != 0)
+  {
+    return false;
+  }
+
+  _active = false;
+  _lastDuration = now - _startedAt;
+  _lastSerialDuration = _serialDuration;
+  _lastTimeouts = _timeouts;
+  return true;
+}
+
+uint32_t AcquisitionEngine::nextDueIn(uint32_t now) const
+{
+  if (!_active)
+  {
+    return UINT32_MAX;
+  }
+
+  uint32_t next = UINT32_MAX;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if ((_pending & (1 << i)) == 0)
+    {
+      continue;
+    }
+
+    int32_t remaining = (int32_t)(_dueAt[i] - now);
+    if (remaining <= 0)
+    {
+      return 0;
+    }
+    if ((uint32_t)remaining < next)
+    {
+      next = remaining;
+    }
+  }
+
+  // all tasks have been started, just not collected (e.g. completing on the next poll)
+  return next == UINT32_MAX ? 0 : next;
+}
+
+void AcquisitionEngine::complete(uint8_t index, uint32_t now)
+{
+  _pending &= ~(1 << index);
+  _serialDuration += now - _startedAt;
+}
@@ -0,0 +1,159 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include <stdint.h>
+
+// Maximum number of tasks that can be registered with a single engine
+#define ACQUISITION_MAX_TASKS 8
+
+/**
+ * A measurement that is split into two phases: start (trigger the conversion) and collect (fetch the result).
+ * Neither phase should block so that the conversions of several devices can be in flight at the same time.
+ *
+ * This file does not depend on Arduino so that the engine can be built and exercised on the host with fake tasks.
+ */
+class AcquisitionTask
+{
+public:
+  virtual ~AcquisitionTask() {}
+
+  /**
+   * Triggers the measurement.
+   *
+   * @param now The current time in milliseconds.
+   * @return The number of milliseconds until the result is expected to be ready or a negative value if the
+   * measurement could not be started (the task is then considered complete).
+   */
+  virtual int32_t start(uint32_t now) = 0;
+
+  /**
+   * Collects the result of the measurement.
+   *
+   * @param now The current time in milliseconds.
+   * @return true if the task is complete, false if the device is still busy and should be polled again.
+   */
+  virtual bool collect(uint32_t now) = 0;
+
+  /**
+   * Called when the task did not complete before the engine timed out.
+   * Implementations should mark their result as invalid.
+   */
+  virtual void abort() {}
+};
+
+/**
+ * Adapter that maps the two phases of a task to member functions of an existing class.
+ * This allows a class such as FuFarmSensors to keep the logic of each device in its own methods.
+ */
+template <class T>
+class AcquisitionMethodTask : public AcquisitionTask
+{
+public:
+  typedef int32_t (T::*StartMethod)(uint32_t now);
+  typedef bool (T::*CollectMethod)(uint32_t now);
+  typedef void (T::*AbortMethod)();
+
+  AcquisitionMethodTask(T *owner, StartMethod start, CollectMethod collect, AbortMethod abort = nullptr)
+      : _owner(owner), _start(start), _collect(collect), _abort(abort) {}
+
+  int32_t start(uint32_t now) override { return (_owner->*_start)(now); }
+  bool collect(uint32_t now) override { return (_owner->*_collect)(now); }
+  void abort() override
+  {
+    if (_abort)
+    {
+      (_owner->*_abort)();
+    }
+  }
+
+private:
+  T *_owner;
+  StartMethod _start;
+  CollectMethod _collect;
+  AbortMethod _abort;
+};
+
+/**
+ * Runs registered tasks in split-phase fashion.
+ * All tasks are started together and each one is collected as soon as it is due, so a cycle takes
+ * as long as the slowest conversion rather than the sum of all of them.
+ */
+class AcquisitionEngine
+{
+public:
+  /**
+   * Creates a new instance of the AcquisitionEngine class.
+   *
+   * @param timeoutMs The maximum duration of a cycle in milliseconds after which pending tasks are aborted.
+   */
+  AcquisitionEngine(uint32_t timeoutMs);
+
+  /**
+   * Registers a task. Tasks are started in the order they are registered.
+   *
+   * @param task The task to register. It must outlive the engine.
+   * @return true if the task was registered, false if there is no more room.
+   */
+  bool add(AcquisitionTask *task);
+
+  /**
+   * Starts a new cycle. Nothing happens if a cycle is already in progress.
+   *
+   * @param now The current time in milliseconds.
+   */
+  void start(uint32_t now);
+
+  /**
+   * Collects the tasks that are due. This should be called frequently while a cycle is in progress.
+   *
+   * @param now The current time in milliseconds.
+   * @return true exactly once per cycle, when the last pending task completes.
+   */
+  bool poll(uint32_t now);
+
+  /**
+   * Returns true if a cycle is in progress.
+   */
+  inline bool busy() const { return _active; }
+
+  /**
+   * Returns the number of milliseconds until the next pending task is due or 0 if one is already due.
+   * When no cycle is in progress, UINT32_MAX is returned.
+   */
+  uint32_t nextDueIn(uint32_t now) const;
+
+  /**
+   * Returns the duration in milliseconds of the last completed cycle.
+   */
+  inline uint32_t lastDuration() const { return _lastDuration; }
+
+  /**
+   * Returns the sum in milliseconds of the individual task durations of the last completed cycle.
+   * This is how long the cycle would have taken if the tasks were run one after another.
+   */
+  inline uint32_t lastSerialDuration() const { return _lastSerialDuration; }
+
+  /**
+   * Returns the number of tasks that were aborted in the last completed cycle.
+   */
+  inline uint8_t lastTimeouts() const { return _lastTimeouts; }
+
+private:
+  AcquisitionTask *_tasks[ACQUISITION_MAX_TASKS];
+  uint32_t _dueAt[ACQUISITION_MAX_TASKS];
+  uint8_t _count;
+  bool _active;
+  uint16_t _pending; // bit per task
+  uint32_t _timeoutMs;
+  uint32_t _startedAt;
+  uint32_t _serialDuration;
+  uint8_t _timeouts;
+  uint32_t _lastDuration;
+  uint32_t _lastSerialDuration;
+  uint8_t _lastTimeouts;
+
+private:
+  void complete(uint8_t index, uint32_t now);
+};
+
+#endif // ACQUISITION_H
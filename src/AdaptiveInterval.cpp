@@ -0,0 +1,43 @@
+#include "AdaptiveInterval.h"
+
+#include <math.h>
+
+AdaptiveInterval::AdaptiveInterval(uint32_t baseMs, uint32_t minMs, uint32_t maxMs, uint8_t quietSamples)
+    : _base(baseMs), _min(minMs), _max(maxMs), _interval(baseMs), _quietSamples(quietSamples), _quiet(0)
+{
+  if (_interval < _min)
+  {
+    _interval = _min;
+  }
+  if (_interval > _max)
+  {
+    _interval = _max;
+  }
+}
+
+bool AdaptiveInterval::exceeds(float previous, float value, float deadband, uint32_t elapsedMs) const
+{
+  if (deadband <= 0 || elapsedMs == 0)
+  {
+    return false;
+  }
+  // compared as rates so that the threshold does not depend on the current interval
+  return fabsf(value - previous) * _base > deadband * elapsedMs;
+}
+
+uint32_t AdaptiveInterval::update(bool moving)
+{
+  if (moving)
+  {
+    _quiet = 0;
+    _interval = _interval / 2 > _min ? _interval / 2 : _min;
+    return _interval;
+  }
+
+  if (++_quiet >= _quietSamples)
+  {
+    _quiet = 0;
+    _interval = _interval > _max / 2 ? _max : _interval * 2;
+  }
+  return _interval;
+}
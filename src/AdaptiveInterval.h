@@ -0,0 +1,62 @@
+#ifndef ADAPTIVE_INTERVAL_H
+#define ADAPTIVE_INTERVAL_H
+
+#include <stdint.h>
+
+/**
+ * An interval that tightens while a signal moves and relaxes while it is quiet, within bounds.
+ *
+ * The interval is halved as soon as a sample is reported as volatile, so a fast change (e.g. a dosing event or a
+ * pump cycle) is followed closely within a few samples. It is only doubled after a number of quiet samples in a
+ * row, so it does not bounce between two intervals on a signal that moves now and then.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class AdaptiveInterval
+{
+public:
+  /**
+   * Creates a new instance of the AdaptiveInterval class.
+   *
+   * @param baseMs The interval to start with, and the one the rates of change are measured against.
+   * @param minMs The shortest interval.
+   * @param maxMs The longest interval.
+   * @param quietSamples The number of quiet samples in a row after which the interval is relaxed.
+   */
+  AdaptiveInterval(uint32_t baseMs, uint32_t minMs, uint32_t maxMs, uint8_t quietSamples);
+
+  /**
+   * Returns true if a value changed faster than a deadband per base interval, e.g. faster than 0.1 °C per minute
+   * for a temperature with a 0.1 °C deadband sampled every minute by default.
+   * A value without a deadband (e.g. an index that is published on every change) never counts as moving.
+   *
+   * @param previous The previous value.
+   * @param value The value.
+   * @param deadband The smallest change worth reporting, in the unit of the value.
+   * @param elapsedMs The time between both values.
+   */
+  bool exceeds(float previous, float value, float deadband, uint32_t elapsedMs) const;
+
+  /**
+   * Tightens or relaxes the interval after a sample.
+   *
+   * @param moving true if any value of the sample moved, see exceeds().
+   * @return The new interval.
+   */
+  uint32_t update(bool moving);
+
+  /**
+   * Returns the current interval.
+   */
+  inline uint32_t interval() const { return _interval; }
+
+private:
+  uint32_t _base;
+  uint32_t _min;
+  uint32_t _max;
+  uint32_t _interval;
+  uint8_t _quietSamples;
+  uint8_t _quiet; // samples in a row without a change
+};
+
+#endif // ADAPTIVE_INTERVAL_H
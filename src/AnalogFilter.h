@@ -0,0 +1,107 @@
+#ifndef ANALOG_FILTER_H
+#define ANALOG_FILTER_H
+
+#include <stdint.h>
+
+// The filter kernels are pure functions without Arduino dependencies so that they can be benchmarked and
+// checked for accuracy on the host.
+
+/**
+ * Result of reducing a set of ADC samples.
+ */
+struct AnalogReading
+{
+  // filtered value, in the unit of the samples (e.g. mV)
+  float value;
+
+  // variance of the samples that were kept, in the unit of the samples squared
+  float variance;
+
+  // number of samples the value was computed from (0 means the value is invalid)
+  uint16_t count;
+};
+
+/**
+ * Sorts samples in ascending order, in place.
+ * Insertion sort is used because the bursts are small (tens of samples) and often nearly sorted,
+ * for which it beats the general purpose algorithms and needs no extra memory.
+ *
+ * @param values The samples to sort.
+ * @param count The number of samples.
+ */
+inline void analogSort(uint16_t *values, uint16_t count)
+{
+  for (uint16_t i = 1; i < count; i++)
+  {
+    uint16_t value = values[i];
+    uint16_t j = i;
+    while (j > 0 && values[j - 1] > value)
+    {
+      values[j] = values[j - 1];
+      j--;
+    }
+    values[j] = value;
+  }
+}
+
+/**
+ * Computes the median of the samples. The samples are sorted in place.
+ *
+ * @param values The samples.
+ * @param count The number of samples, must be greater than zero.
+ */
+inline float analogMedian(uint16_t *values, uint16_t count)
+{
+  analogSort(values, count);
+  uint16_t middle = count / 2;
+  return (count & 1) ? values[middle] : (values[middle - 1] + values[middle]) / 2.0f;
+}
+
+/**
+ * Computes the trimmed mean and variance of the samples.
+ * The lowest and highest samples are discarded which removes the spikes the ESP32 ADC is known for,
+ * then the remaining samples are averaged which reduces the noise. The samples are sorted in place.
+ *
+ * @param values The samples.
+ * @param count The number of samples.
+ * @param trimPercent The percentage of samples to discard at each end (0 for a plain mean, 50 for the median).
+ */
+inline AnalogReading analogTrimmedMean(uint16_t *values, uint16_t count, uint8_t trimPercent)
+{
+  AnalogReading result = {0, 0, 0};
+  if (count == 0)
+  {
+    return result;
+  }
+
+  if (trimPercent >= 50)
+  {
+    result.value = analogMedian(values, count);
+    result.count = count;
+    return result;
+  }
+
+  analogSort(values, count);
+  uint16_t trim = (uint32_t)count * trimPercent / 100;
+  const uint16_t *kept = values + trim;
+  uint16_t keptCount = count - 2 * trim;
+
+  // integer sums are exact (12-bit samples), the variance uses the offset from the
+  // first kept sample to avoid the cancellation of the naive sum of squares formula
+  uint32_t sum = 0;
+  uint64_t sumSquares = 0;
+  for (uint16_t i = 0; i < keptCount; i++)
+  {
+    uint32_t offset = kept[i] - kept[0];
+    sum += offset;
+    sumSquares += offset * offset;
+  }
+
+  float mean = (float)sum / keptCount;
+  result.value = kept[0] + mean;
+  result.variance = (float)sumSquares / keptCount - mean * mean;
+  result.count = keptCount;
+  return result;
+}
+
+#endif // ANALOG_FILTER_H
@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include "AnalogSampler.h"
+
+AnalogSampler::AnalogSampler(uint32_t windowMs)
+    : _count(0), _windowMs(windowMs), _lastBurst(0)
+{
+}
+
+uint8_t AnalogSampler::addChannel(uint8_t pin, bool milliVolts)
+{
+  Channel *channel = &_channels[_count];
+  channel->pin = pin;
+  channel->milliVolts = milliVolts;
+  channel->count = 0;
+  channel->next = 0;
+  return _count++;
+}
+
+void AnalogSampler::begin()
+{
+  // A first burst so that a read straight after boot has samples. It is taken before the task is created,
+  // the ring must only ever have one producer at a time.
+  _lastBurst = millis();
+  for (uint8_t i = 0; i < ANALOG_SAMPLES_PER_BURST; i++)
+  {
+    produce(_lastBurst);
+  }
+
+#if ANALOG_SAMPLER_TASK
+  // The task only reads the ADC and pushes to the ring, a small stack is enough.
+  // It runs above the loop priority so that the sample spacing is not affected by the network.
+  xTaskCreate(task, "analog", 2048, this, ANALOG_SAMPLER_TASK_PRIORITY, nullptr);
+#endif
+}
+
+void AnalogSampler::maintain(uint32_t now)
+{
+#if ANALOG_SAMPLER_TASK
+  (void)now; // the task takes the samples
+#else
+  if ((now - _lastBurst) >= _windowMs / ANALOG_BURSTS_PER_WINDOW)
+  {
+    _lastBurst = now;
+    for (uint8_t i = 0; i < ANALOG_SAMPLES_PER_BURST; i++)
+    {
+      produce(now);
+    }
+  }
+#endif
+
+  drain();
+}
+
+AnalogReading AnalogSampler::reduce(uint8_t channel)
+{
+  drain();
+
+  // the ADC is only read by the producer, a channel without samples gives an invalid reading (count 0)
+  Channel *ch = &_channels[channel];
+  AnalogReading reading = analogTrimmedMean(ch->samples, ch->count, ANALOG_TRIM_PERCENT);
+  ch->count = 0;
+  ch->next = 0;
+  return reading;
+}
+
+uint16_t AnalogSampler::read(const Channel *channel)
+{
+  return channel->milliVolts ? analogReadMilliVolts(channel->pin) : analogRead(channel->pin);
+}
+
+void AnalogSampler::produce(uint32_t now)
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    AnalogSample sample = {now, read(&_channels[i]), i};
+    _ring.push(sample);
+  }
+}
+
+void AnalogSampler::drain()
+{
+  AnalogSample sample;
+  while (_ring.pop(&sample))
+  {
+    store(&_channels[sample.channel], sample.value);
+  }
+}
+
+void AnalogSampler::store(Channel *channel, uint16_t value)
+{
+  // When the window is longer than expected (e.g. reduce() was not called), the oldest samples are overwritten.
+  // The order does not matter because the samples are sorted when reduced.
+  channel->samples[channel->next] = value;
+  channel->next = (channel->next + 1) % ANALOG_SAMPLES_PER_WINDOW;
+  if (channel->count < ANALOG_SAMPLES_PER_WINDOW)
+  {
+    channel->count++;
+  }
+}
+
+#if ANALOG_SAMPLER_TASK
+void AnalogSampler::task(void *param)
+{
+  AnalogSampler *sampler = static_cast<AnalogSampler *>(param);
+
+  // Delaying until the next period (rather than for a period) keeps the spacing regular
+  const TickType_t period = pdMS_TO_TICKS(sampler->_windowMs / ANALOG_SAMPLES_PER_WINDOW);
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;)
+  {
+    sampler->produce(millis());
+    vTaskDelayUntil(&lastWake, period);
+  }
+}
+#endif
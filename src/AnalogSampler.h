@@ -0,0 +1,112 @@
+#ifndef ANALOG_SAMPLER_H
+#define ANALOG_SAMPLER_H
+
+#include <stdint.h>
+#include "config.h"
+#include "AnalogFilter.h"
+#include "RingBuffer.h"
+
+// The maximum number of analog channels that can be sampled
+#define ANALOG_MAX_CHANNELS 5
+
+// The number of samples kept per channel for a window
+#define ANALOG_SAMPLES_PER_WINDOW (ANALOG_SAMPLES_PER_BURST * ANALOG_BURSTS_PER_WINDOW)
+
+/**
+ * A single ADC sample as produced by the sampler.
+ */
+struct AnalogSample
+{
+  // time at which the sample was taken (ms)
+  uint32_t timestamp;
+
+  // millivolts or raw ADC value depending on the channel
+  uint16_t value;
+
+  // index of the channel
+  uint8_t channel;
+};
+
+/**
+ * Oversamples the analog channels across the sample window.
+ *
+ * Samples are produced into a lock-free ring buffer and drained by the main loop into per-channel buffers.
+ * With ANALOG_SAMPLER_TASK, a background task produces one sample per channel at regular intervals so that
+ * ANALOG_SAMPLES_PER_WINDOW samples are evenly spread across the window. Otherwise, maintain() produces
+ * a burst of ANALOG_SAMPLES_PER_BURST samples ANALOG_BURSTS_PER_WINDOW times per window.
+ * When the window closes, the samples of each channel are reduced to a trimmed mean along with their variance.
+ */
+class AnalogSampler
+{
+public:
+  /**
+   * Creates a new instance of the AnalogSampler class.
+   *
+   * @param windowMs The duration of the sample window in milliseconds.
+   */
+  AnalogSampler(uint32_t windowMs);
+
+  /**
+   * Registers a channel. Channels must be registered before begin() is called.
+   *
+   * @param pin The pin to sample.
+   * @param milliVolts true to sample in millivolts (analogReadMilliVolts), false for raw values (analogRead).
+   * @return The index of the channel to use with reduce().
+   */
+  uint8_t addChannel(uint8_t pin, bool milliVolts = true);
+
+  /**
+   * Starts sampling with a first burst, then creates the background task if enabled.
+   */
+  void begin();
+
+  /**
+   * Moves the samples produced so far out of the ring buffer (and takes a burst of samples if one is due when
+   * there is no background task). This should be called periodically inside the main loop of the firmware.
+   *
+   * @param now The current time in milliseconds.
+   */
+  void maintain(uint32_t now);
+
+  /**
+   * Reduces the samples collected for a channel since the last call and starts collecting afresh.
+   * The ADC is not read here, only the samples produced by the task (or maintain()) are used.
+   *
+   * @param channel The index of the channel returned by addChannel().
+   * @return The filtered value and the variance of the samples, with a count of 0 if none were collected since
+   * the last call.
+   */
+  AnalogReading reduce(uint8_t channel);
+
+  /**
+   * Returns the number of samples lost because the ring buffer was not drained in time.
+   */
+  inline uint32_t dropped() const { return _ring.dropped(); }
+
+private:
+  struct Channel
+  {
+    uint8_t pin;
+    bool milliVolts;
+    uint16_t count;
+    uint16_t next; // the buffer wraps around, keeping the most recent samples
+    uint16_t samples[ANALOG_SAMPLES_PER_WINDOW];
+  };
+
+  Channel _channels[ANALOG_MAX_CHANNELS];
+  uint8_t _count;
+  RingBuffer<AnalogSample, ANALOG_RING_CAPACITY> _ring;
+  uint32_t _windowMs;
+  uint32_t _lastBurst;
+
+private:
+  uint16_t read(const Channel *channel);
+  void produce(uint32_t now);
+  void drain();
+  void store(Channel *channel, uint16_t value);
+#if ANALOG_SAMPLER_TASK
+  static void task(void *param);
+#endif
+};
+
+#endif // ANALOG_SAMPLER_H
@@ -0,0 +1,40 @@
+#include "BootTimeline.h"
+
+BootTimeline::BootTimeline() : _reached(0)
+{
+  for (uint8_t i = 0; i < BOOT_PHASES; i++)
+  {
+    _at[i] = 0;
+  }
+}
+
+bool BootTimeline::mark(BootPhase phase, uint32_t now)
+{
+  if (reached(phase))
+  {
+    return false;
+  }
+
+  _at[phase] = now;
+  _reached |= (uint8_t)(1U << phase);
+  return true;
+}
+
+const char *BootTimeline::name(BootPhase phase)
+{
+  switch (phase)
+  {
+  case BOOT_SENSORS:
+    return "sensors";
+  case BOOT_NETWORK:
+    return "network";
+  case BOOT_BROKER:
+    return "broker";
+  case BOOT_MQTT:
+    return "mqtt";
+  case BOOT_FIRST_PUBLISH:
+    return "first publish";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+enum BootPhase
+{
+  BOOT_SENSORS,       // the sensors were initialised
+  BOOT_NETWORK,       // connected with an IP address
+  BOOT_BROKER,        // the endpoint of the broker is known, from the configuration, the cache or discovery
+  BOOT_MQTT,          // connected to the broker
+  BOOT_FIRST_PUBLISH, // the first sample was published
+  BOOT_PHASES,
+};
+
+/**
+ * Records when each phase of the boot was first reached so that the time to the first publish can be measured
+ * and the slow phases found. The phases may be reached in any order, e.g. the broker may be known before the network.
+ *
+ * This file does not depend on Arduino so that it can be used on the host; the time is passed in.
+ */
+class BootTimeline
+{
+public:
+  /**
+   * Creates a new instance of the BootTimeline class, no phase has been reached.
+   */
+  BootTimeline();
+
+  /**
+   * Records that a phase was reached, only the first time counts.
+   *
+   * @param phase The phase.
+   * @param now The time since boot in milliseconds.
+   * @return true if the phase had not been reached before.
+   */
+  bool mark(BootPhase phase, uint32_t now);
+
+  /**
+   * Returns true if the phase has been reached.
+   */
+  inline bool reached(BootPhase phase) const { return _reached & (1U << phase); }
+
+  /**
+   * Returns the time since boot in milliseconds at which the phase was reached, 0 if it was not.
+   */
+  inline uint32_t at(BootPhase phase) const { return _at[phase]; }
+
+  /**
+   * Returns the name of a phase, e.g. for logging.
+   */
+  static const char *name(BootPhase phase);
+
+private:
+  uint32_t _at[BOOT_PHASES];
+  uint8_t _reached; // a bit per phase
+};
+
+#endif // BOOT_TIMELINE_H
@@ -0,0 +1,113 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <stdint.h>
+#include <mutex>
+
+/**
+ * What to do when an item is pushed to a full queue.
+ */
+enum BoundedQueuePolicy
+{
+  // The oldest item is discarded to make room, the queue always holds the most recent items
+  DROP_OLDEST,
+
+  // The newest item is replaced, the queue holds the oldest unsent items plus the latest one
+  COALESCE,
+};
+
+/**
+ * Fixed capacity queue that can be shared between tasks (or threads on the host).
+ * Back-pressure is explicit: pushing never blocks or fails, the policy decides which item is lost when full.
+ *
+ * This file does not depend on Arduino so that it can be built and tested on the host with std::thread.
+ *
+ * @tparam T The type of the items, copied in and out.
+ * @tparam Capacity The maximum number of items held.
+ */
+template <typename T, uint8_t Capacity>
+class BoundedQueue
+{
+public:
+  /**
+   * Creates a new instance of the BoundedQueue class.
+   *
+   * @param policy What to do when an item is pushed to a full queue.
+   */
+  BoundedQueue(BoundedQueuePolicy policy) : _policy(policy), _head(0), _count(0), _dropped(0) {}
+
+  /**
+   * Adds an item, applying the policy if the queue is full.
+   *
+   * @return true if the item was added without losing another one.
+   */
+  bool push(const T &item)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count < Capacity)
+    {
+      _items[(_head + _count) % Capacity] = item;
+      _count++;
+      return true;
+    }
+
+    _dropped++;
+    if (_policy == DROP_OLDEST)
+    {
+      _items[_head] = item; // the oldest slot becomes the newest
+      _head = (_head + 1) % Capacity;
+    }
+    else
+    {
+      _items[(_head + Capacity - 1) % Capacity] = item;
+    }
+    return false;
+  }
+
+  /**
+   * Removes the oldest item.
+   *
+   * @return true if an item was removed, false if the queue is empty.
+   */
+  bool pop(T *item)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count == 0)
+    {
+      return false;
+    }
+
+    *item = _items[_head];
+    _head = (_head + 1) % Capacity;
+    _count--;
+    return true;
+  }
+
+  /**
+   * Returns the number of items in the queue.
+   */
+  uint8_t size()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+  }
+
+  /**
+   * Returns the number of items lost (dropped or coalesced) because the queue was full.
+   */
+  uint32_t dropped()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _dropped;
+  }
+
+private:
+  std::mutex _mutex;
+  BoundedQueuePolicy _policy;
+  T _items[Capacity];
+  uint8_t _head;
+  uint8_t _count;
+  uint32_t _dropped;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include "DS18S20Bus.h"
+
+#define DS18S20_FAMILY_CODE 0x10
+#define DS18B20_FAMILY_CODE 0x28
+
+#define DS18S20_CMD_CONVERT 0x44
+#define DS18S20_CMD_READ_SCRATCHPAD 0xBE
+#define DS18S20_CMD_READ_POWER_SUPPLY 0xB4
+
+DS18S20Bus::DS18S20Bus(OneWire &wire) : _wire(wire), _count(0), _enumerated(false), _enumeratedAt(0), _parasite(true)
+{
+}
+
+uint8_t DS18S20Bus::enumerate()
+{
+  uint8_t address[8];
+
+  _count = 0;
+  _wire.reset_search();
+  while (_count < SENSORS_DS18S20_MAX_PROBES && _wire.search(address))
+  {
+    if (OneWire::crc8(address, 7) != address[7])
+    {
+      continue;
+    }
+
+    if (address[0] != DS18S20_FAMILY_CODE && address[0] != DS18B20_FAMILY_CODE)
+    {
+      continue;
+    }
+
+    memcpy(_addresses[_count++], address, sizeof(address));
+  }
+  _wire.reset_search();
+
+  _parasite = _count > 0 && readPowerSupply();
+  _enumerated = true;
+  _enumeratedAt = millis();
+  return _count;
+}
+
+int32_t DS18S20Bus::startConversion()
+{
+  if (_count == 0 || !_wire.reset())
+  {
+    // no presence pulse, the probes may have been disconnected
+    _enumerated = false;
+    return -1;
+  }
+
+  _wire.skip(); // address all the probes at once
+  _wire.write(DS18S20_CMD_CONVERT, _parasite ? 1 : 0); // keep the bus powered for parasite powered probes
+
+  return _parasite ? DS18S20_CONVERSION_MILLIS : DS18S20_EARLIEST_COMPLETION_MILLIS;
+}
+
+bool DS18S20Bus::conversionComplete()
+{
+  // The probes hold the bus low while converting (read slots return 0).
+  // With parasite power this cannot be checked, the caller waits for the full conversion time.
+  return _parasite || _wire.read_bit() == 1;
+}
+
+bool DS18S20Bus::readTemperature(uint8_t index, float *temperature)
+{
+  if (index >= _count || !_wire.reset())
+  {
+    _enumerated = false;
+    return false;
+  }
+
+  uint8_t data[9];
+  _wire.select(_addresses[index]);
+  _wire.write(DS18S20_CMD_READ_SCRATCHPAD);
+  _wire.read_bytes(data, sizeof(data));
+  if (OneWire::crc8(data, 8) != data[8])
+  {
+    // the other probes still answer the reset, the ROM code may be of a probe that was removed or replaced
+    _enumerated = false;
+    return false;
+  }
+
+  int16_t raw = (data[1] << 8) | data[0]; // using two's complement
+  if (_addresses[index][0] == DS18S20_FAMILY_CODE)
+  {
+    // 9-bit (0.5°C) value which is extended using COUNT_REMAIN and COUNT_PER_C as per the datasheet
+    if (data[7] == 0)
+    {
+      *temperature = raw * 0.5f;
+    }
+    else
+    {
+      *temperature = (raw >> 1) - 0.25f + (float)(data[7] - data[6]) / data[7];
+    }
+  }
+  else
+  {
+    // the undefined low bits depend on the configured resolution
+    uint8_t resolution = (data[4] >> 5) & 0x03; // 0 = 9-bit ... 3 = 12-bit
+    raw &= ~((1 << (3 - resolution)) - 1);
+    *temperature = raw / 16.0f;
+  }
+
+  return true;
+}
+
+bool DS18S20Bus::readPowerSupply()
+{
+  if (!_wire.reset())
+  {
+    return true; // assume the worst
+  }
+
+  _wire.skip();
+  _wire.write(DS18S20_CMD_READ_POWER_SUPPLY);
+  return _wire.read_bit() == 0; // parasite powered probes pull the bus low
+}
@@ -0,0 +1,92 @@
+#ifndef DS18S20_BUS_H
+#define DS18S20_BUS_H
+
+#include <OneWire.h>
+#include "config.h"
+
+// Maximum conversion time at 12-bit resolution
+#define DS18S20_CONVERSION_MILLIS 750
+
+// When the probes are not parasite powered, we check the bus for completion of the conversion from this point
+#define DS18S20_EARLIEST_COMPLETION_MILLIS 100
+
+// While fewer probes than SENSORS_DS18S20_MAX_PROBES were found, the bus is searched again this often for new ones
+#define DS18S20_SEARCH_INTERVAL_MILLIS 60000
+
+/**
+ * Driver for one or more DS18S20/DS18B20 temperature probes sharing a single 1-Wire bus.
+ *
+ * The bus is enumerated and the ROM codes are cached so that subsequent reads do not pay for a search. It is only
+ * searched again when a read fails, or periodically while there is room for more probes (see needsEnumeration()).
+ * A conversion is started on all probes at once (Skip ROM) and the scratchpad of each probe is then read,
+ * using its cached ROM code, once the conversion is complete.
+ */
+class DS18S20Bus
+{
+public:
+  /**
+   * Creates a new instance of the DS18S20Bus class.
+   *
+   * @param wire The 1-Wire bus the probes are connected to.
+   */
+  DS18S20Bus(OneWire &wire);
+
+  /**
+   * Searches the bus and caches the ROM codes of supported probes.
+   * Devices with an invalid ROM CRC or an unsupported family code are skipped.
+   *
+   * @return The number of probes found.
+   */
+  uint8_t enumerate();
+
+  /**
+   * Returns the number of probes found during the last enumeration.
+   */
+  inline uint8_t count() const { return _count; }
+
+  /**
+   * Returns true if the bus needs to be enumerated: it has never been, a read failed (e.g. a probe was removed or
+   * replaced), or there is room for more probes and DS18S20_SEARCH_INTERVAL_MILLIS passed since the last search.
+   *
+   * @param now The current time in milliseconds.
+   */
+  inline bool needsEnumeration(uint32_t now) const
+  {
+    return !_enumerated || (_count < SENSORS_DS18S20_MAX_PROBES && now - _enumeratedAt >= DS18S20_SEARCH_INTERVAL_MILLIS);
+  }
+
+  /**
+   * Starts a temperature conversion on all the probes at once.
+   *
+   * @return The number of milliseconds after which the result should be checked or a negative value if there are no probes.
+   */
+  int32_t startConversion();
+
+  /**
+   * Returns true if the conversion started last is complete.
+   * Parasite powered probes cannot be polled, the caller must wait for DS18S20_CONVERSION_MILLIS instead.
+   */
+  bool conversionComplete();
+
+  /**
+   * Reads the temperature measured by a probe during the last conversion.
+   *
+   * @param index The index of the probe, less than count().
+   * @param temperature Destination for the temperature in °C.
+   * @return true if the scratchpad was read successfully (valid CRC), false otherwise.
+   */
+  bool readTemperature(uint8_t index, float *temperature);
+
+private:
+  OneWire &_wire;
+  uint8_t _addresses[SENSORS_DS18S20_MAX_PROBES][8];
+  uint8_t _count;
+  bool _enumerated;
+  uint32_t _enumeratedAt;
+  bool _parasite;
+
+private:
+  bool readPowerSupply();
+};
+
+#endif // DS18S20_BUS_H
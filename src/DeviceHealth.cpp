@@ -0,0 +1,63 @@
+#include "DeviceHealth.h"
+
+DeviceHealth::DeviceHealth(uint32_t resetMs, uint32_t backoffMinMs, uint32_t backoffMaxMs)
+    : _state(DEVICE_RETRY), _resetMs(resetMs), _backoffMinMs(backoffMinMs), _backoffMaxMs(backoffMaxMs),
+      _backoffMs(backoffMinMs), _since(0), _wasOk(false), _retrying(false), _failures(0), _recoveries(0)
+{
+}
+
+bool DeviceHealth::tick(uint32_t now)
+{
+  switch (_state)
+  {
+  case DEVICE_RESETTING:
+    if ((now - _since) >= _resetMs)
+    {
+      _state = DEVICE_RETRY;
+    }
+    break;
+  case DEVICE_BACKOFF:
+    if ((now - _since) >= _backoffMs)
+    {
+      _state = DEVICE_RETRY;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return _state == DEVICE_RETRY;
+}
+
+void DeviceHealth::initialised(uint32_t now, bool success)
+{
+  if (success)
+  {
+    if (_wasOk)
+    {
+      _recoveries++;
+    }
+    _wasOk = true;
+    _retrying = false;
+    _state = DEVICE_OK;
+    _backoffMs = _backoffMinMs;
+    return;
+  }
+
+  // the first backoff uses the minimum, the following ones are doubled up to the maximum
+  if (_state == DEVICE_RETRY && _retrying)
+  {
+    _backoffMs = _backoffMs > _backoffMaxMs / 2 ? _backoffMaxMs : _backoffMs * 2;
+  }
+  _retrying = true;
+  _failures++;
+  _state = DEVICE_BACKOFF;
+  _since = now;
+}
+
+void DeviceHealth::failed(uint32_t now)
+{
+  _failures++;
+  _state = DEVICE_RESETTING;
+  _since = now;
+}
@@ -0,0 +1,91 @@
+#ifndef DEVICE_HEALTH_H
+#define DEVICE_HEALTH_H
+
+#include <stdint.h>
+
+enum DeviceHealthState
+{
+  DEVICE_OK,        // the device is working
+  DEVICE_RESETTING, // the device failed and was reset, waiting for it to come back
+  DEVICE_BACKOFF,   // initialising the device failed, waiting before trying again
+  DEVICE_RETRY,     // the device should be initialised (also the state before the first initialisation)
+};
+
+/**
+ * Tracks the health of a device and paces its recovery so that a failing device never blocks the firmware.
+ *
+ * When an operation fails, the owner resets the device and reports the failure. Once the device had time
+ * to reset, tick() asks the owner to initialise it again. Failed initialisations are retried with an
+ * exponential backoff. Each step is a single short operation on the device, done by the owner.
+ *
+ * This file does not depend on Arduino so that it can be used on the host; the time is passed in.
+ */
+class DeviceHealth
+{
+public:
+  /**
+   * Creates a new instance of the DeviceHealth class.
+   *
+   * @param resetMs The time in milliseconds the device needs after a reset.
+   * @param backoffMinMs The time in milliseconds to wait after the first failed initialisation.
+   * @param backoffMaxMs The maximum time in milliseconds to wait between initialisations.
+   */
+  DeviceHealth(uint32_t resetMs, uint32_t backoffMinMs, uint32_t backoffMaxMs);
+
+  /**
+   * Advances the state machine.
+   *
+   * @param now The current time in milliseconds.
+   * @return true if the owner should initialise the device now and report the result with initialised().
+   */
+  bool tick(uint32_t now);
+
+  /**
+   * Reports the result of initialising the device.
+   *
+   * @param now The current time in milliseconds.
+   * @param success true if the device was initialised.
+   */
+  void initialised(uint32_t now, bool success);
+
+  /**
+   * Reports that an operation on a working device failed. The owner should have reset the device.
+   *
+   * @param now The current time in milliseconds.
+   */
+  void failed(uint32_t now);
+
+  /**
+   * Returns true if the device is working.
+   */
+  inline bool ok() const { return _state == DEVICE_OK; }
+
+  /**
+   * Returns the current state.
+   */
+  inline DeviceHealthState state() const { return _state; }
+
+  /**
+   * Returns the number of failed operations and initialisations since boot.
+   */
+  inline uint32_t failures() const { return _failures; }
+
+  /**
+   * Returns the number of times the device came back after failing.
+   */
+  inline uint32_t recoveries() const { return _recoveries; }
+
+private:
+  DeviceHealthState _state;
+  uint32_t _resetMs;
+  uint32_t _backoffMinMs;
+  uint32_t _backoffMaxMs;
+  uint32_t _backoffMs; // current backoff, doubled on every failed initialisation
+  uint32_t _since; // when the current state was entered
+  bool _wasOk; // the device worked at some point, used to count recoveries
+  bool _retrying; // an initialisation failed since the device last worked
+  uint32_t _failures;
+  uint32_t _recoveries;
+};
+
+#endif // DEVICE_HEALTH_H
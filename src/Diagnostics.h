@@ -0,0 +1,62 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdint.h>
+
+/**
+ * Values describing the health of the device itself rather than its environment.
+ */
+struct FuFarmDiagnostics
+{
+  // how late (ms) the last sample was started compared to its deadline
+  uint32_t sampleJitter;
+
+  // the current sample window (ms), which changes with SAMPLE_ADAPTIVE
+  uint32_t sampleWindow;
+
+  // how long (ms) it took from the edge of the last water level change until it was published
+  uint32_t waterLevelLatency;
+
+  // how long (ms) the last WiFi connection took to establish and how long the last outage lasted
+  uint32_t wifiConnectTime;
+  uint32_t wifiOutage;
+
+  // time (ms) from boot until the first sample was published, 0 until then
+  uint32_t bootTime;
+
+  // number of failed reads and initialisations of the I2C sensors since boot
+  uint32_t aht20Failures;
+  uint32_t ens160Failures;
+
+  // number of failed I2C transactions since boot
+  uint32_t i2cErrors;
+
+  // time (us) spent on the I2C bus during the last read and duration of its longest transaction
+  uint32_t i2cCycleMicros;
+  uint32_t i2cMaxMicros;
+
+  // free heap and largest block that can be allocated (bytes), a growing gap between the two is fragmentation
+  uint32_t freeHeap;
+  uint32_t largestFreeBlock;
+
+  // least stack (bytes) left unused since boot by the tasks doing the work
+  uint32_t stackHeadroom;
+
+  // longest iteration (us) of the loop since the last sample, the longest of both tasks with USE_TASKS
+  uint32_t loopLatency;
+
+  // signal strength (dBm) of the WiFi connection
+  int32_t wifiSignal;
+
+  // number of times service discovery found the broker at a new address since boot
+  uint32_t discoveryUpdates;
+
+  // time (s) since boot and the reason of the last reset (an esp_reset_reason_t)
+  uint32_t uptime;
+  uint8_t resetReason;
+
+  // number of log messages dropped because the log buffer was full
+  uint32_t logDropped;
+};
+
+#endif // DIAGNOSTICS_H
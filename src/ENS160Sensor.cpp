@@ -0,0 +1,61 @@
+#include "ENS160Sensor.h"
+
+#define ENS160_REG_PART_ID 0x00 // 2 bytes
+#define ENS160_REG_OPMODE 0x10
+#define ENS160_REG_CONFIG 0x11
+#define ENS160_REG_TEMP_IN 0x13 // 2 bytes, followed by RH_IN (2 bytes)
+#define ENS160_REG_DEVICE_STATUS 0x20 // followed by DATA_AQI, DATA_TVOC (2 bytes), DATA_ECO2 (2 bytes)
+
+#define ENS160_PART_ID 0x0160
+#define ENS160_OPMODE_STANDARD 0x02
+
+ENS160Sensor::ENS160Sensor(I2CBus &bus, uint8_t address) : _bus(bus), _address(address)
+{
+}
+
+uint8_t ENS160Sensor::begin()
+{
+  uint8_t partId[2];
+  if (!_bus.readRegisters(_address, ENS160_REG_PART_ID, partId, sizeof(partId)))
+  {
+    return 1;
+  }
+  if ((partId[0] | (partId[1] << 8)) != ENS160_PART_ID)
+  {
+    return 2;
+  }
+
+  // the interrupt pin is not used
+  const uint8_t config = 0x00;
+  const uint8_t opmode = ENS160_OPMODE_STANDARD;
+  if (!_bus.writeRegisters(_address, ENS160_REG_CONFIG, &config, 1) ||
+      !_bus.writeRegisters(_address, ENS160_REG_OPMODE, &opmode, 1))
+  {
+    return 1;
+  }
+  return 0;
+}
+
+bool ENS160Sensor::setTempAndHum(float temperature, float humidity)
+{
+  // temperature in Kelvin * 64 and humidity in % * 512, little endian
+  uint16_t t = (uint16_t)((temperature + 273.15f) * 64);
+  uint16_t rh = (uint16_t)(humidity * 512);
+  const uint8_t data[] = {(uint8_t)(t & 0xFF), (uint8_t)(t >> 8), (uint8_t)(rh & 0xFF), (uint8_t)(rh >> 8)};
+  return _bus.writeRegisters(_address, ENS160_REG_TEMP_IN, data, sizeof(data));
+}
+
+bool ENS160Sensor::read(ENS160Reading *dest)
+{
+  uint8_t data[6];
+  if (!_bus.readRegisters(_address, ENS160_REG_DEVICE_STATUS, data, sizeof(data)))
+  {
+    return false;
+  }
+
+  dest->validity = (data[0] >> 2) & 0x03;
+  dest->aqi = data[1] & 0x07;
+  dest->tvoc = data[2] | (data[3] << 8);
+  dest->eco2 = data[4] | (data[5] << 8);
+  return true;
+}
@@ -0,0 +1,72 @@
+#ifndef ENS160_SENSOR_H
+#define ENS160_SENSOR_H
+
+#include "I2CBus.h"
+
+#define ENS160_I2C_ADDRESS 0x53
+
+// Values of the validity flag in the device status
+#define ENS160_VALIDITY_NORMAL 0
+#define ENS160_VALIDITY_WARM_UP 1
+#define ENS160_VALIDITY_INITIAL_START_UP 2
+#define ENS160_VALIDITY_INVALID 3
+
+/**
+ * A reading of the ENS160 as reported by the sensor.
+ */
+struct ENS160Reading
+{
+  uint8_t validity; // one of ENS160_VALIDITY_*
+  uint8_t aqi; // air quality index (UBA), 1 to 5
+  uint16_t tvoc; // ppb
+  uint16_t eco2; // ppm
+};
+
+/**
+ * Driver for the ENS160 air quality sensor.
+ * The status and all the measurements are consecutive registers and are fetched in a single transaction,
+ * where DFRobot_ENS160 uses one transaction per value.
+ *
+ * Inspired by https://github.com/DFRobot/DFRobot_ENS160
+ */
+class ENS160Sensor
+{
+public:
+  /**
+   * Creates a new instance of the ENS160Sensor class.
+   *
+   * @param bus The I2C bus the sensor is connected to.
+   * @param address The address of the sensor (0x52 or 0x53).
+   */
+  ENS160Sensor(I2CBus &bus, uint8_t address = ENS160_I2C_ADDRESS);
+
+  /**
+   * Checks the part ID and starts continuous measurements (standard mode).
+   *
+   * @return 0 on success, 1 if the sensor did not respond, 2 if the part ID is not that of an ENS160.
+   */
+  uint8_t begin();
+
+  /**
+   * Sets the ambient temperature and humidity used by the sensor for compensation, in a single transaction.
+   *
+   * @param temperature The temperature in °C.
+   * @param humidity The relative humidity in %.
+   * @return true if the sensor acknowledged the values.
+   */
+  bool setTempAndHum(float temperature, float humidity);
+
+  /**
+   * Reads the status and the measurements.
+   *
+   * @param dest The destination for the reading.
+   * @return true if the registers were read.
+   */
+  bool read(ENS160Reading *dest);
+
+private:
+  I2CBus &_bus;
+  uint8_t _address;
+};
+
+#endif // ENS160_SENSOR_H
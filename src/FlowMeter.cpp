@@ -0,0 +1,87 @@
+#include "FlowMeter.h"
+
+#ifdef HAVE_FLOW
+
+#define PREFERENCES_NAMESPACE "flow"
+#define PREFERENCES_TOTAL_KEY "pulses"
+
+FlowMeter::FlowMeter(uint32_t pulsesPerLitre)
+    : _pulsesPerLitre(pulsesPerLitre), _restored(0), _saved(0), _pulses(0), _lastPulseMicros(0), _periodMicros(0)
+{
+}
+
+void FlowMeter::begin(uint8_t pin)
+{
+  _preferences.begin(PREFERENCES_NAMESPACE, false);
+  _restored = _preferences.getULong64(PREFERENCES_TOTAL_KEY, 0);
+
+  pinMode(pin, INPUT);
+  attachInterruptArg(digitalPinToInterrupt(pin), handleInterrupt, this, RISING);
+}
+
+void IRAM_ATTR FlowMeter::handleInterrupt(void *arg)
+{
+  // Everything called from here must be in IRAM so that the handler can run while flash is busy (e.g. NVS writes).
+  // micros() is safe because it reads the esp_timer.
+  FlowMeter *meter = static_cast<FlowMeter *>(arg);
+  uint32_t now = micros();
+
+  portENTER_CRITICAL_ISR(&meter->_mux);
+  if (meter->_pulses > 0)
+  {
+    meter->_periodMicros = now - meter->_lastPulseMicros;
+  }
+  meter->_lastPulseMicros = now;
+  meter->_pulses = meter->_pulses + 1;
+  portEXIT_CRITICAL_ISR(&meter->_mux);
+}
+
+float FlowMeter::rate()
+{
+  portENTER_CRITICAL(&_mux);
+  uint32_t lastPulseMicros = _lastPulseMicros;
+  uint32_t periodMicros = _periodMicros;
+  portEXIT_CRITICAL(&_mux);
+
+  uint32_t sinceLastPulse = micros() - lastPulseMicros;
+  if (periodMicros == 0 || sinceLastPulse >= FLOW_STOPPED_MICROS)
+  {
+    return 0;
+  }
+
+  // When the flow slows down, the next pulse is late and the period of the last pulse overstates the rate.
+  // The time since the last pulse is then a better (upper) bound of the period.
+  if (sinceLastPulse > periodMicros)
+  {
+    periodMicros = sinceLastPulse;
+  }
+
+  float hertz = 1000000.0f / periodMicros;
+  return hertz * 60 / _pulsesPerLitre;
+}
+
+float FlowMeter::total()
+{
+  portENTER_CRITICAL(&_mux);
+  uint32_t pulses = _pulses;
+  portEXIT_CRITICAL(&_mux);
+
+  return (float)((double)(_restored + pulses) / _pulsesPerLitre);
+}
+
+void FlowMeter::save()
+{
+  portENTER_CRITICAL(&_mux);
+  uint32_t pulses = _pulses;
+  portEXIT_CRITICAL(&_mux);
+
+  if (pulses == _saved)
+  {
+    return;
+  }
+
+  _preferences.putULong64(PREFERENCES_TOTAL_KEY, _restored + pulses);
+  _saved = pulses;
+}
+
+#endif // HAVE_FLOW
@@ -0,0 +1,71 @@
+#ifndef FLOW_METER_H
+#define FLOW_METER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+
+#ifdef HAVE_FLOW
+
+/**
+ * Driver for a pulse output flow sensor (e.g. YF-S201).
+ *
+ * The interrupt handler counts the pulses and records when each one happened, so the flow rate can be derived
+ * from the period between the last two pulses instead of counting pulses over a whole sample window.
+ * This gives a useful reading at low flow rates where only a handful of pulses arrive per window.
+ *
+ * The pulses are also accumulated into a total volume which is kept in NVS across reboots.
+ */
+class FlowMeter
+{
+public:
+  /**
+   * Creates a new instance of the FlowMeter class.
+   *
+   * @param pulsesPerLitre The number of pulses the sensor produces per litre.
+   */
+  FlowMeter(uint32_t pulsesPerLitre);
+
+  /**
+   * Restores the total volume and attaches the interrupt handler to the pin.
+   *
+   * @param pin The pin the sensor is connected to.
+   */
+  void begin(uint8_t pin);
+
+  /**
+   * Returns the instantaneous flow rate in litres per minute, derived from the period of the last pulse.
+   * The rate decays when pulses stop arriving and drops to 0 after FLOW_STOPPED_MICROS.
+   */
+  float rate();
+
+  /**
+   * Returns the total volume in litres, including the volume restored from NVS.
+   */
+  float total();
+
+  /**
+   * Saves the total volume to NVS if it has changed since it was last saved.
+   * Flash has limited write endurance so this should not be called on every sample.
+   */
+  void save();
+
+private:
+  static void IRAM_ATTR handleInterrupt(void *arg);
+
+private:
+  uint32_t _pulsesPerLitre;
+  Preferences _preferences;
+  uint64_t _restored; // pulses counted before the last reboot
+  uint32_t _saved; // value of _pulses when the total was last saved
+
+  // written by the interrupt handler, read under _mux so that the three values are consistent
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile uint32_t _pulses;
+  volatile uint32_t _lastPulseMicros;
+  volatile uint32_t _periodMicros; // 0 until two pulses have been seen
+};
+
+#endif // HAVE_FLOW
+
+#endif // FLOW_METER_H
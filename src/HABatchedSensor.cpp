@@ -0,0 +1,69 @@
+#include "HABatchedSensor.h"
+
+#if USE_HOME_ASSISTANT
+
+// The number of properties in the discovery config
+#define HA_BATCHED_SENSOR_PROPERTIES 15
+
+HABatchedSensor::HABatchedSensor(const char *uniqueId, HASensorNumber::NumberPrecision precision)
+    : HABaseDeviceType(F("sensor"), uniqueId),
+      _deviceClass(nullptr), _stateClass(nullptr), _icon(nullptr), _unitOfMeasurement(nullptr),
+      _stateTopic(nullptr), _valueTemplate(nullptr), _attributesTopic(nullptr), _attributesTemplate(nullptr)
+{
+  _expireAfter[0] = '\0';
+  snprintf(_precision, sizeof(_precision), "%u", (unsigned int)precision);
+}
+
+void HABatchedSensor::setExpireAfter(uint16_t seconds)
+{
+  if (seconds > 0)
+  {
+    snprintf(_expireAfter, sizeof(_expireAfter), "%u", seconds);
+  }
+  else
+  {
+    _expireAfter[0] = '\0';
+  }
+}
+
+void HABatchedSensor::buildSerializer()
+{
+  if (_serializer || !uniqueId())
+  {
+    return;
+  }
+
+  // same properties as HASensor, with the shared state topic and a value template instead of a topic of its own
+  _serializer = new HASerializer(this, HA_BATCHED_SENSOR_PROPERTIES);
+  _serializer->set(F("name"), _name);
+  _serializer->set(F("obj_id"), _objectId);
+  _serializer->set(HASerializer::WithUniqueId);
+  _serializer->set(F("dev_cla"), _deviceClass);
+  _serializer->set(F("stat_cla"), _stateClass);
+  _serializer->set(F("ic"), _icon);
+  _serializer->set(F("unit_of_meas"), _unitOfMeasurement);
+  _serializer->set(F("sug_dsp_prc"), _precision);
+  if (_expireAfter[0])
+  {
+    _serializer->set(F("exp_aft"), _expireAfter);
+  }
+  _serializer->set(F("stat_t"), _stateTopic);
+  _serializer->set(F("val_tpl"), _valueTemplate);
+  _serializer->set(F("json_attr_t"), _attributesTopic);
+  _serializer->set(F("json_attr_tpl"), _attributesTemplate);
+  _serializer->set(HASerializer::WithDevice);
+  _serializer->set(HASerializer::WithAvailability);
+}
+
+void HABatchedSensor::onMqttConnected()
+{
+  if (!uniqueId())
+  {
+    return;
+  }
+
+  publishConfig();
+  publishAvailability();
+}
+
+#endif // USE_HOME_ASSISTANT
@@ -0,0 +1,79 @@
+#include "config.h"
+
+#ifndef HA_BATCHED_SENSOR_H
+#define HA_BATCHED_SENSOR_H
+
+#if USE_HOME_ASSISTANT
+
+#include <ArduinoHA.h>
+
+/**
+ * A Home Assistant sensor whose state is extracted from a JSON document shared with other sensors.
+ *
+ * The sensor does not publish anything itself after its discovery config: the owner publishes one document per
+ * sample on the shared state topic and Home Assistant applies the value template of each sensor to it.
+ * The properties mirror those of HASensor so that both can be configured the same way.
+ */
+class HABatchedSensor : public HABaseDeviceType
+{
+public:
+  /**
+   * Creates a new instance of the HABatchedSensor class.
+   *
+   * @param uniqueId The unique id of the sensor, it must remain valid for the lifetime of the sensor.
+   * @param precision The number of decimals displayed by Home Assistant.
+   */
+  HABatchedSensor(const char *uniqueId, HASensorNumber::NumberPrecision precision = HASensorNumber::PrecisionP0);
+
+  inline void setDeviceClass(const char *deviceClass) { _deviceClass = deviceClass; }
+  inline void setStateClass(const char *stateClass) { _stateClass = stateClass; }
+  inline void setIcon(const char *icon) { _icon = icon; }
+  inline void setUnitOfMeasurement(const char *unit) { _unitOfMeasurement = unit; }
+  void setExpireAfter(uint16_t seconds);
+
+  /**
+   * Sets where the state comes from.
+   *
+   * @param topic The shared state topic.
+   * @param valueTemplate The template extracting the value from the document e.g. {{ value_json.get('tempair') }}
+   */
+  inline void setState(const char *topic, const char *valueTemplate)
+  {
+    _stateTopic = topic;
+    _valueTemplate = valueTemplate;
+  }
+
+  /**
+   * Sets where the attributes come from, by default the sensor has none.
+   *
+   * @param topic The shared state topic.
+   * @param attributesTemplate The template extracting the attributes from the document, it should render a JSON
+   *                           object e.g. {{ value_json.stats.get('tempair', {}) | tojson }}
+   */
+  inline void setJsonAttributes(const char *topic, const char *attributesTemplate)
+  {
+    _attributesTopic = topic;
+    _attributesTemplate = attributesTemplate;
+  }
+
+protected:
+  void buildSerializer() override;
+  void onMqttConnected() override;
+
+private:
+  const char *_deviceClass;
+  const char *_stateClass;
+  const char *_icon;
+  const char *_unitOfMeasurement;
+  const char *_stateTopic;
+  const char *_valueTemplate;
+  const char *_attributesTopic;
+  const char *_attributesTemplate;
+  // numbers are sent as strings, which Home Assistant accepts for these properties
+  char _expireAfter[6];
+  char _precision[2];
+};
+
+#endif // USE_HOME_ASSISTANT
+
+#endif // HA_BATCHED_SENSOR_H
@@ -0,0 +1,39 @@
+#include "config.h"
+
+#ifndef HA_DIAGNOSTIC_H
+#define HA_DIAGNOSTIC_H
+
+#if USE_HOME_ASSISTANT
+
+#include <ArduinoHA.h>
+
+/**
+ * A Home Assistant entity that describes the device rather than its environment.
+ *
+ * It is announced with the diagnostic entity category, so Home Assistant lists it apart from the sensor values
+ * and leaves it out of the default dashboards. The library does not expose the category, it is added to the
+ * discovery config built by the entity (HASensor reserves room for more properties than it sets).
+ *
+ * @tparam Entity The entity type of the library, e.g. HASensorNumber or HASensor.
+ */
+template <typename Entity>
+class HADiagnostic : public Entity
+{
+public:
+  using Entity::Entity;
+
+protected:
+  void buildSerializer() override
+  {
+    bool built = this->_serializer == nullptr;
+    Entity::buildSerializer();
+    if (built && this->_serializer)
+    {
+      this->_serializer->set(F("ent_cat"), "diagnostic");
+    }
+  }
+};
+
+#endif // USE_HOME_ASSISTANT
+
+#endif // HA_DIAGNOSTIC_H
@@ -1,4 +1,8 @@
 #include "HomeAssistant.h"
+#include "SensorsJson.h"
+#include "Profiler.h"
+#include "Logger.h"
+#include <esp_system.h>
 
 #if USE_HOME_ASSISTANT
 
@@ -10,48 +14,142 @@
 #define HOME_ASSISTANT_MQTT_PASSWORD nullptr
 #endif
 
-#define EXPIRE_AFTER_SECONDS ((SAMPLE_WINDOW_MILLIS * 2) / 1000)
+#define EXPIRE_AFTER_SECONDS HOME_ASSISTANT_EXPIRE_AFTER_SECONDS
 #define SET_EXPIRE_AFTER(sensor) sensor.setExpireAfter(EXPIRE_AFTER_SECONDS)
 
-FuFarmHomeAssistant::FuFarmHomeAssistant(Client &client) :
-// The strings being passed in constructors are the sensor identifiers.
-// They should be unique for the device and are required by the library.
-// We can probably find a better source but this works for the moment.
+// The number of entities registered with HAMqtt: the values in the sensor registry (one per probe) and the diagnostics
+#define FUFARM_HA_COUNT(...) +1
+#define FUFARM_HA_COUNT_PROBES(id, field, count, max, ...) +(max)
+static const uint8_t entityCount = FUFARM_SENSORS(FUFARM_HA_COUNT, FUFARM_HA_COUNT_PROBES, FUFARM_HA_COUNT)
+    + 1 // sample jitter
+#if SAMPLE_ADAPTIVE
+    + 1 // sample window
+#endif
+    + 2 // published and suppressed messages
+    + 1 // boot time
 #ifdef HAVE_WATER_LEVEL_STATE
-  waterLevel(HOME_ASSISTANT_DEVICE_NAME"_waterLevel"),
+    + 1 // water level latency
 #endif
-#ifdef HAVE_LIGHT
-  light(HOME_ASSISTANT_DEVICE_NAME"_light"),
+#if HAVE_WIFI
+    + 2 // WiFi connect time and outage
 #endif
-#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
-  temperature(HOME_ASSISTANT_DEVICE_NAME"_temperature", HASensorNumber::PrecisionP2),
-  humidity(HOME_ASSISTANT_DEVICE_NAME"_humidity", HASensorNumber::PrecisionP2),
+#ifdef HAVE_AHT20
+    + 1 // AHT20 failures
 #endif
 #ifdef HAVE_ENS160
-  aqi(HOME_ASSISTANT_DEVICE_NAME"_aqi"),
-  tvoc(HOME_ASSISTANT_DEVICE_NAME"_tvoc"),
-  eco2(HOME_ASSISTANT_DEVICE_NAME"_eco2"),
+    + 1 // ENS160 failures
 #endif
-#ifdef HAVE_FLOW
-  flow(HOME_ASSISTANT_DEVICE_NAME"_flow", HASensorNumber::PrecisionP2),
+#ifdef HAVE_I2C
+    + 2 // I2C errors and bus time
 #endif
-#ifdef HAVE_TEMP_WET
-  liquidtemp(HOME_ASSISTANT_DEVICE_NAME"_liquidtemp", HASensorNumber::PrecisionP2),
+    + 4 // free heap, largest free block, stack headroom and loop latency
+#if HAVE_WIFI
+    + 1 // WiFi signal
 #endif
-#ifdef HAVE_CO2
-  co2(HOME_ASSISTANT_DEVICE_NAME"_co2"),
+    + 1 // MQTT reconnects
+#if NETWORK_SERVICE_DISCOVERY
+    + 1 // discovery updates
 #endif
-#ifdef HAVE_EC
-  ec(HOME_ASSISTANT_DEVICE_NAME"_ec", HASensorNumber::PrecisionP2),
+    + 3 // uptime, dropped log messages and reset reason
+    ;
+#undef FUFARM_HA_COUNT
+#undef FUFARM_HA_COUNT_PROBES
+
+// Without batching, the statistics of the window are the JSON attributes of each entity, which need the feature
+#if SENSORS_WINDOW_STATS && !HOME_ASSISTANT_BATCHED_STATE
+#define FUFARM_HA_FEATURES , HASensor::JsonAttributesFeature
+#else
+#define FUFARM_HA_FEATURES
 #endif
-#ifdef HAVE_PH
-  ph(HOME_ASSISTANT_DEVICE_NAME"_ph", HASensorNumber::PrecisionP2),
+
+// Applies the properties of a registry entry, nullptr properties are left unset
+template <class T>
+static void configure(T &sensor, const char *deviceClass, const char *unit, const char *stateClass,
+                      const char *name, const char *icon)
+{
+  if (deviceClass) sensor.setDeviceClass(deviceClass);
+  if (unit) sensor.setUnitOfMeasurement(unit);
+  if (stateClass) sensor.setStateClass(stateClass);
+  if (name) sensor.setName(name);
+  if (icon) sensor.setIcon(icon);
+  SET_EXPIRE_AFTER(sensor);
+}
+
+static void configure(HABinarySensor &sensor, const char *deviceClass, const char *name, const char *icon)
+{
+  if (deviceClass) sensor.setDeviceClass(deviceClass);
+  if (name) sensor.setName(name);
+  if (icon) sensor.setIcon(icon);
+  SET_EXPIRE_AFTER(sensor);
+}
+
+FuFarmHomeAssistant::FuFarmHomeAssistant(Client &client) :
+// The strings being passed in constructors are the sensor identifiers.
+// They should be unique for the device and are required by the library.
+// We can probably find a better source but this works for the moment.
+#define FUFARM_HA_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, ...) \
+  id(HOME_ASSISTANT_DEVICE_NAME "_" #id, HASensorNumber::precision FUFARM_HA_FEATURES),
+#define FUFARM_HA_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, ...) \
+  id(HOME_ASSISTANT_DEVICE_NAME "_" #id, HASensorNumber::precision FUFARM_HA_FEATURES),
+#define FUFARM_HA_BINARY(id, ...) id(HOME_ASSISTANT_DEVICE_NAME "_" #id),
+  FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_BINARY
+  publishedMessages(0),
+  suppressedMessages(0),
+  wasConnected(false),
+  resync(false),
+  mqttConnections(0),
+  healthMillis(0),
+  healthDue(true),
+  sampleJitter(HOME_ASSISTANT_DEVICE_NAME"_sampleJitter"),
+#if SAMPLE_ADAPTIVE
+  sampleWindow(HOME_ASSISTANT_DEVICE_NAME"_sampleWindow"),
+#endif
+  publishedCount(HOME_ASSISTANT_DEVICE_NAME"_publishedMessages"),
+  suppressedCount(HOME_ASSISTANT_DEVICE_NAME"_suppressedMessages"),
+  bootTime(HOME_ASSISTANT_DEVICE_NAME"_bootTime"),
+#ifdef HAVE_WATER_LEVEL_STATE
+  waterLevelLatency(HOME_ASSISTANT_DEVICE_NAME"_waterLevelLatency"),
+#endif
+#if HAVE_WIFI
+  wifiConnectTime(HOME_ASSISTANT_DEVICE_NAME"_wifiConnectTime"),
+  wifiOutage(HOME_ASSISTANT_DEVICE_NAME"_wifiOutage"),
 #endif
-#ifdef HAVE_MOISTURE
-  moisture(HOME_ASSISTANT_DEVICE_NAME"_moisture"),
+#ifdef HAVE_AHT20
+  aht20Failures(HOME_ASSISTANT_DEVICE_NAME"_aht20Failures"),
 #endif
-  mqtt(client, device)
+#ifdef HAVE_ENS160
+  ens160Failures(HOME_ASSISTANT_DEVICE_NAME"_ens160Failures"),
+#endif
+#ifdef HAVE_I2C
+  i2cErrors(HOME_ASSISTANT_DEVICE_NAME"_i2cErrors"),
+  i2cCycleTime(HOME_ASSISTANT_DEVICE_NAME"_i2cCycleTime", HASensorNumber::PrecisionP2),
+#endif
+  freeHeap(HOME_ASSISTANT_DEVICE_NAME"_freeHeap"),
+  largestFreeBlock(HOME_ASSISTANT_DEVICE_NAME"_largestFreeBlock"),
+  stackHeadroom(HOME_ASSISTANT_DEVICE_NAME"_stackHeadroom"),
+  loopLatency(HOME_ASSISTANT_DEVICE_NAME"_loopLatency"),
+#if HAVE_WIFI
+  wifiSignal(HOME_ASSISTANT_DEVICE_NAME"_wifiSignal"),
+#endif
+  mqttReconnects(HOME_ASSISTANT_DEVICE_NAME"_mqttReconnects"),
+#if NETWORK_SERVICE_DISCOVERY
+  discoveryUpdates(HOME_ASSISTANT_DEVICE_NAME"_discoveryUpdates"),
+#endif
+  uptime(HOME_ASSISTANT_DEVICE_NAME"_uptime"),
+  logDropped(HOME_ASSISTANT_DEVICE_NAME"_logDropped"),
+  resetReason(HOME_ASSISTANT_DEVICE_NAME"_resetReason"),
+  mqtt(client, device, entityCount)
 {
+#if HOME_ASSISTANT_BATCHED_STATE
+  stateTopic[0] = '\0'; // set with the unique id of the device
+#endif
+#if USE_SAMPLE_SPOOL
+  historyTopic[0] = '\0';
+#endif
+
   // set device's details
   device.setName(HOME_ASSISTANT_DEVICE_NAME);
   device.setSoftwareVersion(DEVICE_SOFTWARE_VERSION);
@@ -67,76 +165,197 @@ FuFarmHomeAssistant::FuFarmHomeAssistant(Client &client) :
   mqtt.setDataPrefix(HOME_ASSISTANT_DATA_PREFIX);
   mqtt.setKeepAlive(HOME_ASSISTANT_MQTT_KEEPALIVE);
 
-  // Setup sensors with the relevant information
-  // Device classes are listed at https://www.home-assistant.io/integrations/sensor/#device-class
+  // Setup sensors with the relevant information, see SensorRegistry.h
+#if HOME_ASSISTANT_BATCHED_STATE && SENSORS_WINDOW_STATS
+#define FUFARM_HA_STATE(entity, json)                            \
+  entity.setState(stateTopic, FUFARM_HA_VALUE_TEMPLATE(json)); \
+  entity.setJsonAttributes(stateTopic, FUFARM_HA_STATS_TEMPLATE(json));
+#elif HOME_ASSISTANT_BATCHED_STATE
+#define FUFARM_HA_STATE(entity, json) entity.setState(stateTopic, FUFARM_HA_VALUE_TEMPLATE(json));
+#else
+#define FUFARM_HA_STATE(entity, json)
+#endif
+#define FUFARM_HA_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, ...) \
+  configure(id, deviceClass, unit, stateClass, name, icon);                                                       \
+  FUFARM_HA_STATE(id, json)                                                                                       \
+  id##Policy = PublishPolicy(policy);
+#define FUFARM_HA_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, ...) \
+  configure(id, deviceClass, unit, nullptr, name, nullptr);                                                 \
+  FUFARM_HA_STATE(id, json)                                                                                 \
+  for (uint8_t i = 0; i < (max); i++)                                                                       \
+  {                                                                                                         \
+    id##Policy[i] = PublishPolicy(policy);                                                                  \
+  }                                                                                                         \
+  for (uint8_t i = 0; i + 1 < (max); i++)                                                                   \
+  {                                                                                                         \
+    /* probes are numbered from 2 because the first one is the entity itself */                             \
+    snprintf(id##ProbeIds[i], sizeof(id##ProbeIds[i]), HOME_ASSISTANT_DEVICE_NAME "_" #id "%u", i + 2);     \
+    snprintf(id##ProbeNames[i], sizeof(id##ProbeNames[i]), name " %u", i + 2);                              \
+    id##Probes[i] = new SensorEntity(id##ProbeIds[i], HASensorNumber::precision FUFARM_HA_FEATURES);        \
+    configure(*id##Probes[i], deviceClass, unit, nullptr, id##ProbeNames[i], nullptr);                      \
+    FUFARM_HA_PROBE_STATE(id, json, i)                                                                      \
+  }
+#if HOME_ASSISTANT_BATCHED_STATE && SENSORS_WINDOW_STATS
+#define FUFARM_HA_PROBE_STATE(id, json, i)                                                                         \
+  snprintf(id##ProbeTemplates[i], sizeof(id##ProbeTemplates[i]), FUFARM_HA_VALUE_TEMPLATE(json "%u"), i + 2); \
+  id##Probes[i]->setState(stateTopic, id##ProbeTemplates[i]);                                                 \
+  snprintf(id##ProbeStatsTemplates[i], sizeof(id##ProbeStatsTemplates[i]), FUFARM_HA_STATS_TEMPLATE(json "%u"), \
+           i + 2);                                                                                              \
+  id##Probes[i]->setJsonAttributes(stateTopic, id##ProbeStatsTemplates[i]);
+#elif HOME_ASSISTANT_BATCHED_STATE
+#define FUFARM_HA_PROBE_STATE(id, json, i)                                                                         \
+  snprintf(id##ProbeTemplates[i], sizeof(id##ProbeTemplates[i]), FUFARM_HA_VALUE_TEMPLATE(json "%u"), i + 2); \
+  id##Probes[i]->setState(stateTopic, id##ProbeTemplates[i]);
+#else
+#define FUFARM_HA_PROBE_STATE(id, json, i)
+#endif
+#define FUFARM_HA_BINARY(id, field, json, deviceClass, name, icon, bit, policy, ...) \
+  configure(id, deviceClass, name, icon);                                            \
+  id##Policy = PublishPolicy(policy);
+  FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_PROBE_STATE
+#undef FUFARM_HA_STATE
+#undef FUFARM_HA_BINARY
+
+  // Diagnostics
+  sampleJitter.setDeviceClass("duration");
+  sampleJitter.setIcon("mdi:timer-alert-outline");
+  sampleJitter.setName("Sample Jitter");
+  sampleJitter.setUnitOfMeasurement("ms");
+  sampleJitter.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#if SAMPLE_ADAPTIVE
+  sampleWindow.setDeviceClass("duration");
+  sampleWindow.setIcon("mdi:timer-cog-outline");
+  sampleWindow.setName("Sample Window");
+  sampleWindow.setUnitOfMeasurement("s");
+  sampleWindow.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+
+  publishedCount.setIcon("mdi:upload-outline");
+  publishedCount.setName("Published Messages");
+  publishedCount.setStateClass("total_increasing");
+  publishedCount.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  suppressedCount.setIcon("mdi:upload-off-outline");
+  suppressedCount.setName("Suppressed Messages");
+  suppressedCount.setStateClass("total_increasing");
+  suppressedCount.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  bootTime.setDeviceClass("duration");
+  bootTime.setIcon("mdi:timer-play-outline");
+  bootTime.setName("Boot Time");
+  bootTime.setUnitOfMeasurement("ms");
+  bootTime.setExpireAfter(EXPIRE_AFTER_SECONDS);
 #ifdef HAVE_WATER_LEVEL_STATE
-  waterLevel.setDeviceClass("moisture");
-  waterLevel.setIcon("mdi:cup-water");
-  waterLevel.setName("Sump Level Indicator");
-  waterLevel.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_LIGHT
-  // TODO: the sensor we are using does not support lux, we may want to consider using a custom class
-  light.setDeviceClass("illuminance");
-  light.setUnitOfMeasurement("lx");
-  light.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
-  temperature.setDeviceClass("temperature");
-  temperature.setUnitOfMeasurement("°C");
-  temperature.setExpireAfter(EXPIRE_AFTER_SECONDS);
-
-  humidity.setDeviceClass("humidity");
-  humidity.setUnitOfMeasurement("%");
-  humidity.setExpireAfter(EXPIRE_AFTER_SECONDS);
+  waterLevelLatency.setDeviceClass("duration");
+  waterLevelLatency.setIcon("mdi:timer-sand");
+  waterLevelLatency.setName("Sump Level Latency");
+  waterLevelLatency.setUnitOfMeasurement("ms");
+  waterLevelLatency.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+#if HAVE_WIFI
+  wifiConnectTime.setDeviceClass("duration");
+  wifiConnectTime.setIcon("mdi:wifi-cog");
+  wifiConnectTime.setName("WiFi Connect Time");
+  wifiConnectTime.setUnitOfMeasurement("ms");
+  wifiConnectTime.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  wifiOutage.setDeviceClass("duration");
+  wifiOutage.setIcon("mdi:wifi-off");
+  wifiOutage.setName("WiFi Outage");
+  wifiOutage.setUnitOfMeasurement("s");
+  wifiOutage.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+#ifdef HAVE_AHT20
+  aht20Failures.setIcon("mdi:alert-circle-outline");
+  aht20Failures.setName("AHT20 Failures");
+  aht20Failures.setStateClass("total_increasing");
+  aht20Failures.setExpireAfter(EXPIRE_AFTER_SECONDS);
 #endif
 #ifdef HAVE_ENS160
-  aqi.setDeviceClass("aqi");
-  aqi.setExpireAfter(EXPIRE_AFTER_SECONDS);
-  // no need to set unit for AQI, it is documented as unitless
-
-  tvoc.setDeviceClass("volatile_organic_compounds_parts");
-  tvoc.setUnitOfMeasurement("ppb");
-  tvoc.setExpireAfter(EXPIRE_AFTER_SECONDS);
-
-  eco2.setDeviceClass("carbon_dioxide");
-  eco2.setName("Carbon Dioxide (Equivalent)");
-  eco2.setUnitOfMeasurement("ppm");
-  eco2.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_FLOW
-  flow.setDeviceClass("volume_flow_rate");
-  flow.setIcon("mdi:waves-arrow-right"); // default icon is unknown so we set ours
-  flow.setUnitOfMeasurement("L/min");
-  flow.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_TEMP_WET
-  liquidtemp.setDeviceClass("temperature");
-  liquidtemp.setName("Liquid Temperature");
-  liquidtemp.setUnitOfMeasurement("°C");
-  liquidtemp.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_CO2
-  co2.setDeviceClass("carbon_dioxide");
-  co2.setUnitOfMeasurement("ppm");
-  co2.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_EC
-  // As of 2025-Mar-28, Home Assistant does not have a device class for EC, we create a custom one
-  ec.setIcon("mdi:waveform");
-  ec.setName("Electrical Conductivity");
-  ec.setUnitOfMeasurement("mS/cm");
-  ec.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_PH
-  ph.setDeviceClass("ph");
-  ph.setExpireAfter(EXPIRE_AFTER_SECONDS);
-#endif
-#ifdef HAVE_MOISTURE
-  moisture.setDeviceClass("moisture");
-  moisture.setUnitOfMeasurement("%");
-  moisture.setExpireAfter(EXPIRE_AFTER_SECONDS);
+  ens160Failures.setIcon("mdi:alert-circle-outline");
+  ens160Failures.setName("ENS160 Failures");
+  ens160Failures.setStateClass("total_increasing");
+  ens160Failures.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+#ifdef HAVE_I2C
+  i2cErrors.setIcon("mdi:alert-circle-outline");
+  i2cErrors.setName("I2C Errors");
+  i2cErrors.setStateClass("total_increasing");
+  i2cErrors.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  i2cCycleTime.setDeviceClass("duration");
+  i2cCycleTime.setIcon("mdi:timer-outline");
+  i2cCycleTime.setName("I2C Bus Time");
+  i2cCycleTime.setUnitOfMeasurement("ms");
+  i2cCycleTime.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+
+  // Device health
+  freeHeap.setDeviceClass("data_size");
+  freeHeap.setIcon("mdi:memory");
+  freeHeap.setName("Free Heap");
+  freeHeap.setUnitOfMeasurement("B");
+  freeHeap.setStateClass("measurement");
+  freeHeap.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  largestFreeBlock.setDeviceClass("data_size");
+  largestFreeBlock.setIcon("mdi:memory");
+  largestFreeBlock.setName("Largest Free Block");
+  largestFreeBlock.setUnitOfMeasurement("B");
+  largestFreeBlock.setStateClass("measurement");
+  largestFreeBlock.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  stackHeadroom.setDeviceClass("data_size");
+  stackHeadroom.setIcon("mdi:layers-outline");
+  stackHeadroom.setName("Stack Headroom");
+  stackHeadroom.setUnitOfMeasurement("B");
+  stackHeadroom.setStateClass("measurement");
+  stackHeadroom.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  loopLatency.setDeviceClass("duration");
+  loopLatency.setIcon("mdi:timer-alert-outline");
+  loopLatency.setName("Loop Latency");
+  loopLatency.setUnitOfMeasurement("\u03bcs");
+  loopLatency.setStateClass("measurement");
+  loopLatency.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#if HAVE_WIFI
+  wifiSignal.setDeviceClass("signal_strength");
+  wifiSignal.setIcon("mdi:wifi");
+  wifiSignal.setName("WiFi Signal");
+  wifiSignal.setUnitOfMeasurement("dBm");
+  wifiSignal.setStateClass("measurement");
+  wifiSignal.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#endif
+
+  mqttReconnects.setIcon("mdi:lan-connect");
+  mqttReconnects.setName("MQTT Reconnects");
+  mqttReconnects.setStateClass("total_increasing");
+  mqttReconnects.setExpireAfter(EXPIRE_AFTER_SECONDS);
+#if NETWORK_SERVICE_DISCOVERY
+  discoveryUpdates.setIcon("mdi:radar");
+  discoveryUpdates.setName("Discovery Updates");
+  discoveryUpdates.setStateClass("total_increasing");
+  discoveryUpdates.setExpireAfter(EXPIRE_AFTER_SECONDS);
 #endif
+
+  uptime.setDeviceClass("duration");
+  uptime.setIcon("mdi:clock-outline");
+  uptime.setName("Uptime");
+  uptime.setUnitOfMeasurement("s");
+  uptime.setStateClass("total_increasing");
+  uptime.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  logDropped.setIcon("mdi:text-box-remove-outline");
+  logDropped.setName("Dropped Log Messages");
+  logDropped.setStateClass("total_increasing");
+  logDropped.setExpireAfter(EXPIRE_AFTER_SECONDS);
+
+  resetReason.setIcon("mdi:restart-alert");
+  resetReason.setName("Reset Reason");
+  resetReason.setExpireAfter(EXPIRE_AFTER_SECONDS);
 }
 
 FuFarmHomeAssistant::~FuFarmHomeAssistant()
@@ -147,6 +366,12 @@ FuFarmHomeAssistant::~FuFarmHomeAssistant()
 void FuFarmHomeAssistant::setUniqueDeviceId(const uint8_t *value, uint8_t length)
 {
   device.setUniqueId(value, length);
+#if HOME_ASSISTANT_BATCHED_STATE
+  snprintf(stateTopic, sizeof(stateTopic), HOME_ASSISTANT_DATA_PREFIX "/%s/state", device.getUniqueId());
+#endif
+#if USE_SAMPLE_SPOOL
+  snprintf(historyTopic, sizeof(historyTopic), HOME_ASSISTANT_DATA_PREFIX "/%s/history", device.getUniqueId());
+#endif
 }
 
 void FuFarmHomeAssistant::connect(const NetworkEndpoint *endpoint)
@@ -166,57 +391,299 @@ void FuFarmHomeAssistant::connect(const NetworkEndpoint *endpoint)
     mqtt.begin(endpoint->ip, endpoint->port, username, password);
   }
   else {
-    Serial.print("Unknown or unhandled network endpoint type: ");
-    Serial.println(endpoint->type);
+    LOG_ERROR("Unknown or unhandled network endpoint type: %d", (int)endpoint->type);
   }
 }
 
 void FuFarmHomeAssistant::maintain()
 {
+  PROFILE_SCOPE("mqtt.loop");
   mqtt.loop();
+
+  // the values Home Assistant last received may be stale or lost (e.g. the broker restarted), send them all again
+  bool isConnected = connected();
+  if (isConnected && !wasConnected)
+  {
+    resync = true;
+    healthDue = true;
+    mqttConnections++;
+  }
+  wasConnected = isConnected;
+}
+
+#if SENSORS_WINDOW_STATS && !HOME_ASSISTANT_BATCHED_STATE
+// Publishes the statistics of the window of a value as the attributes of its entity
+static void setStatsAttributes(HASensor &sensor, const WindowStats &stats)
+{
+  char buffer[windowStatsJsonCapacity];
+  JsonWriter json(buffer, sizeof(buffer));
+  writeWindowStatsJson(json, stats);
+  sensor.setJsonAttributes(json.c_str());
+}
+#define FUFARM_HA_STATS_ATTRIBUTES(entity, stats) setStatsAttributes(entity, stats);
+#else
+#define FUFARM_HA_STATS_ATTRIBUTES(entity, stats)
+#endif
+
+// The reason of the last reset as reported by esp_reset_reason()
+static const char *resetReasonName(uint8_t reason)
+{
+  switch (reason)
+  {
+  case ESP_RST_POWERON:
+    return "power on";
+  case ESP_RST_EXT:
+    return "external";
+  case ESP_RST_SW:
+    return "software";
+  case ESP_RST_PANIC:
+    return "panic";
+  case ESP_RST_INT_WDT:
+    return "interrupt watchdog";
+  case ESP_RST_TASK_WDT:
+    return "task watchdog";
+  case ESP_RST_WDT:
+    return "watchdog";
+  case ESP_RST_DEEPSLEEP:
+    return "deep sleep";
+  case ESP_RST_BROWNOUT:
+    return "brownout";
+  case ESP_RST_SDIO:
+    return "SDIO";
+  default:
+    return "unknown";
+  }
+}
+
+bool FuFarmHomeAssistant::shouldPublish(PublishPolicy &policy, float value, bool force, uint32_t now)
+{
+  if (!force && !policy.due(now, value))
+  {
+    suppressedMessages++;
+    return false;
+  }
+
+  policy.published(now, value);
+  publishedMessages++;
+  return true;
 }
 
 void FuFarmHomeAssistant::update(FuFarmSensorsData *source, const bool force)
 {
+  PROFILE_SCOPE("ha.update");
   if (!connected())
   {
-    Serial.println(F("MQTT not connected, skipping update"));
+    LOG_WARN("MQTT not connected, skipping update");
     return;
   }
 
-#ifdef HAVE_WATER_LEVEL_STATE
-  waterLevel.setState(source->waterLevelState, force);
-#endif
-#ifdef HAVE_LIGHT
-  light.setValue(source->light, force);
+  const uint32_t now = millis();
+  const bool all = force || resync;
+  resync = false;
+
+#if SENSORS_SCHEDULE
+  // only the values of the groups that were read are new, the others are those of an earlier sample
+#define FUFARM_HA_FRESH(group) (all || (source->groups & (group)))
+#else
+#define FUFARM_HA_FRESH(group) true
 #endif
-#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
-  temperature.setValue(source->temperature.air, force);
-  humidity.setValue(source->humidity, force);
+
+#if HOME_ASSISTANT_BATCHED_STATE
+  // one message for all the values, each entity extracts its own with its template.
+  // It is sent when any value is due and then carries the others too, so they are all recorded as published.
+  bool due = all;
+#define FUFARM_HA_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, group) \
+  due = due || (FUFARM_HA_FRESH(group) && id##Policy.due(now, source->field));
+#define FUFARM_HA_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, group) \
+  for (uint8_t i = 0; i < source->count; i++)                                                            \
+  {                                                                                                      \
+    due = due || (FUFARM_HA_FRESH(group) && id##Policy[i].due(now, source->field[i]));                   \
+  }
+#define FUFARM_HA_BINARY(...)
+  FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_BINARY
+
+  if (!due)
+  {
+    suppressedMessages++;
+  }
+  else
+  {
+#if SENSORS_WINDOW_STATS
+    // the statistics are in a "stats" member, static because they take a few kB
+    static char buffer[sensorsJsonCapacity + sizeof("stats") + 3 + sensorsWindowStatsJsonCapacity];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    writeSensorsJsonMembers(json, source);
+    json.key("stats");
+    writeSensorsWindowStatsJson(json, source);
+    json.endObject();
+#else
+    char buffer[sensorsJsonCapacity];
+    JsonWriter json(buffer, sizeof(buffer));
+    writeSensorsJson(json, source);
+#endif
+    // only recorded once sent, the values that were not stay due and go with the next sample
+    if (!mqtt.publish(stateTopic, json.c_str()))
+    {
+      LOG_WARN("Could not publish the state");
+    }
+    else
+    {
+      publishedMessages++;
+
+#define FUFARM_HA_NUMBER(id, field, ...) id##Policy.published(now, source->field);
+#define FUFARM_HA_PROBES(id, field, count, max, ...) \
+  for (uint8_t i = 0; i < source->count; i++)        \
+  {                                                  \
+    id##Policy[i].published(now, source->field[i]);  \
+  }
+#define FUFARM_HA_BINARY(...)
+      FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_BINARY
+    }
+  }
+#define FUFARM_HA_NUMBER(...)
+#define FUFARM_HA_PROBES(...)
+#else
+  // probes that are not on the bus are not published so that they expire in Home Assistant.
+  // Values are forced once due because the library would otherwise skip one equal to the last it sent.
+#define FUFARM_HA_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, group) \
+  if (FUFARM_HA_FRESH(group) && shouldPublish(id##Policy, source->field, all, now))                                 \
+  {                                                                                                                 \
+    id.setValue(source->field, true);                                                                               \
+    FUFARM_HA_STATS_ATTRIBUTES(id, source->stats.id)                                                                \
+  }
+#define FUFARM_HA_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, group) \
+  if (FUFARM_HA_FRESH(group))                                                                                 \
+  {                                                                                                           \
+    if (shouldPublish(id##Policy[0], source->field[0], all, now))                                             \
+    {                                                                                                         \
+      id.setValue(source->field[0], true);                                                                    \
+      FUFARM_HA_STATS_ATTRIBUTES(id, source->stats.id[0])                                                     \
+    }                                                                                                         \
+    for (uint8_t i = 1; i < source->count; i++)                                                               \
+    {                                                                                                         \
+      if (shouldPublish(id##Policy[i], source->field[i], all, now))                                           \
+      {                                                                                                       \
+        id##Probes[i - 1]->setValue(source->field[i], true);                                                  \
+        FUFARM_HA_STATS_ATTRIBUTES(*id##Probes[i - 1], source->stats.id[i])                                   \
+      }                                                                                                       \
+    }                                                                                                         \
+  }
 #endif
-#ifdef HAVE_ENS160
-  aqi.setValue(source->airQuality.index, force);
-  tvoc.setValue(source->airQuality.tvoc, force);
-  eco2.setValue(source->airQuality.eco2, force);
+#define FUFARM_HA_BINARY(id, field, json, deviceClass, name, icon, bit, policy, group) \
+  if (FUFARM_HA_FRESH(group) && shouldPublish(id##Policy, source->field, all, now))    \
+  {                                                                                    \
+    id.setState(source->field, true);                                                  \
+  }
+  FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_BINARY
+#undef FUFARM_HA_FRESH
+}
+
+#if USE_SAMPLE_SPOOL
+bool FuFarmHomeAssistant::publishSpooled(const SpooledSample *sample)
+{
+  if (!connected())
+  {
+    return false;
+  }
+
+  char buffer[sensorsJsonCapacity + sizeof("time") + 3 + JSON_WRITER_MAX_VALUE_LENGTH];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  if (sample->time != 0)
+  {
+    json.key("time");
+    json.value(sample->time);
+  }
+  writeSensorsJsonMembers(json, &sample->data);
+  json.endObject();
+  return mqtt.publish(historyTopic, json.c_str());
+}
 #endif
-#ifdef HAVE_FLOW
-  flow.setValue(source->flow, force);
+
+#ifdef HAVE_WATER_LEVEL_STATE
+bool FuFarmHomeAssistant::updateWaterLevel(bool state)
+{
+  if (!connected())
+  {
+    return false;
+  }
+
+  // forced so that the change is published even if the last periodic update already carried it,
+  // and recorded so that the next periodic update does not send it again
+  waterLevelPolicy.published(millis(), state);
+  publishedMessages++;
+  return waterLevel.setState(state, true);
+}
 #endif
-#ifdef HAVE_TEMP_WET
-  liquidtemp.setValue(source->temperature.wet, force);
+
+void FuFarmHomeAssistant::updateDiagnostics(const FuFarmDiagnostics *source)
+{
+  if (!connected())
+  {
+    return;
+  }
+
+  // the diagnostics change on every sample but are only of interest over hours, they are sent at a lower cadence
+  const uint32_t now = millis();
+  if (!healthDue && now - healthMillis < HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS)
+  {
+    return;
+  }
+  healthDue = false;
+  healthMillis = now;
+
+  // counted with the sensor values, so that the published messages reflect the whole traffic of the device
+  uint32_t sent = 0;
+  sent += sampleJitter.setValue(source->sampleJitter, true);
+#if SAMPLE_ADAPTIVE
+  sent += sampleWindow.setValue(source->sampleWindow / 1000, true);
+#endif
+  sent += publishedCount.setValue(publishedMessages, true);
+  sent += suppressedCount.setValue(suppressedMessages, true);
+  sent += bootTime.setValue(source->bootTime, true);
+#ifdef HAVE_WATER_LEVEL_STATE
+  sent += waterLevelLatency.setValue(source->waterLevelLatency, true);
 #endif
-#ifdef HAVE_CO2
-  co2.setValue(source->co2, force);
+#if HAVE_WIFI
+  sent += wifiConnectTime.setValue(source->wifiConnectTime, true);
+  sent += wifiOutage.setValue(source->wifiOutage / 1000, true);
 #endif
-#ifdef HAVE_EC
-  ec.setValue(source->ec, force);
+#ifdef HAVE_AHT20
+  sent += aht20Failures.setValue(source->aht20Failures, true);
 #endif
-#ifdef HAVE_PH
-  ph.setValue(source->ph, force);
+#ifdef HAVE_ENS160
+  sent += ens160Failures.setValue(source->ens160Failures, true);
 #endif
-#ifdef HAVE_MOISTURE
-  moisture.setValue(source->moisture, force);
+#ifdef HAVE_I2C
+  sent += i2cErrors.setValue(source->i2cErrors, true);
+  sent += i2cCycleTime.setValue(source->i2cCycleMicros / 1000.0f, true);
 #endif
+
+  sent += freeHeap.setValue(source->freeHeap, true);
+  sent += largestFreeBlock.setValue(source->largestFreeBlock, true);
+  sent += stackHeadroom.setValue(source->stackHeadroom, true);
+  sent += loopLatency.setValue(source->loopLatency, true);
+#if HAVE_WIFI
+  sent += wifiSignal.setValue(source->wifiSignal, true);
+#endif
+  sent += mqttReconnects.setValue(mqttConnections > 0 ? mqttConnections - 1 : 0, true);
+#if NETWORK_SERVICE_DISCOVERY
+  sent += discoveryUpdates.setValue(source->discoveryUpdates, true);
+#endif
+  sent += uptime.setValue(source->uptime, true);
+  sent += logDropped.setValue(source->logDropped, true);
+  sent += resetReason.setValue(resetReasonName(source->resetReason));
+  publishedMessages += sent;
 }
 
 #endif // USE_HOME_ASSISTANT
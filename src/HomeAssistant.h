@@ -8,11 +8,23 @@
 #include <ArduinoHA.h>
 #include "ServiceDiscovery.h"
 #include "sensors.h"
+#include "Diagnostics.h"
+#include "SensorRegistry.h"
+#include "HABatchedSensor.h"
+#include "HADiagnostic.h"
+#include "PublishPolicy.h"
+#include "SampleSpool.h"
 
 /**
  * This class is a wrapper for the Home Assistant logic.
  * It is where all the Home Assistant related code is located.
  */
+// The template that extracts a value from the batched state, a missing value (e.g. a probe that is not on the bus)
+// renders as None which Home Assistant shows as unknown
+#define FUFARM_HA_VALUE_TEMPLATE(json) "{{ value_json.get('" json "') }}"
+// The template that extracts the statistics of a value from the batched state as the attributes of its entity
+#define FUFARM_HA_STATS_TEMPLATE(json) "{{ value_json.stats.get('" json "', {}) | tojson }}"
+
 class FuFarmHomeAssistant
 {
 public:
@@ -64,14 +76,52 @@ public:
   /**
    * Publishes MQTT messages for configured sensors.
    * If the connection has not been established, nothing is published.
-   * In some cases, if a sensor value is the same as the previous one the MQTT message won't be published.
-   * This means MQTT messages are not always produced when the update method is called.
+   * A value is only published when its publish policy (see SensorRegistry.h) says so, i.e. it changed by more than
+   * its deadband or the heartbeat is due. This means MQTT messages are not always produced when the update method
+   * is called. In batched mode (HOME_ASSISTANT_BATCHED_STATE), the values are published as a single JSON document
+   * instead, whenever at least one of them is due.
+   * Every value is published after a reconnection.
+   * With SENSORS_WINDOW_STATS, the statistics of the window of each value (see writeWindowStatsJson()) are
+   * published as the attributes of its entity along with the value.
    *
    * @param source All values for configured sensors.
-   * @param force Forces to update the state without comparing it to a previous known state.
+   * @param force Publishes every value regardless of the publish policies.
    */
   void update(FuFarmSensorsData *source, const bool force = true);
 
+#if USE_SAMPLE_SPOOL
+  /**
+   * Publishes a sample that was spooled while disconnected, as a JSON document with its time
+   * (e.g. {"time":1735689600,"tempair":21.5,...}) on <data prefix>/<device id>/history.
+   * Home Assistant timestamps the states of MQTT entities when they are received, so spooled samples are not
+   * published as states, which would be recorded at the wrong time. scripts/history_importer.py imports them into
+   * the statistics of Home Assistant instead.
+   * The time is omitted if it is not known.
+   *
+   * @param sample The sample.
+   * @return true if the sample was published, false if not connected or the broker did not take it.
+   */
+  bool publishSpooled(const SpooledSample *sample);
+#endif
+
+#ifdef HAVE_WATER_LEVEL_STATE
+  /**
+   * Publishes the water level straight away, outside of the periodic update.
+   *
+   * @param state The water level.
+   * @return true if the state was published, false if not connected.
+   */
+  bool updateWaterLevel(bool state);
+#endif
+
+  /**
+   * Publishes MQTT messages for the diagnostics of the device, at most every HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS
+   * and once (re)connected. If the connection has not been established, nothing is published.
+   *
+   * @param source The diagnostic values.
+   */
+  void updateDiagnostics(const FuFarmDiagnostics *source);
+
   /**
    * Returns the current state of the MQTT connection.
    * @return true if connected, false otherwise.
@@ -83,36 +133,101 @@ private:
   HAMqtt mqtt;
 
 private:
-#ifdef HAVE_WATER_LEVEL_STATE
-  HABinarySensor waterLevel;
+  // In batched mode, the values of a sample are published as one JSON document on this topic
+#if HOME_ASSISTANT_BATCHED_STATE
+  typedef HABatchedSensor SensorEntity;
+  char stateTopic[sizeof(HOME_ASSISTANT_DATA_PREFIX) + 2 * MAC_ADDRESS_LENGTH + sizeof("/state")];
+#else
+  typedef HASensorNumber SensorEntity;
 #endif
-#ifdef HAVE_LIGHT
-  HASensorNumber light;
+#if USE_SAMPLE_SPOOL
+  char historyTopic[sizeof(HOME_ASSISTANT_DATA_PREFIX) + 2 * MAC_ADDRESS_LENGTH + sizeof("/history")];
 #endif
-#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
-  HASensorNumber temperature, humidity;
+
+  // One entity per value in the sensor registry.
+  // Additional probes are created at runtime because their identifiers (and templates) are generated.
+#define FUFARM_HA_NUMBER(id, ...) \
+  SensorEntity id;                \
+  PublishPolicy id##Policy;
+#define FUFARM_HA_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, ...)    \
+  SensorEntity id;                                                                             \
+  PublishPolicy id##Policy[max];                                                               \
+  SensorEntity *id##Probes[(max) > 1 ? (max) - 1 : 1];                                         \
+  char id##ProbeIds[(max) > 1 ? (max) - 1 : 1][sizeof(HOME_ASSISTANT_DEVICE_NAME "_" #id) + 4]; \
+  char id##ProbeNames[(max) > 1 ? (max) - 1 : 1][sizeof(name) + 4];                            \
+  FUFARM_HA_PROBE_TEMPLATES(id, max, json)
+#if HOME_ASSISTANT_BATCHED_STATE && SENSORS_WINDOW_STATS
+#define FUFARM_HA_PROBE_TEMPLATES(id, max, json)                                                     \
+  char id##ProbeTemplates[(max) > 1 ? (max) - 1 : 1][sizeof(FUFARM_HA_VALUE_TEMPLATE(json)) + 4]; \
+  char id##ProbeStatsTemplates[(max) > 1 ? (max) - 1 : 1][sizeof(FUFARM_HA_STATS_TEMPLATE(json)) + 4];
+#elif HOME_ASSISTANT_BATCHED_STATE
+#define FUFARM_HA_PROBE_TEMPLATES(id, max, json) \
+  char id##ProbeTemplates[(max) > 1 ? (max) - 1 : 1][sizeof(FUFARM_HA_VALUE_TEMPLATE(json)) + 4];
+#else
+#define FUFARM_HA_PROBE_TEMPLATES(id, max, json)
 #endif
-#ifdef HAVE_ENS160
-  HASensorNumber aqi, tvoc, eco2;
+#define FUFARM_HA_BINARY(id, ...) \
+  HABinarySensor id;              \
+  PublishPolicy id##Policy;
+  FUFARM_SENSORS(FUFARM_HA_NUMBER, FUFARM_HA_PROBES, FUFARM_HA_BINARY)
+#undef FUFARM_HA_NUMBER
+#undef FUFARM_HA_PROBES
+#undef FUFARM_HA_PROBE_TEMPLATES
+#undef FUFARM_HA_BINARY
+
+private:
+  // Counts of the values (documents in batched mode) published and suppressed by the publish policies,
+  // the published count includes the diagnostics
+  uint32_t publishedMessages, suppressedMessages;
+  // Every value is published again once reconnected, e.g. the broker may have restarted without retaining them
+  bool wasConnected, resync;
+  // Connections to the broker since boot, the first one is not a reconnection
+  uint32_t mqttConnections;
+  // The diagnostics are published every HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS, and once (re)connected
+  uint32_t healthMillis;
+  bool healthDue;
+
+  /**
+   * Returns true if a value should be published, i.e. if forced or if its policy says so.
+   * The value is then recorded as published and counted, the caller is expected to publish it.
+   */
+  bool shouldPublish(PublishPolicy &policy, float value, bool force, uint32_t now);
+
+private:
+  typedef HADiagnostic<HASensorNumber> DiagnosticEntity;
+  DiagnosticEntity sampleJitter;
+#if SAMPLE_ADAPTIVE
+  DiagnosticEntity sampleWindow;
 #endif
-#ifdef HAVE_FLOW
-  HASensorNumber flow;
+  DiagnosticEntity publishedCount, suppressedCount;
+  DiagnosticEntity bootTime;
+#ifdef HAVE_WATER_LEVEL_STATE
+  DiagnosticEntity waterLevelLatency;
 #endif
-#ifdef HAVE_TEMP_WET
-  HASensorNumber liquidtemp;
+#if HAVE_WIFI
+  DiagnosticEntity wifiConnectTime, wifiOutage;
 #endif
-#ifdef HAVE_CO2
-  HASensorNumber co2;
+#ifdef HAVE_AHT20
+  DiagnosticEntity aht20Failures;
 #endif
-#ifdef HAVE_EC
-  HASensorNumber ec;
+#ifdef HAVE_ENS160
+  DiagnosticEntity ens160Failures;
+#endif
+#ifdef HAVE_I2C
+  DiagnosticEntity i2cErrors, i2cCycleTime;
 #endif
-#ifdef HAVE_PH
-  HASensorNumber ph;
+
+  // Device health
+  DiagnosticEntity freeHeap, largestFreeBlock, stackHeadroom, loopLatency;
+#if HAVE_WIFI
+  DiagnosticEntity wifiSignal;
 #endif
-#ifdef HAVE_MOISTURE
-  HASensorNumber moisture;
+  DiagnosticEntity mqttReconnects;
+#if NETWORK_SERVICE_DISCOVERY
+  DiagnosticEntity discoveryUpdates;
 #endif
+  DiagnosticEntity uptime, logDropped;
+  HADiagnostic<HASensor> resetReason;
 };
 
 #endif // USE_HOME_ASSISTANT
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "I2CBus.h"
+
+// Longest register write, including the register address
+#define I2C_BUS_MAX_WRITE 16
+
+bool I2CBus::probe(uint8_t address)
+{
+  return timedTransfer(address, nullptr, 0, nullptr, 0);
+}
+
+bool I2CBus::write(uint8_t address, const uint8_t *data, uint8_t length)
+{
+  return timedTransfer(address, data, length, nullptr, 0);
+}
+
+bool I2CBus::read(uint8_t address, uint8_t *data, uint8_t length)
+{
+  return timedTransfer(address, nullptr, 0, data, length);
+}
+
+bool I2CBus::readRegisters(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length)
+{
+  return timedTransfer(address, &reg, 1, data, length);
+}
+
+bool I2CBus::writeRegisters(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t length)
+{
+  if (length >= I2C_BUS_MAX_WRITE)
+  {
+    return false;
+  }
+
+  uint8_t buffer[I2C_BUS_MAX_WRITE];
+  buffer[0] = reg;
+  memcpy(buffer + 1, data, length);
+  return timedTransfer(address, buffer, length + 1, nullptr, 0);
+}
+
+void I2CBus::resetStats()
+{
+  _stats.transactions = 0;
+  _stats.lastMicros = 0;
+  _stats.maxMicros = 0;
+  _stats.totalMicros = 0;
+}
+
+bool I2CBus::timedTransfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength)
+{
+  uint32_t started = clockMicros();
+  bool success = transfer(address, tx, txLength, rx, rxLength);
+  uint32_t elapsed = clockMicros() - started;
+
+  _stats.transactions++;
+  _stats.lastMicros = elapsed;
+  _stats.totalMicros += elapsed;
+  if (elapsed > _stats.maxMicros)
+  {
+    _stats.maxMicros = elapsed;
+  }
+
+  if (!success)
+  {
+    _stats.errors++;
+    if (recover())
+    {
+      _stats.recoveries++;
+    }
+  }
+  return success;
+}
@@ -0,0 +1,125 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+
+/**
+ * Timing statistics of the transactions on a bus.
+ */
+struct I2CBusStats
+{
+  uint32_t transactions; // number of transactions since the stats were reset
+  uint32_t errors; // number of transactions that failed
+  uint32_t recoveries; // number of times a stuck bus was freed
+  uint32_t lastMicros; // duration of the last transaction
+  uint32_t maxMicros; // duration of the longest transaction
+  uint64_t totalMicros; // time spent on the bus
+
+  /**
+   * Returns the average duration of a transaction in microseconds.
+   */
+  inline uint32_t averageMicros() const { return transactions ? (uint32_t)(totalMicros / transactions) : 0; }
+};
+
+/**
+ * Shared I2C bus that the drivers go through instead of using Wire directly.
+ *
+ * Every operation is a single transaction: an optional write followed by an optional read with a repeated start.
+ * This lets a driver fetch several consecutive registers at once instead of one transaction per value.
+ * Transactions are timed and, when one fails, the implementation gets a chance to free a stuck bus.
+ *
+ * This file does not depend on Arduino so that drivers can be exercised on the host against a fake bus
+ * which implements transfer(), clockMicros() and recover().
+ */
+class I2CBus
+{
+public:
+  virtual ~I2CBus() {}
+
+  /**
+   * Checks whether a device acknowledges its address.
+   *
+   * @param address The 7-bit address of the device.
+   */
+  bool probe(uint8_t address);
+
+  /**
+   * Writes bytes to a device (e.g. a command and its parameters).
+   *
+   * @param address The 7-bit address of the device.
+   * @param data The bytes to write.
+   * @param length The number of bytes to write.
+   * @return true if the device acknowledged all the bytes.
+   */
+  bool write(uint8_t address, const uint8_t *data, uint8_t length);
+
+  /**
+   * Reads bytes from a device that does not use registers (e.g. AHT20).
+   *
+   * @param address The 7-bit address of the device.
+   * @param data The destination for the bytes.
+   * @param length The number of bytes to read.
+   * @return true if all the bytes were read.
+   */
+  bool read(uint8_t address, uint8_t *data, uint8_t length);
+
+  /**
+   * Reads consecutive registers in a single transaction.
+   *
+   * @param address The 7-bit address of the device.
+   * @param reg The first register to read.
+   * @param data The destination for the registers.
+   * @param length The number of registers to read.
+   * @return true if all the registers were read.
+   */
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length);
+
+  /**
+   * Writes consecutive registers in a single transaction.
+   *
+   * @param address The 7-bit address of the device.
+   * @param reg The first register to write.
+   * @param data The values of the registers.
+   * @param length The number of registers to write.
+   * @return true if the device acknowledged all the values.
+   */
+  bool writeRegisters(uint8_t address, uint8_t reg, const uint8_t *data, uint8_t length);
+
+  /**
+   * Returns the statistics of the transactions since the last reset.
+   */
+  inline const I2CBusStats &stats() const { return _stats; }
+
+  /**
+   * Resets the statistics, except for the error and recovery counters which count since boot.
+   */
+  void resetStats();
+
+protected:
+  /**
+   * Performs a transaction: writes the tx bytes (if any) then reads the rx bytes (if any) after a repeated start.
+   *
+   * @return true if the transaction succeeded.
+   */
+  virtual bool transfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength) = 0;
+
+  /**
+   * Returns a free running time in microseconds, used for the statistics.
+   */
+  virtual uint32_t clockMicros() = 0;
+
+  /**
+   * Called after a failed transaction. Frees the bus if a device holds SDA low.
+   *
+   * @return true if the bus was stuck and has been freed.
+   */
+  virtual bool recover() = 0;
+
+private:
+  I2CBusStats _stats = {};
+
+private:
+  bool timedTransfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength);
+};
+
+#endif // I2C_BUS_H
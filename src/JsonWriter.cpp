@@ -0,0 +1,215 @@
+#include "JsonWriter.h"
+
+#include <math.h>
+
+// Values outside of this range are written with an exponent, as ArduinoJson does
+#define JSON_WRITER_POSITIVE_EXPONENTIATION_THRESHOLD 1e7
+#define JSON_WRITER_NEGATIVE_EXPONENTIATION_THRESHOLD 1e-5
+
+// Powers of ten by powers of two, used to bring a value between the thresholds in a few multiplications
+static const double positiveBinaryPowersOfTen[] = {1e1, 1e2, 1e4, 1e8, 1e16, 1e32, 1e64, 1e128, 1e256};
+static const double negativeBinaryPowersOfTen[] = {1e-1, 1e-2, 1e-4, 1e-8, 1e-16, 1e-32, 1e-64, 1e-128, 1e-256};
+static const double negativeBinaryPowersOfTenPlusOne[] = {1e0, 1e-1, 1e-3, 1e-7, 1e-15, 1e-31, 1e-63, 1e-127, 1e-255};
+
+JsonWriter::JsonWriter(char *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _length(0), _overflowed(capacity == 0), _first(true)
+{
+  if (capacity > 0)
+  {
+    _buffer[0] = '\0';
+  }
+}
+
+void JsonWriter::beginObject()
+{
+  write('{');
+  _first = true;
+}
+
+void JsonWriter::endObject()
+{
+  write('}');
+  _first = false; // a nested object is the value of a member
+}
+
+void JsonWriter::key(const char *name)
+{
+  if (!_first)
+  {
+    write(',');
+  }
+  _first = false;
+  write('"');
+  write(name);
+  write('"');
+  write(':');
+}
+
+void JsonWriter::key(const char *name, uint32_t number)
+{
+  if (!_first)
+  {
+    write(',');
+  }
+  _first = false;
+  write('"');
+  write(name);
+  writeUnsigned(number);
+  write('"');
+  write(':');
+}
+
+void JsonWriter::value(bool value)
+{
+  write(value ? "true" : "false");
+}
+
+void JsonWriter::value(float value)
+{
+  // ArduinoJson writes fewer decimals for a float than for a double
+  writeFloat(value, 6);
+}
+
+void JsonWriter::value(double value)
+{
+  writeFloat(value, 9);
+}
+
+void JsonWriter::write(char c)
+{
+  // keep room for the NUL character
+  if (_overflowed || _length + 1 >= _capacity)
+  {
+    _overflowed = true;
+    return;
+  }
+  _buffer[_length++] = c;
+  _buffer[_length] = '\0';
+}
+
+void JsonWriter::write(const char *s)
+{
+  while (*s)
+  {
+    write(*s++);
+  }
+}
+
+void JsonWriter::writeUnsigned(uint32_t value, uint8_t minDigits)
+{
+  char digits[10];
+  uint8_t count = 0;
+  do
+  {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0 || count < minDigits);
+
+  while (count > 0)
+  {
+    write(digits[--count]);
+  }
+}
+
+void JsonWriter::writeInteger(bool negative, uint32_t magnitude)
+{
+  if (negative)
+  {
+    write('-');
+  }
+  writeUnsigned(magnitude);
+}
+
+void JsonWriter::writeFloat(double value, int8_t decimalPlaces)
+{
+  // Same steps as ArduinoJson's TextFormatter::writeFloat() and decomposeFloat()
+  if (isnan(value) || isinf(value))
+  {
+    write("null");
+    return;
+  }
+
+  if (value < 0.0)
+  {
+    write('-');
+    value = -value;
+  }
+
+  // bring the value between the thresholds and remember the exponent
+  int16_t exponent = 0;
+  int8_t index = 8;
+  int16_t bit = 1 << index;
+  if (value >= JSON_WRITER_POSITIVE_EXPONENTIATION_THRESHOLD)
+  {
+    for (; index >= 0; index--)
+    {
+      if (value >= positiveBinaryPowersOfTen[index])
+      {
+        value *= negativeBinaryPowersOfTen[index];
+        exponent = (int16_t)(exponent + bit);
+      }
+      bit >>= 1;
+    }
+  }
+  if (value > 0 && value <= JSON_WRITER_NEGATIVE_EXPONENTIATION_THRESHOLD)
+  {
+    for (; index >= 0; index--)
+    {
+      if (value < negativeBinaryPowersOfTenPlusOne[index])
+      {
+        value *= positiveBinaryPowersOfTen[index];
+        exponent = (int16_t)(exponent - bit);
+      }
+      bit >>= 1;
+    }
+  }
+
+  // the integral digits count towards the decimal places
+  uint32_t maxDecimalPart = 1;
+  for (int8_t i = 0; i < decimalPlaces; i++)
+  {
+    maxDecimalPart *= 10;
+  }
+  uint32_t integral = (uint32_t)value;
+  for (uint32_t tmp = integral; tmp >= 10; tmp /= 10)
+  {
+    maxDecimalPart /= 10;
+    decimalPlaces--;
+  }
+
+  double remainder = (value - (double)integral) * (double)maxDecimalPart;
+  uint32_t decimal = (uint32_t)remainder;
+  remainder = remainder - (double)decimal;
+
+  // round half up
+  decimal += (uint32_t)(remainder * 2);
+  if (decimal >= maxDecimalPart)
+  {
+    decimal = 0;
+    integral++;
+    if (exponent && integral >= 10)
+    {
+      exponent++;
+      integral = 1;
+    }
+  }
+
+  // drop the trailing zeros
+  while (decimal % 10 == 0 && decimalPlaces > 0)
+  {
+    decimal /= 10;
+    decimalPlaces--;
+  }
+
+  writeUnsigned(integral);
+  if (decimalPlaces > 0)
+  {
+    write('.');
+    writeUnsigned(decimal, (uint8_t)decimalPlaces);
+  }
+  if (exponent)
+  {
+    write('e');
+    writeInteger(exponent < 0, (uint32_t)(exponent < 0 ? -exponent : exponent));
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum length of a value written by JsonWriter (e.g. -1234567.5e-308 or -2147483648)
+#define JSON_WRITER_MAX_VALUE_LENGTH 24
+
+/**
+ * Writes a JSON object into a fixed buffer, without allocating. An object can be the value of a member.
+ *
+ * Numbers are formatted the same way as ArduinoJson 7 (same digits, rounding and exponent) so that the output is
+ * byte-identical to serializeJson() for the same members. NaN and infinity are written as null.
+ * If the buffer is too small, writing stops and overflowed() returns true.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class JsonWriter
+{
+public:
+  /**
+   * Creates a new instance of the JsonWriter class.
+   *
+   * @param buffer Where the JSON is written, it is always terminated by a NUL character.
+   * @param capacity The size of the buffer, including the NUL character.
+   */
+  JsonWriter(char *buffer, size_t capacity);
+
+  void beginObject();
+  void endObject();
+
+  /**
+   * Writes the key of the next member.
+   */
+  void key(const char *name);
+
+  /**
+   * Writes the key of the next member, made of a name and a number (e.g. tempwet2).
+   */
+  void key(const char *name, uint32_t number);
+
+  void value(bool value);
+  void value(float value);
+  void value(double value);
+  void value(int32_t value) { writeInteger(value < 0, value < 0 ? 0U - (uint32_t)value : (uint32_t)value); }
+  void value(uint32_t value) { writeInteger(false, value); }
+  void value(int16_t value) { this->value((int32_t)value); }
+  void value(uint16_t value) { this->value((uint32_t)value); }
+
+  /**
+   * Returns the JSON written so far.
+   */
+  inline const char *c_str() const { return _buffer; }
+
+  /**
+   * Returns the number of characters written so far, excluding the NUL character.
+   */
+  inline size_t length() const { return _length; }
+
+  /**
+   * Returns true if the buffer was too small for everything that was written.
+   */
+  inline bool overflowed() const { return _overflowed; }
+
+private:
+  char *_buffer;
+  size_t _capacity;
+  size_t _length;
+  bool _overflowed;
+  bool _first; // no comma before the next key
+
+private:
+  void write(char c);
+  void write(const char *s);
+  void writeUnsigned(uint32_t value, uint8_t minDigits = 1);
+  void writeInteger(bool negative, uint32_t magnitude);
+  void writeFloat(double value, int8_t decimalPlaces);
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,93 @@
+#include "LittleFSSpoolStorage.h"
+
+#if USE_SAMPLE_SPOOL
+
+#include <LittleFS.h>
+
+// long enough for the directory, a slash and up to 10 digits
+#define SPOOL_PATH_LENGTH 64
+
+LittleFSSpoolStorage::LittleFSSpoolStorage(const char *directory) : _directory(directory)
+{
+}
+
+bool LittleFSSpoolStorage::begin()
+{
+  if (!LittleFS.begin(true)) // formats the partition the first time
+  {
+    return false;
+  }
+  LittleFS.mkdir(_directory);
+  return true;
+}
+
+bool LittleFSSpoolStorage::find(uint32_t *first, uint32_t *last)
+{
+  bool found = false;
+  File directory = LittleFS.open(_directory);
+  for (File file = directory.openNextFile(); file; file = directory.openNextFile())
+  {
+    uint32_t block = strtoul(file.name(), nullptr, 10);
+    if (!found || block < *first) *first = block;
+    if (!found || block > *last) *last = block;
+    found = true;
+    file.close();
+  }
+  directory.close();
+  return found;
+}
+
+uint32_t LittleFSSpoolStorage::size(uint32_t block)
+{
+  char name[SPOOL_PATH_LENGTH];
+  path(name, sizeof(name), block);
+  if (!LittleFS.exists(name))
+  {
+    return 0; // e.g. a gap in the numbers
+  }
+  File file = LittleFS.open(name, FILE_READ);
+  if (!file)
+  {
+    return 0;
+  }
+  uint32_t size = file.size();
+  file.close();
+  return size;
+}
+
+bool LittleFSSpoolStorage::read(uint32_t block, uint32_t offset, void *dest, uint32_t length)
+{
+  char name[SPOOL_PATH_LENGTH];
+  path(name, sizeof(name), block);
+  File file = LittleFS.open(name, FILE_READ);
+  bool read = file && file.seek(offset) && file.read((uint8_t *)dest, length) == length;
+  file.close();
+  return read;
+}
+
+bool LittleFSSpoolStorage::append(uint32_t block, const void *data, uint32_t length)
+{
+  char name[SPOOL_PATH_LENGTH];
+  path(name, sizeof(name), block);
+  File file = LittleFS.open(name, FILE_APPEND);
+  bool written = file && file.write((const uint8_t *)data, length) == length;
+  file.close();
+  return written;
+}
+
+void LittleFSSpoolStorage::remove(uint32_t block)
+{
+  char name[SPOOL_PATH_LENGTH];
+  path(name, sizeof(name), block);
+  if (LittleFS.exists(name))
+  {
+    LittleFS.remove(name);
+  }
+}
+
+void LittleFSSpoolStorage::path(char *dest, size_t size, uint32_t block)
+{
+  snprintf(dest, size, "%s/%lu", _directory, (unsigned long)block);
+}
+
+#endif // USE_SAMPLE_SPOOL
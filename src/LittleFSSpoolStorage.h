@@ -0,0 +1,42 @@
+#ifndef LITTLEFS_SPOOL_STORAGE_H
+#define LITTLEFS_SPOOL_STORAGE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "SpoolStorage.h"
+
+#if USE_SAMPLE_SPOOL
+
+/**
+ * Spool storage on LittleFS, one file per block in a directory (e.g. /spool/12).
+ */
+class LittleFSSpoolStorage : public SpoolStorage
+{
+public:
+  /**
+   * Creates a new instance of the LittleFSSpoolStorage class.
+   *
+   * @param directory The directory of the files, e.g. "/spool". It must outlive the instance.
+   */
+  LittleFSSpoolStorage(const char *directory);
+
+  /**
+   * Mounts LittleFS, formatting it the first time, and creates the directory.
+   */
+  bool begin() override;
+  bool find(uint32_t *first, uint32_t *last) override;
+  uint32_t size(uint32_t block) override;
+  bool read(uint32_t block, uint32_t offset, void *dest, uint32_t length) override;
+  bool append(uint32_t block, const void *data, uint32_t length) override;
+  void remove(uint32_t block) override;
+
+private:
+  const char *_directory;
+
+private:
+  void path(char *dest, size_t size, uint32_t block);
+};
+
+#endif // USE_SAMPLE_SPOOL
+
+#endif // LITTLEFS_SPOOL_STORAGE_H
@@ -0,0 +1,121 @@
+#ifndef LOG_BUFFER_H
+#define LOG_BUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/**
+ * Lock-free ring buffer of log lines for any number of producers (the tasks that log) and one consumer (the task
+ * that writes them out). Each slot carries a sequence number telling whether it is free, being written or ready,
+ * so a producer claims a slot with a single compare-and-swap and never waits for another one.
+ * When the buffer is full the line is dropped and counted, logging never blocks.
+ *
+ * This file does not depend on Arduino so that it can be built and stress tested on the host with threads.
+ *
+ * @tparam Capacity The number of lines that can be stored, must be a power of two.
+ * @tparam Length The size of a line including the terminating null, longer lines are truncated.
+ */
+template <uint32_t Capacity, uint32_t Length>
+class LogBuffer
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  LogBuffer() : _head(0), _tail(0), _dropped(0)
+  {
+    for (uint32_t i = 0; i < Capacity; i++)
+    {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Adds a line. May be called by any producer.
+   *
+   * @param level The level of the line.
+   * @param text The line, truncated to Length - 1 characters.
+   * @return true if the line was added, false if the buffer is full (the line is counted as dropped).
+   */
+  bool push(uint8_t level, const char *text)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+      slot = &_slots[head & (Capacity - 1)];
+      int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - head);
+      if (diff == 0)
+      {
+        // the slot is free, it is ours if no other producer took it meanwhile (head is reloaded otherwise)
+        if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        // the slot still holds the line of the previous round
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        head = _head.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->level = level;
+    size_t length = strlen(text);
+    if (length > Length - 1)
+    {
+      length = Length - 1;
+    }
+    memcpy(slot->text, text, length);
+    slot->text[length] = '\0';
+    slot->sequence.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest line. Must only be called by the consumer.
+   *
+   * @param level Receives the level of the line.
+   * @param text Receives the line, must hold Length characters.
+   * @return true if a line was removed, false if the buffer is empty or the oldest line is still being written.
+   */
+  bool pop(uint8_t *level, char *text)
+  {
+    Slot &slot = _slots[_tail & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != _tail + 1)
+    {
+      return false;
+    }
+
+    *level = slot.level;
+    memcpy(text, slot.text, Length);
+    slot.sequence.store(_tail + Capacity, std::memory_order_release); // free for the next round
+    _tail++;
+    return true;
+  }
+
+  /**
+   * Returns the number of lines that could not be added because the buffer was full.
+   */
+  inline uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint32_t> sequence; // the position it is free for, or that position + 1 once the line is ready
+    uint8_t level;
+    char text[Length];
+  };
+
+  Slot _slots[Capacity];
+  std::atomic<uint32_t> _head; // next position to claim, shared by the producers
+  uint32_t _tail; // next position to read, owned by the consumer
+  std::atomic<uint32_t> _dropped;
+};
+
+#endif // LOG_BUFFER_H
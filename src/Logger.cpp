@@ -0,0 +1,80 @@
+#include "Logger.h"
+
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+Logger *Logger::_instance = nullptr;
+
+Logger::Logger() : _reportedDropped(0)
+{
+  _instance = this;
+}
+
+Logger::~Logger()
+{
+  _instance = nullptr;
+}
+
+void Logger::begin()
+{
+  // the lowest priority, the messages are written whenever nothing else has to run
+  xTaskCreate(task, "log", LOG_TASK_STACK_SIZE, this, tskIDLE_PRIORITY, nullptr);
+}
+
+void Logger::drain()
+{
+  uint8_t level;
+  char text[LOG_LINE_LENGTH];
+  while (_buffer.pop(&level, text))
+  {
+    if (level == LOG_LEVEL_ERROR)
+    {
+      Serial.print(F("Error: "));
+    }
+    else if (level == LOG_LEVEL_WARN)
+    {
+      Serial.print(F("Warning: "));
+    }
+    Serial.println(text);
+  }
+
+  uint32_t dropped = _buffer.dropped();
+  if (dropped != _reportedDropped)
+  {
+    Serial.print(dropped - _reportedDropped);
+    Serial.println(F(" log messages dropped"));
+    _reportedDropped = dropped;
+  }
+}
+
+void Logger::write(uint8_t level, uint32_t suppressed, const char *format, ...)
+{
+  Logger *logger = _instance;
+  if (!logger)
+  {
+    return;
+  }
+
+  // formatted on the stack of the caller, the buffer only copies the result
+  char text[LOG_LINE_LENGTH];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (suppressed > 0 && length >= 0 && (size_t)length < sizeof(text))
+  {
+    snprintf(text + length, sizeof(text) - length, " (%lu repeats suppressed)", (unsigned long)suppressed);
+  }
+  logger->_buffer.push(level, text);
+}
+
+void Logger::task(void *param)
+{
+  Logger *logger = (Logger *)param;
+  for (;;)
+  {
+    logger->drain();
+    vTaskDelay(pdMS_TO_TICKS(LOG_TASK_INTERVAL_MILLIS));
+  }
+}
@@ -0,0 +1,144 @@
+#include "config.h"
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "LogBuffer.h"
+
+/**
+ * Paces the messages of one call site: a message is let through at most once every LOG_RATE_LIMIT_MILLIS and the
+ * repeats in between are counted, so that a failing sensor or a dropped connection does not flood Serial.
+ * The counts are only approximate when the same call site is reached from several tasks at once.
+ */
+class LogLimiter
+{
+public:
+  LogLimiter() : _logged(false), _last(0), _suppressed(0) {}
+
+  /**
+   * Returns true if the message should be logged now.
+   *
+   * @param now The current time in milliseconds.
+   * @param suppressed Receives the number of repeats suppressed since the message was last logged.
+   */
+  bool allow(uint32_t now, uint32_t *suppressed)
+  {
+    if (_logged && now - _last < LOG_RATE_LIMIT_MILLIS)
+    {
+      _suppressed++;
+      return false;
+    }
+
+    *suppressed = _suppressed;
+    _logged = true;
+    _last = now;
+    _suppressed = 0;
+    return true;
+  }
+
+private:
+  bool _logged;
+  uint32_t _last;
+  uint32_t _suppressed;
+};
+
+/**
+ * Queues the log messages so that the code logging them never waits for Serial, see the LOG_* macros below.
+ *
+ * The messages are formatted by the caller into a lock-free buffer (see LogBuffer.h) and written to Serial later
+ * by drain(), either from a task of the lowest priority started by begin() or, when Serial also carries the samples,
+ * from the code writing the samples so that a message never ends up in the middle of one.
+ */
+class Logger
+{
+public:
+  /**
+   * Creates a new instance of the Logger class.
+   * Please note that only one instance of the class can be initialized at the same time.
+   */
+  Logger();
+
+  /**
+   * Cleanup resources created and managed by the Logger class.
+   */
+  ~Logger();
+
+  /**
+   * Starts the task writing the messages out. Without it, drain() must be called periodically.
+   */
+  void begin();
+
+  /**
+   * Writes the queued messages to Serial, and how many were dropped if any.
+   */
+  void drain();
+
+  /**
+   * Returns the number of messages dropped because the buffer was full.
+   */
+  inline uint32_t dropped() const { return _buffer.dropped(); }
+
+  /**
+   * Formats and queues a message. Use the LOG_* macros rather than calling this directly.
+   *
+   * @param level The level of the message, one of LOG_LEVEL_*.
+   * @param suppressed The number of repeats suppressed before it, see LogLimiter.
+   * @param format The printf format of the message.
+   */
+  static void write(uint8_t level, uint32_t suppressed, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+  /**
+   * Returns existing instance (singleton) of the Logger class.
+   * It may be a null pointer if the Logger object was never constructed or it was destroyed.
+   */
+  inline static Logger *instance() { return _instance; }
+
+private:
+  LogBuffer<LOG_BUFFER_CAPACITY, LOG_LINE_LENGTH> _buffer;
+  uint32_t _reportedDropped;
+
+  /// Living instance of the Logger class. It can be nullptr.
+  static Logger *_instance;
+
+private:
+  static void task(void *param);
+};
+
+// Logs a printf-style message at the level, rate limited per call site. Messages above LOG_LEVEL compile to nothing.
+#define LOG_AT(level, ...)                                    \
+  do                                                          \
+  {                                                           \
+    static LogLimiter _logLimiter;                            \
+    uint32_t _logSuppressed;                                  \
+    if (_logLimiter.allow(millis(), &_logSuppressed))         \
+    {                                                         \
+      Logger::write(level, _logSuppressed, __VA_ARGS__);      \
+    }                                                         \
+  } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,64 @@
+#ifndef LOOP_STATS_H
+#define LOOP_STATS_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Latency counters for a loop (the main loop or a task loop).
+ * Each iteration is timed by the caller and recorded here. The values are written by a single task, the one
+ * running the loop, other tasks may read them and ask for them to be cleared at any time.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class LoopStats
+{
+public:
+  LoopStats() : _iterations(0), _last(0), _max(0), _average(0), _total(0), _resetRequested(false) {}
+
+  /**
+   * Records the duration of an iteration. Only the task running the loop may call this.
+   *
+   * @param durationUs The duration of the iteration in microseconds.
+   */
+  void record(uint32_t durationUs)
+  {
+    uint32_t iterations = _iterations.load(std::memory_order_relaxed);
+    uint32_t max = _max.load(std::memory_order_relaxed);
+    if (_resetRequested.exchange(false, std::memory_order_acquire))
+    {
+      iterations = 0;
+      max = 0;
+      _total = 0;
+    }
+
+    iterations++;
+    _total += durationUs;
+    _iterations.store(iterations, std::memory_order_relaxed);
+    _last.store(durationUs, std::memory_order_relaxed);
+    _max.store(durationUs > max ? durationUs : max, std::memory_order_relaxed);
+    // the 64-bit total could be torn if read by another task, the average is published as 32 bits instead
+    _average.store((uint32_t)(_total / iterations), std::memory_order_relaxed);
+  }
+
+  /**
+   * Clears the maximum and average, e.g. after they have been reported. Any task may call this: the counters
+   * are cleared by the task running the loop when it records its next iteration, until then they are unchanged.
+   */
+  void requestReset() { _resetRequested.store(true, std::memory_order_release); }
+
+  inline uint32_t iterations() const { return _iterations.load(std::memory_order_relaxed); }
+  inline uint32_t last() const { return _last.load(std::memory_order_relaxed); }
+  inline uint32_t max() const { return _max.load(std::memory_order_relaxed); }
+  inline uint32_t average() const { return _average.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> _iterations;
+  std::atomic<uint32_t> _last;
+  std::atomic<uint32_t> _max;
+  std::atomic<uint32_t> _average;
+  uint64_t _total; // only accessed by the task running the loop
+  std::atomic<bool> _resetRequested;
+};
+
+#endif // LOOP_STATS_H
@@ -0,0 +1,134 @@
+#include "Profiler.h"
+
+#if USE_PROFILER
+
+#include <stdio.h>
+
+Profiler *Profiler::_instance = nullptr;
+
+Profiler::Profiler(Clock clock, Track track) : _clock(clock), _track(track), _recorded(0), _spanCount(0)
+{
+  _instance = this;
+}
+
+Profiler::~Profiler()
+{
+  _instance = nullptr;
+}
+
+int8_t Profiler::spanId(const char *name)
+{
+  // there are only a few spans, comparing the addresses is cheaper than hashing
+  for (uint8_t i = 0; i < _spanCount; i++)
+  {
+    if (_spans[i].name == name)
+    {
+      return i;
+    }
+  }
+  if (_spanCount >= PROFILER_MAX_SPANS)
+  {
+    return -1;
+  }
+
+  Span &span = _spans[_spanCount];
+  span.name = name;
+  span.count = 0;
+  span.max = 0;
+  for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+  {
+    span.buckets[i] = 0;
+  }
+  return _spanCount++;
+}
+
+void Profiler::record(const char *name, uint32_t start, uint32_t duration)
+{
+  uint8_t track = _track ? _track() : 0;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  int8_t id = spanId(name);
+  if (id < 0)
+  {
+    return;
+  }
+
+  Span &span = _spans[id];
+  span.count++;
+  if (duration > span.max)
+  {
+    span.max = duration;
+  }
+  uint8_t bucket = 0;
+  while (bucket < PROFILER_BUCKETS - 1 && (duration >> (bucket + 1)) != 0)
+  {
+    bucket++;
+  }
+  span.buckets[bucket]++;
+
+  Event &event = _events[_recorded % PROFILER_TRACE_CAPACITY];
+  event.start = start;
+  event.duration = duration;
+  event.span = (uint8_t)id;
+  event.track = track;
+  _recorded++;
+}
+
+void Profiler::writeTrace(Sink sink, void *context)
+{
+  // the ring is written under the lock, so the spans that end meanwhile wait for it
+  std::lock_guard<std::mutex> lock(_mutex);
+  char buffer[128];
+  sink("{\"traceEvents\":[", context);
+  uint32_t count = _recorded < PROFILER_TRACE_CAPACITY ? _recorded : PROFILER_TRACE_CAPACITY;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const Event &event = _events[(_recorded - count + i) % PROFILER_TRACE_CAPACITY];
+    // complete events ("X") with the times in microseconds, as expected by the format
+    snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":0,\"tid\":%u}",
+             i > 0 ? "," : "", _spans[event.span].name, (unsigned long)event.start, (unsigned long)event.duration,
+             event.track);
+    sink(buffer, context);
+  }
+  sink("]}", context);
+}
+
+void Profiler::writeSummary(Sink sink, void *context)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  char buffer[128];
+  sink("{\"profile\":[", context);
+  for (uint8_t i = 0; i < _spanCount; i++)
+  {
+    const Span &span = _spans[i];
+    snprintf(buffer, sizeof(buffer), "%s{\"span\":\"%s\",\"count\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+             i > 0 ? "," : "", span.name, (unsigned long)span.count, (unsigned long)percentile(span, 50),
+             (unsigned long)percentile(span, 99), (unsigned long)span.max);
+    sink(buffer, context);
+  }
+  sink("]}", context);
+}
+
+uint32_t Profiler::percentile(const Span &span, uint8_t percent)
+{
+  if (span.count == 0)
+  {
+    return 0;
+  }
+
+  // the bucket holding the rank, reported as its upper bound but never above the longest duration
+  uint64_t rank = ((uint64_t)span.count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (uint8_t i = 0; i < PROFILER_BUCKETS; i++)
+  {
+    seen += span.buckets[i];
+    if (seen >= rank)
+    {
+      uint32_t upper = (uint32_t)((2ULL << i) - 1);
+      return upper < span.max ? upper : span.max;
+    }
+  }
+  return span.max;
+}
+
+#endif // USE_PROFILER
@@ -0,0 +1,164 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Set USE_PROFILER to 1 to time the phases of the boot and the loop, see PROFILE_SCOPE
+#ifndef USE_PROFILER
+#define USE_PROFILER 0
+#endif
+
+#if USE_PROFILER
+
+#include <mutex>
+
+// Number of spans kept for the trace, the oldest are overwritten
+#ifndef PROFILER_TRACE_CAPACITY
+#define PROFILER_TRACE_CAPACITY 256
+#endif
+
+// Maximum number of distinct spans, the spans that do not fit are not recorded
+#ifndef PROFILER_MAX_SPANS
+#define PROFILER_MAX_SPANS 24
+#endif
+
+// Buckets of the histogram of each span, bucket i counts the durations of less than 2^(i+1) us (about 16 s for 24)
+#define PROFILER_BUCKETS 24
+
+/**
+ * Records how long the phases of the firmware take (spans) in a fixed-size trace ring and in a histogram per span.
+ *
+ * The trace can be written out as Chrome trace-event JSON (load it in chrome://tracing or https://ui.perfetto.dev),
+ * and the histograms summarised as the median and 99th percentile of each span. The percentiles are the upper
+ * bounds of the power of two buckets, i.e. within a factor of two, capped at the longest duration seen.
+ * Spans are named by string literals and told apart by their address, so each name must be a single literal.
+ * Spans may be recorded from several tasks, each is tagged with the track (e.g. the core) it ran on.
+ *
+ * This file does not depend on Arduino so that it can be used on the host; the clock is passed in.
+ */
+class Profiler
+{
+public:
+  typedef uint32_t (*Clock)();
+  typedef uint8_t (*Track)();
+  typedef void (*Sink)(const char *text, void *context);
+
+  /**
+   * Creates a new instance of the Profiler class.
+   * Please note that only one instance of the class can be initialized at the same time.
+   *
+   * @param clock Returns the current time in microseconds, e.g. micros().
+   * @param track Returns the track of the caller, e.g. the core it runs on, nullptr for a single track.
+   */
+  Profiler(Clock clock, Track track = nullptr);
+
+  /**
+   * Cleanup resources created and managed by the Profiler class.
+   */
+  ~Profiler();
+
+  /**
+   * Returns the current time in microseconds.
+   */
+  inline uint32_t now() const { return _clock(); }
+
+  /**
+   * Records a span.
+   *
+   * @param name The name of the span, a string literal.
+   * @param start When the span started in microseconds.
+   * @param duration How long the span took in microseconds.
+   */
+  void record(const char *name, uint32_t start, uint32_t duration);
+
+  /**
+   * Writes the spans of the trace ring as Chrome trace-event JSON, in pieces.
+   *
+   * @param sink Receives each piece of the JSON in order.
+   * @param context Passed to the sink.
+   */
+  void writeTrace(Sink sink, void *context);
+
+  /**
+   * Writes the count, median, 99th percentile and maximum of each span in microseconds as JSON, e.g.
+   * {"profile":[{"span":"ha.update","count":12,"p50":511,"p99":2047,"max":1480}]}
+   *
+   * @param sink Receives each piece of the JSON in order.
+   * @param context Passed to the sink.
+   */
+  void writeSummary(Sink sink, void *context);
+
+  /**
+   * Returns existing instance (singleton) of the Profiler class.
+   * It may be a null pointer if the Profiler object was never constructed or it was destroyed.
+   */
+  inline static Profiler *instance() { return _instance; }
+
+private:
+  struct Event
+  {
+    uint32_t start;
+    uint32_t duration;
+    uint8_t span;
+    uint8_t track;
+  };
+
+  struct Span
+  {
+    const char *name;
+    uint32_t count;
+    uint32_t max;
+    uint32_t buckets[PROFILER_BUCKETS];
+  };
+
+  Clock _clock;
+  Track _track;
+  std::mutex _mutex;
+  Event _events[PROFILER_TRACE_CAPACITY];
+  uint32_t _recorded; // spans recorded since boot, the ring holds the last PROFILER_TRACE_CAPACITY
+  Span _spans[PROFILER_MAX_SPANS];
+  uint8_t _spanCount;
+
+  /// Living instance of the Profiler class. It can be nullptr.
+  static Profiler *_instance;
+
+private:
+  int8_t spanId(const char *name);
+  static uint32_t percentile(const Span &span, uint8_t percent);
+};
+
+/**
+ * Times the scope it is declared in and records it as a span of the profiler, see PROFILE_SCOPE.
+ */
+class ProfileScope
+{
+public:
+  ProfileScope(const char *name) : _name(name), _start(Profiler::instance() ? Profiler::instance()->now() : 0) {}
+
+  ~ProfileScope()
+  {
+    Profiler *profiler = Profiler::instance();
+    if (profiler)
+    {
+      profiler->record(_name, _start, profiler->now() - _start);
+    }
+  }
+
+private:
+  const char *_name;
+  uint32_t _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Records the rest of the enclosing scope as a span named by the string literal, e.g. PROFILE_SCOPE("ha.update")
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif // USE_PROFILER
+
+#endif // PROFILER_H
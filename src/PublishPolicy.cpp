@@ -0,0 +1,51 @@
+#include "PublishPolicy.h"
+
+#include <math.h>
+
+PublishPolicy::PublishPolicy(const PublishPolicyConfig &config)
+    : _config(config), _sent(false), _value(0), _publishedAt(0), _direction(0)
+{
+}
+
+bool PublishPolicy::due(uint32_t now, float value) const
+{
+  if (!_sent || _config.maxIntervalMs == 0)
+  {
+    return true;
+  }
+
+  uint32_t elapsed = now - _publishedAt;
+  if (elapsed < _config.minIntervalMs)
+  {
+    return false;
+  }
+  if (elapsed >= _config.maxIntervalMs)
+  {
+    return true; // heartbeat
+  }
+
+  if (isnan(value) || isnan(_value))
+  {
+    return isnan(value) != isnan(_value);
+  }
+
+  float delta = value - _value;
+  float deadband = _config.deadband(_value);
+  int8_t direction = delta > 0 ? 1 : -1;
+  if (_direction != 0 && direction != _direction)
+  {
+    deadband += _config.hysteresis;
+  }
+  return fabsf(delta) > deadband;
+}
+
+void PublishPolicy::published(uint32_t now, float value)
+{
+  if (_sent && !isnan(value) && !isnan(_value) && value != _value)
+  {
+    _direction = value > _value ? 1 : -1;
+  }
+  _sent = true;
+  _value = value;
+  _publishedAt = now;
+}
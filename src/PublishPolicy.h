@@ -0,0 +1,72 @@
+#ifndef PUBLISH_POLICY_H
+#define PUBLISH_POLICY_H
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * When a value is worth publishing again.
+ */
+struct PublishPolicyConfig
+{
+  float absolute;         // smallest change that is published, in the unit of the value
+  float relative;         // smallest change that is published, as a fraction of the last published value
+  float hysteresis;       // extra change needed to reverse the direction of the last published change
+  uint32_t minIntervalMs; // a value is not published more often than this, 0 for no limit
+  uint32_t maxIntervalMs; // a value is published at least this often (heartbeat), 0 to publish every value
+
+  /**
+   * Returns the deadband around a value, the larger of the absolute and relative ones.
+   */
+  inline float deadband(float value) const { return fmaxf(absolute, relative * fabsf(value)); }
+};
+
+/**
+ * Decides whether a value should be published, based on how much it changed since it was last published
+ * and how long ago that was.
+ *
+ * The deadband is the larger of the absolute and relative ones. Changes within it are suppressed, so a steady
+ * value is only sent with the heartbeat. The hysteresis is added to the deadband when the value turns around,
+ * so a noisy channel (e.g. pH or EC) does not flap between two values. The first value, a value that becomes
+ * NaN and a value that stops being NaN are always published.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class PublishPolicy
+{
+public:
+  /**
+   * Creates a new instance of the PublishPolicy class, by default every value is published.
+   */
+  PublishPolicy(const PublishPolicyConfig &config = PublishPolicyConfig{0, 0, 0, 0, 0});
+
+  /**
+   * Returns true if the value should be published.
+   *
+   * @param now The current time in milliseconds.
+   * @param value The value.
+   */
+  bool due(uint32_t now, float value) const;
+
+  /**
+   * Records that a value was published.
+   *
+   * @param now The current time in milliseconds.
+   * @param value The value.
+   */
+  void published(uint32_t now, float value);
+
+  /**
+   * Forgets the last published value so that the next one is published whatever it is, e.g. after a reconnection.
+   */
+  inline void reset() { _sent = false; }
+
+private:
+  PublishPolicyConfig _config;
+  bool _sent;
+  float _value;          // the last published value
+  uint32_t _publishedAt; // when the last value was published
+  int8_t _direction;     // of the last published change: 1 up, -1 down, 0 none yet
+};
+
+#endif // PUBLISH_POLICY_H
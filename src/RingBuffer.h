@@ -0,0 +1,78 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Lock-free ring buffer for exactly one producer and one consumer (e.g. a task and the main loop, or an ISR and a task).
+ * Each index is only written by one side so no lock is needed, the atomics only order the accesses.
+ *
+ * This file does not depend on Arduino so that it can be built and stress tested on the host with threads.
+ *
+ * @tparam T The type of the items, copied in and out.
+ * @tparam Capacity The number of items that can be stored, must be a power of two.
+ */
+template <typename T, uint32_t Capacity>
+class RingBuffer
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  RingBuffer() : _head(0), _tail(0), _dropped(0) {}
+
+  /**
+   * Adds an item. Must only be called by the producer.
+   *
+   * @return true if the item was added, false if the buffer is full (the item is counted as dropped).
+   */
+  bool push(const T &item)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= Capacity)
+    {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    _items[head & (Capacity - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest item. Must only be called by the consumer.
+   *
+   * @return true if an item was removed, false if the buffer is empty.
+   */
+  bool pop(T *item)
+  {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+
+    *item = _items[tail & (Capacity - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns the number of items in the buffer. The value is only a snapshot when the other side is active.
+   */
+  inline uint32_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+  /**
+   * Returns the number of items that could not be added because the buffer was full.
+   */
+  inline uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+  T _items[Capacity];
+  std::atomic<uint32_t> _head; // next slot to write, owned by the producer
+  std::atomic<uint32_t> _tail; // next slot to read, owned by the consumer
+  std::atomic<uint32_t> _dropped;
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,63 @@
+#include "SampleClock.h"
+
+SampleClock::SampleClock(uint32_t periodMs)
+    : _periodMs(periodMs), _deadline(0), _lastJitter(0), _maxJitter(0), _missed(0)
+{
+}
+
+void SampleClock::begin(uint32_t now)
+{
+  _deadline = now + _periodMs;
+}
+
+void SampleClock::align(uint32_t now, uint64_t wallMs)
+{
+  // the deadline is moved to the boundary nearest to it, i.e. by at most half a period,
+  // so that a sample is never taken twice around the same boundary
+  uint64_t deadlineWall = wallMs + nextIn(now);
+  uint64_t boundary = (deadlineWall + _periodMs / 2) / _periodMs * _periodMs;
+  if (boundary <= wallMs)
+  {
+    boundary += _periodMs;
+  }
+  _deadline = now + (uint32_t)(boundary - wallMs);
+}
+
+void SampleClock::setPeriod(uint32_t now, uint32_t periodMs)
+{
+  uint32_t previous = _deadline - _periodMs;
+  _periodMs = periodMs;
+  _deadline = previous + periodMs;
+  if ((int32_t)(now - _deadline) > 0)
+  {
+    _deadline = now; // a shorter period that is already over, the next tick is due straight away
+  }
+}
+
+bool SampleClock::due(uint32_t now)
+{
+  // subtraction keeps the comparison correct when millis() wraps around
+  int32_t late = (int32_t)(now - _deadline);
+  if (late < 0)
+  {
+    return false;
+  }
+
+  _lastJitter = late;
+  if (_lastJitter > _maxJitter)
+  {
+    _maxJitter = _lastJitter;
+  }
+
+  // the next deadline is always a whole number of periods after the previous one
+  uint32_t periods = (uint32_t)late / _periodMs;
+  _missed += periods;
+  _deadline += (periods + 1) * _periodMs;
+  return true;
+}
+
+uint32_t SampleClock::nextIn(uint32_t now) const
+{
+  int32_t remaining = (int32_t)(_deadline - now);
+  return remaining > 0 ? remaining : 0;
+}
@@ -0,0 +1,90 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * Deadline based clock that ticks once per period without accumulating drift.
+ *
+ * Each deadline is derived from the previous deadline rather than from the time the tick was handled,
+ * so a late tick does not delay the ones that follow. How late each tick was handled is recorded as jitter.
+ *
+ * This file does not depend on Arduino so that it can be used on the host; the time is passed in.
+ */
+class SampleClock
+{
+public:
+  /**
+   * Creates a new instance of the SampleClock class.
+   *
+   * @param periodMs The period of the clock in milliseconds.
+   */
+  SampleClock(uint32_t periodMs);
+
+  /**
+   * Starts the clock. The first tick is one period from now.
+   *
+   * @param now The current time in milliseconds.
+   */
+  void begin(uint32_t now);
+
+  /**
+   * Moves the next deadline to the nearest wall-clock boundary (e.g. a whole minute for a 60 second period)
+   * so that samples from different devices line up. Call again from time to time to follow the wall clock.
+   *
+   * @param now The current time in milliseconds.
+   * @param wallMs The current wall-clock time in milliseconds since the epoch.
+   */
+  void align(uint32_t now, uint64_t wallMs);
+
+  /**
+   * Changes the period. The next deadline is one new period after the previous one, or now if that has passed.
+   *
+   * @param now The current time in milliseconds.
+   * @param periodMs The new period in milliseconds.
+   */
+  void setPeriod(uint32_t now, uint32_t periodMs);
+
+  /**
+   * Returns the period in milliseconds.
+   */
+  inline uint32_t period() const { return _periodMs; }
+
+  /**
+   * Checks whether the deadline has been reached and if so, moves to the next one.
+   * Periods that were missed entirely (e.g. the loop was stalled) are skipped and counted.
+   *
+   * @param now The current time in milliseconds.
+   * @return true once per deadline.
+   */
+  bool due(uint32_t now);
+
+  /**
+   * Returns the number of milliseconds until the next deadline, 0 if it has been reached.
+   */
+  uint32_t nextIn(uint32_t now) const;
+
+  /**
+   * Returns how late (in milliseconds) the last deadline was handled.
+   */
+  inline uint32_t lastJitter() const { return _lastJitter; }
+
+  /**
+   * Returns the largest jitter since the clock was started.
+   */
+  inline uint32_t maxJitter() const { return _maxJitter; }
+
+  /**
+   * Returns the number of periods that were skipped because they were handled too late.
+   */
+  inline uint32_t missed() const { return _missed; }
+
+private:
+  uint32_t _periodMs;
+  uint32_t _deadline;
+  uint32_t _lastJitter;
+  uint32_t _maxJitter;
+  uint32_t _missed;
+};
+
+#endif // SAMPLE_CLOCK_H
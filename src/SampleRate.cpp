@@ -0,0 +1,76 @@
+#include "SampleRate.h"
+
+#if SAMPLE_ADAPTIVE
+
+#include "SensorRegistry.h"
+
+FuFarmSampleRate::FuFarmSampleRate()
+    : interval(SAMPLE_WINDOW_MILLIS, SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS, SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS,
+               SAMPLE_ADAPTIVE_QUIET_SAMPLES),
+      previousMillis(0), hasPrevious(false)
+{
+}
+
+template <typename T>
+bool FuFarmSampleRate::moved(T from, T to, bool signedValue, const PublishPolicyConfig &policy,
+                             uint32_t elapsed) const
+{
+  // a sensor that starts or stops failing is not a change of what it measures
+  if (!sensorValueValid(from, signedValue) || !sensorValueValid(to, signedValue))
+  {
+    return false;
+  }
+  return interval.exceeds((float)from, (float)to, policy.deadband((float)from), elapsed);
+}
+
+#if SENSORS_WINDOW_STATS
+// The reads of the window spread wider than the deadband, e.g. a pump cycle shorter than the window
+static bool spread(const WindowStats &stats, const PublishPolicyConfig &policy)
+{
+  float deadband = policy.deadband(stats.mean());
+  return deadband > 0 && stats.max() - stats.min() > deadband;
+}
+#endif
+
+uint32_t FuFarmSampleRate::update(const FuFarmSensorsData *data, uint32_t now)
+{
+  bool moving = false;
+  if (hasPrevious)
+  {
+    uint32_t elapsed = now - previousMillis;
+#define FUFARM_RATE_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, ...) \
+  moving = moving || moved(previous.field, data->field, sensorsSigned(deviceClass), policy, elapsed);
+#define FUFARM_RATE_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, ...) \
+  for (uint8_t i = 0; i < data->count && i < previous.count; i++)                                             \
+  {                                                                                                           \
+    moving = moving || moved(previous.field[i], data->field[i], sensorsSigned(deviceClass), policy, elapsed); \
+  }
+#define FUFARM_RATE_BINARY(...)
+    FUFARM_SENSORS(FUFARM_RATE_NUMBER, FUFARM_RATE_PROBES, FUFARM_RATE_BINARY)
+#undef FUFARM_RATE_NUMBER
+#undef FUFARM_RATE_PROBES
+#undef FUFARM_RATE_BINARY
+  }
+
+#if SENSORS_WINDOW_STATS
+#define FUFARM_RATE_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, ...) \
+  moving = moving || spread(data->stats.id, policy);
+#define FUFARM_RATE_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, ...) \
+  for (uint8_t i = 0; i < data->count; i++)                                                                   \
+  {                                                                                                           \
+    moving = moving || spread(data->stats.id[i], policy);                                                     \
+  }
+#define FUFARM_RATE_BINARY(...)
+  FUFARM_SENSORS(FUFARM_RATE_NUMBER, FUFARM_RATE_PROBES, FUFARM_RATE_BINARY)
+#undef FUFARM_RATE_NUMBER
+#undef FUFARM_RATE_PROBES
+#undef FUFARM_RATE_BINARY
+#endif
+
+  previous = *data;
+  previousMillis = now;
+  hasPrevious = true;
+  return interval.update(moving);
+}
+
+#endif // SAMPLE_ADAPTIVE
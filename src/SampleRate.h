@@ -0,0 +1,56 @@
+#include "config.h"
+
+#ifndef SAMPLE_RATE_H
+#define SAMPLE_RATE_H
+
+#if SAMPLE_ADAPTIVE
+
+#include "sensors.h"
+#include "AdaptiveInterval.h"
+#include "PublishPolicy.h"
+
+/**
+ * Adapts the sample window to how fast the values move, between SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS and
+ * SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS (see AdaptiveInterval.h).
+ *
+ * A sample is volatile when any value moved by more than its publish deadband (see SensorRegistry.h) per
+ * SAMPLE_WINDOW_MILLIS since the previous sample or, with SENSORS_WINDOW_STATS, when the reads of its window spread
+ * wider than the deadband. All the sensors are read together, so the value that moves sets the window for all of
+ * them; the deadbands still keep the values that are quiet from being published more often.
+ */
+class FuFarmSampleRate
+{
+public:
+  /**
+   * Creates a new instance of the FuFarmSampleRate class, starting with SAMPLE_WINDOW_MILLIS.
+   */
+  FuFarmSampleRate();
+
+  /**
+   * Tightens or relaxes the window after a sample.
+   *
+   * @param data The sample.
+   * @param now The time of the sample in milliseconds.
+   * @return The window until the next sample in milliseconds.
+   */
+  uint32_t update(const FuFarmSensorsData *data, uint32_t now);
+
+  /**
+   * Returns the current window in milliseconds.
+   */
+  inline uint32_t window() const { return interval.interval(); }
+
+private:
+  AdaptiveInterval interval;
+  FuFarmSensorsData previous;
+  uint32_t previousMillis;
+  bool hasPrevious;
+
+private:
+  template <typename T>
+  bool moved(T from, T to, bool signedValue, const PublishPolicyConfig &policy, uint32_t elapsed) const;
+};
+
+#endif // SAMPLE_ADAPTIVE
+
+#endif // SAMPLE_RATE_H
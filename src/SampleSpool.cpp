@@ -0,0 +1,53 @@
+#include "SampleSpool.h"
+#include "Logger.h"
+
+#if USE_SAMPLE_SPOOL
+
+#include <time.h>
+
+#define SPOOL_DIRECTORY "/spool"
+#define WALL_CLOCK_VALID_SECONDS 1609459200 // 2021-01-01, anything earlier means the time is not set yet
+
+// the samples are timestamped before they are written to flash, their millis() are meaningless after a reboot
+SampleSpool::SampleSpool() : _storage(SPOOL_DIRECTORY), _spool(_storage, &SampleSpool::timestamp)
+{
+}
+
+void SampleSpool::begin()
+{
+  if (!_spool.begin())
+  {
+    LOG_WARN("Could not mount LittleFS, samples are only spooled in RAM");
+    return;
+  }
+  if (_spool.size() > 0)
+  {
+    LOG_INFO("Samples spooled by the previous boot: %lu", (unsigned long)_spool.size());
+  }
+}
+
+void SampleSpool::push(const FuFarmSensorsData *data)
+{
+  SpooledSample sample;
+  sample.time = 0;
+  sample.millis = millis();
+  sample.data = *data;
+  timestamp(&sample);
+  _spool.push(sample);
+}
+
+void SampleSpool::timestamp(SpooledSample *sample)
+{
+  if (sample->time != 0)
+  {
+    return;
+  }
+
+  time_t now = time(nullptr);
+  if (now >= WALL_CLOCK_VALID_SECONDS)
+  {
+    sample->time = now - (millis() - sample->millis) / 1000;
+  }
+}
+
+#endif // USE_SAMPLE_SPOOL
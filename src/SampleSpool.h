@@ -0,0 +1,92 @@
+#ifndef SAMPLE_SPOOL_H
+#define SAMPLE_SPOOL_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensors.h"
+#include "Spool.h"
+#include "LittleFSSpoolStorage.h"
+
+#if USE_SAMPLE_SPOOL
+
+/**
+ * A sample waiting to be published.
+ */
+struct SpooledSample
+{
+  // seconds since the epoch, 0 if the wall clock was not known when the sample was taken
+  uint32_t time;
+
+  // millis() when the sample was taken, used to timestamp it once the wall clock is known
+  uint32_t millis;
+
+  FuFarmSensorsData data;
+};
+
+/**
+ * Bounded store-and-forward queue of the samples taken while the broker is unreachable.
+ *
+ * Samples are kept in a RAM ring first. When it is full, the oldest SAMPLE_SPOOL_BLOCK_SAMPLES are written to
+ * a file on LittleFS (/spool/<number>) so that a long outage or a reboot does not lose them. When there are more
+ * than SAMPLE_SPOOL_FLASH_BLOCKS files, the oldest one is deleted. The samples always come out oldest first.
+ * See Spool.h for how the files are written and replayed.
+ */
+class SampleSpool
+{
+public:
+  /**
+   * Creates a new instance of the SampleSpool class.
+   */
+  SampleSpool();
+
+  /**
+   * Mounts LittleFS (formatting it if needed) and finds the samples left by a previous boot.
+   */
+  void begin();
+
+  /**
+   * Adds a sample, timestamped with the wall clock if it is known.
+   *
+   * @param data The sample.
+   */
+  void push(const FuFarmSensorsData *data);
+
+  /**
+   * Gets the oldest sample without removing it.
+   *
+   * @param dest The destination for the sample.
+   * @return false if the spool is empty.
+   */
+  inline bool peek(SpooledSample *dest) { return _spool.peek(dest); }
+
+  /**
+   * Removes the oldest sample, once it has been published.
+   */
+  inline void drop() { _spool.drop(); }
+
+  /**
+   * Writes the samples held in RAM to flash, e.g. before a reboot.
+   */
+  inline void save() { _spool.save(); }
+
+  /**
+   * Returns the number of samples in the spool.
+   */
+  inline uint32_t size() const { return _spool.size(); }
+
+  /**
+   * Returns the number of samples that were lost because the spool was full or could not be written.
+   */
+  inline uint32_t dropped() const { return _spool.dropped(); }
+
+private:
+  LittleFSSpoolStorage _storage;
+  Spool<SpooledSample, SAMPLE_SPOOL_RAM_SAMPLES, SAMPLE_SPOOL_BLOCK_SAMPLES, SAMPLE_SPOOL_FLASH_BLOCKS> _spool;
+
+private:
+  static void timestamp(SpooledSample *sample);
+};
+
+#endif // USE_SAMPLE_SPOOL
+
+#endif // SAMPLE_SPOOL_H
@@ -0,0 +1,158 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include "config.h"
+
+/**
+ * Registry of the values published for the configured sensors.
+ *
+ * FUFARM_SENSORS(NUMBER, PROBES, BINARY) expands to one entry per configured value, in the order they appear
+ * in the JSON output. The Home Assistant entities, their configuration and updates, and the JSON serialization
+ * are generated from it at compile time, so a new value is described here once instead of in every consumer.
+ *
+ * NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, policy, group)
+ * PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, policy, group)
+ *   like NUMBER for an array with one value per probe, of which count are valid and at most max exist;
+ *   the first probe uses id/json/name as they are and the others are numbered from 2
+ *   (e.g. tempwet2 in JSON, "<name> 2" in Home Assistant).
+ * BINARY(id, field, json, deviceClass, name, icon, bit, policy, group)
+ *
+ * - id: the member holding the Home Assistant entity and the suffix of its unique id
+ * - field: the path of the value in FuFarmSensorsData
+ * - json: the key in the JSON output
+ * - deviceClass, unit, stateClass, name, icon: Home Assistant properties, nullptr to leave unset
+ *   Device classes are listed at https://www.home-assistant.io/integrations/sensor/#device-class
+ * - precision: the number of decimals (HASensorNumber::NumberPrecision)
+ * - bit: the position of the value in the presence bitmap of the binary serial frames (see SerialFrame.h).
+ *   It must not change once assigned and must increase in the order of the entries.
+ * - policy: when the value is published to Home Assistant again (see PublishPolicy.h),
+ *   PUBLISH_POLICY(absolute deadband, relative deadband, hysteresis)
+ * - group: the group of sensors the value is read with (SENSORS_GROUP_*), each group has its own interval
+ *   with SENSORS_SCHEDULE
+ */
+
+// Groups of sensors that are read together
+#define SENSORS_GROUP_AIR 0x01         // DHT22 or AHT20
+#define SENSORS_GROUP_AIR_QUALITY 0x02 // ENS160
+#define SENSORS_GROUP_TEMP_WET 0x04    // DS18S20
+#define SENSORS_GROUP_ANALOG 0x08      // light, CO2 and moisture
+#define SENSORS_GROUP_WATER 0x10       // EC and pH, which also take the temperatures for compensation
+#define SENSORS_GROUP_FLOW 0x20        // flow rate and total
+#define SENSORS_GROUP_WATER_LEVEL 0x40 // its state is current on every read
+#define SENSORS_GROUPS_ALL 0x7F
+
+#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
+#define FUFARM_SENSORS_AIR(NUMBER, PROBES, BINARY) \
+  NUMBER(temperature, temperature.air, "tempair", "temperature", "°C", nullptr, nullptr, nullptr, PrecisionP2, 0, PUBLISH_POLICY(0.1f, 0, 0), SENSORS_GROUP_AIR) \
+  NUMBER(humidity, humidity, "humidity", "humidity", "%", nullptr, nullptr, nullptr, PrecisionP2, 1, PUBLISH_POLICY(0.5f, 0, 0), SENSORS_GROUP_AIR)
+#else
+#define FUFARM_SENSORS_AIR(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_ENS160
+// no unit for AQI, it is documented as unitless
+#define FUFARM_SENSORS_AIR_QUALITY(NUMBER, PROBES, BINARY) \
+  NUMBER(aqi, airQuality.index, "aqi", "aqi", nullptr, nullptr, nullptr, nullptr, PrecisionP0, 2, PUBLISH_POLICY(0, 0, 0), SENSORS_GROUP_AIR_QUALITY) \
+  NUMBER(tvoc, airQuality.tvoc, "tvoc", "volatile_organic_compounds_parts", "ppb", nullptr, nullptr, nullptr, PrecisionP0, 3, PUBLISH_POLICY(5, 0.05f, 0), SENSORS_GROUP_AIR_QUALITY) \
+  NUMBER(eco2, airQuality.eco2, "eco2", "carbon_dioxide", "ppm", nullptr, "Carbon Dioxide (Equivalent)", nullptr, PrecisionP0, 4, PUBLISH_POLICY(10, 0.02f, 0), SENSORS_GROUP_AIR_QUALITY)
+#else
+#define FUFARM_SENSORS_AIR_QUALITY(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_TEMP_WET
+#define FUFARM_SENSORS_TEMP_WET(NUMBER, PROBES, BINARY) \
+  PROBES(liquidtemp, temperature.wet, temperature.wetCount, SENSORS_DS18S20_MAX_PROBES, "tempwet", "temperature", "°C", "Liquid Temperature", PrecisionP2, 5, PUBLISH_POLICY(0.1f, 0, 0), SENSORS_GROUP_TEMP_WET)
+#else
+#define FUFARM_SENSORS_TEMP_WET(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_CO2
+#define FUFARM_SENSORS_CO2(NUMBER, PROBES, BINARY) \
+  NUMBER(co2, co2, "co2", "carbon_dioxide", "ppm", nullptr, nullptr, nullptr, PrecisionP0, 6, PUBLISH_POLICY(10, 0.02f, 0), SENSORS_GROUP_ANALOG)
+#else
+#define FUFARM_SENSORS_CO2(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_EC
+// As of 2025-Mar-28, Home Assistant does not have a device class for EC, we create a custom one
+#define FUFARM_SENSORS_EC(NUMBER, PROBES, BINARY) \
+  NUMBER(ec, ec, "ec", nullptr, "mS/cm", nullptr, "Electrical Conductivity", "mdi:waveform", PrecisionP2, 7, PUBLISH_POLICY(0.02f, 0.01f, 0.02f), SENSORS_GROUP_WATER)
+#else
+#define FUFARM_SENSORS_EC(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_PH
+#define FUFARM_SENSORS_PH(NUMBER, PROBES, BINARY) \
+  NUMBER(ph, ph, "ph", "ph", nullptr, nullptr, nullptr, nullptr, PrecisionP2, 8, PUBLISH_POLICY(0.02f, 0, 0.02f), SENSORS_GROUP_WATER)
+#else
+#define FUFARM_SENSORS_PH(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_FLOW
+// the default icon for flow is unknown so we set ours
+// total_increasing lets Home Assistant use the total in the water dashboard and cope with a reset to 0
+#define FUFARM_SENSORS_FLOW(NUMBER, PROBES, BINARY) \
+  NUMBER(flow, flow, "flow", "volume_flow_rate", "L/min", nullptr, nullptr, "mdi:waves-arrow-right", PrecisionP2, 9, PUBLISH_POLICY(0.05f, 0.05f, 0), SENSORS_GROUP_FLOW) \
+  NUMBER(flowTotal, flowTotal, "flow_total", "water", "L", "total_increasing", "Total Flow", "mdi:water-pump", PrecisionP2, 10, PUBLISH_POLICY(0.1f, 0, 0), SENSORS_GROUP_FLOW)
+#else
+#define FUFARM_SENSORS_FLOW(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_LIGHT
+// TODO: the sensor we are using does not support lux, we may want to consider using a custom class
+#define FUFARM_SENSORS_LIGHT(NUMBER, PROBES, BINARY) \
+  NUMBER(light, light, "light", "illuminance", "lx", nullptr, nullptr, nullptr, PrecisionP0, 11, PUBLISH_POLICY(10, 0.05f, 0), SENSORS_GROUP_ANALOG)
+#else
+#define FUFARM_SENSORS_LIGHT(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_MOISTURE
+#define FUFARM_SENSORS_MOISTURE(NUMBER, PROBES, BINARY) \
+  NUMBER(moisture, moisture, "moisture", "moisture", "%", nullptr, nullptr, nullptr, PrecisionP0, 12, PUBLISH_POLICY(1, 0, 1), SENSORS_GROUP_ANALOG)
+#else
+#define FUFARM_SENSORS_MOISTURE(NUMBER, PROBES, BINARY)
+#endif
+
+#ifdef HAVE_WATER_LEVEL_STATE
+#define FUFARM_SENSORS_WATER_LEVEL(NUMBER, PROBES, BINARY) \
+  BINARY(waterLevel, waterLevelState, "water_level", "moisture", "Sump Level Indicator", "mdi:cup-water", 13, PUBLISH_POLICY(0, 0, 0), SENSORS_GROUP_WATER_LEVEL)
+#else
+#define FUFARM_SENSORS_WATER_LEVEL(NUMBER, PROBES, BINARY)
+#endif
+
+// A publish policy with the default intervals, see PublishPolicy.h
+#define PUBLISH_POLICY(absolute, relative, hysteresis) \
+  PublishPolicyConfig { absolute, relative, hysteresis, PUBLISH_MIN_INTERVAL_MILLIS, PUBLISH_MAX_INTERVAL_MILLIS }
+
+// The number of decimals of a precision, e.g. FUFARM_DECIMALS(PrecisionP2) is 2
+#define FUFARM_DECIMALS(precision) FUFARM_DECIMALS_##precision
+#define FUFARM_DECIMALS_PrecisionP0 0
+#define FUFARM_DECIMALS_PrecisionP1 1
+#define FUFARM_DECIMALS_PrecisionP2 2
+#define FUFARM_DECIMALS_PrecisionP3 3
+
+constexpr bool sensorsStringsEqual(const char *a, const char *b)
+{
+  return *a == *b && (*a == '\0' || sensorsStringsEqual(a + 1, b + 1));
+}
+
+// Whether the values of a device class can be below zero, i.e. -1 is a reading rather than a failure
+// (see sensorValueValid()), e.g. sensorsSigned("temperature") is true
+constexpr bool sensorsSigned(const char *deviceClass)
+{
+  return deviceClass != nullptr && sensorsStringsEqual(deviceClass, "temperature");
+}
+
+#define FUFARM_SENSORS(NUMBER, PROBES, BINARY)     \
+  FUFARM_SENSORS_AIR(NUMBER, PROBES, BINARY)         \
+  FUFARM_SENSORS_AIR_QUALITY(NUMBER, PROBES, BINARY) \
+  FUFARM_SENSORS_TEMP_WET(NUMBER, PROBES, BINARY)    \
+  FUFARM_SENSORS_CO2(NUMBER, PROBES, BINARY)         \
+  FUFARM_SENSORS_EC(NUMBER, PROBES, BINARY)          \
+  FUFARM_SENSORS_PH(NUMBER, PROBES, BINARY)          \
+  FUFARM_SENSORS_FLOW(NUMBER, PROBES, BINARY)        \
+  FUFARM_SENSORS_LIGHT(NUMBER, PROBES, BINARY)       \
+  FUFARM_SENSORS_MOISTURE(NUMBER, PROBES, BINARY)    \
+  FUFARM_SENSORS_WATER_LEVEL(NUMBER, PROBES, BINARY)
+
+#endif // SENSOR_REGISTRY_H
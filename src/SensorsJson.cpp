@@ -0,0 +1,93 @@
+#include "SensorsJson.h"
+
+void writeSensorsJson(JsonWriter &json, const FuFarmSensorsData *data)
+{
+  json.beginObject();
+  writeSensorsJsonMembers(json, data);
+  json.endObject();
+}
+
+void writeSensorsJsonMembers(JsonWriter &json, const FuFarmSensorsData *data)
+{
+#define FUFARM_JSON_NUMBER(id, field, name, ...) \
+  json.key(name);                                \
+  json.value(data->field);
+#define FUFARM_JSON_PROBES(id, field, count, max, name, ...)          \
+  json.key(name);                                                     \
+  json.value(data->field[0]);                                         \
+  /* additional probes are numbered from 2 e.g. tempwet2, tempwet3 */ \
+  for (uint8_t i = 1; i < data->count; i++)                           \
+  {                                                                   \
+    json.key(name, i + 1);                                            \
+    json.value(data->field[i]);                                       \
+  }
+  FUFARM_SENSORS(FUFARM_JSON_NUMBER, FUFARM_JSON_PROBES, FUFARM_JSON_NUMBER)
+#undef FUFARM_JSON_NUMBER
+#undef FUFARM_JSON_PROBES
+
+#ifdef HAVE_ANALOG
+  json.key("variance");
+  json.beginObject();
+#ifdef HAVE_LIGHT
+  json.key("light");
+  json.value(data->variance.light);
+#endif
+#ifdef HAVE_CO2
+  json.key("co2");
+  json.value(data->variance.co2);
+#endif
+#ifdef HAVE_EC
+  json.key("ec");
+  json.value(data->variance.ec);
+#endif
+#ifdef HAVE_PH
+  json.key("ph");
+  json.value(data->variance.ph);
+#endif
+#ifdef HAVE_MOISTURE
+  json.key("moisture");
+  json.value(data->variance.moisture);
+#endif
+  json.endObject();
+#endif
+}
+
+#if SENSORS_WINDOW_STATS
+void writeWindowStatsJson(JsonWriter &json, const WindowStats &stats)
+{
+  json.beginObject();
+  json.key("mean");
+  json.value(stats.mean());
+  json.key("min");
+  json.value(stats.min());
+  json.key("max");
+  json.value(stats.max());
+  json.key("stddev");
+  json.value(stats.stddev());
+  json.key("count");
+  json.value(stats.count());
+  json.endObject();
+}
+
+void writeSensorsWindowStatsJson(JsonWriter &json, const FuFarmSensorsData *data)
+{
+  json.beginObject();
+#define FUFARM_STATS_NUMBER(id, field, name, ...) \
+  json.key(name);                                 \
+  writeWindowStatsJson(json, data->stats.id);
+#define FUFARM_STATS_PROBES(id, field, count, max, name, ...) \
+  json.key(name);                                             \
+  writeWindowStatsJson(json, data->stats.id[0]);              \
+  for (uint8_t i = 1; i < data->count; i++)                   \
+  {                                                           \
+    json.key(name, i + 1);                                    \
+    writeWindowStatsJson(json, data->stats.id[i]);            \
+  }
+#define FUFARM_STATS_BINARY(...)
+  FUFARM_SENSORS(FUFARM_STATS_NUMBER, FUFARM_STATS_PROBES, FUFARM_STATS_BINARY)
+#undef FUFARM_STATS_NUMBER
+#undef FUFARM_STATS_PROBES
+#undef FUFARM_STATS_BINARY
+  json.endObject();
+}
+#endif
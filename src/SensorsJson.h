@@ -0,0 +1,81 @@
+#ifndef SENSORS_JSON_H
+#define SENSORS_JSON_H
+
+#include "sensors.h"
+#include "JsonWriter.h"
+#include "SensorRegistry.h"
+
+// Size of a sample in JSON: the braces, the NUL character and for each member its quoted key, colon, comma and value
+#define FUFARM_JSON_NUMBER_SIZE(id, field, json, ...) +sizeof(json) + 3 + JSON_WRITER_MAX_VALUE_LENGTH
+#define FUFARM_JSON_PROBES_SIZE(id, field, count, max, json, ...) \
+  +(max) * (sizeof(json) + 6 + JSON_WRITER_MAX_VALUE_LENGTH) // up to 3 digits for the probe number
+#ifdef HAVE_ANALOG
+// "variance":{} and up to 5 analog values, whose keys are at most as long as "moisture"
+#define FUFARM_VARIANCE_JSON_SIZE (sizeof("variance") + 4 + 5 * (sizeof("moisture") + 3 + JSON_WRITER_MAX_VALUE_LENGTH))
+#else
+#define FUFARM_VARIANCE_JSON_SIZE 0
+#endif
+static const size_t sensorsJsonCapacity =
+    3 FUFARM_SENSORS(FUFARM_JSON_NUMBER_SIZE, FUFARM_JSON_PROBES_SIZE, FUFARM_JSON_NUMBER_SIZE) +
+    FUFARM_VARIANCE_JSON_SIZE;
+#undef FUFARM_JSON_NUMBER_SIZE
+#undef FUFARM_JSON_PROBES_SIZE
+#undef FUFARM_VARIANCE_JSON_SIZE
+
+#if SENSORS_WINDOW_STATS
+// Size of the statistics of a value in JSON: {"mean":,"min":,"max":,"stddev":,"count":} and the values
+#define FUFARM_WINDOW_STATS_JSON_SIZE (42 + 5 * JSON_WRITER_MAX_VALUE_LENGTH)
+static const size_t windowStatsJsonCapacity = FUFARM_WINDOW_STATS_JSON_SIZE + 1;
+
+// Size of the statistics of a sample in JSON, an object of the statistics of each value keyed as in the sample
+#define FUFARM_STATS_NUMBER_SIZE(id, field, json, ...) +sizeof(json) + 3 + FUFARM_WINDOW_STATS_JSON_SIZE
+#define FUFARM_STATS_PROBES_SIZE(id, field, count, max, json, ...) \
+  +(max) * (sizeof(json) + 6 + FUFARM_WINDOW_STATS_JSON_SIZE)
+#define FUFARM_STATS_BINARY_SIZE(...)
+static const size_t sensorsWindowStatsJsonCapacity =
+    3 FUFARM_SENSORS(FUFARM_STATS_NUMBER_SIZE, FUFARM_STATS_PROBES_SIZE, FUFARM_STATS_BINARY_SIZE);
+#undef FUFARM_STATS_NUMBER_SIZE
+#undef FUFARM_STATS_PROBES_SIZE
+#undef FUFARM_STATS_BINARY_SIZE
+#endif
+
+/**
+ * Writes the values of a sample as a JSON object, with the keys of the sensor registry (e.g. tempair, tempwet2).
+ * The variance of the ADC samples of the analog values is in a "variance" member with the same keys,
+ * e.g. {"light":..,"variance":{"light":..}}.
+ * This is the format of the serial output and of the state published to Home Assistant in batched mode.
+ *
+ * @param json The writer, its buffer should hold sensorsJsonCapacity characters.
+ * @param data The sample.
+ */
+void writeSensorsJson(JsonWriter &json, const FuFarmSensorsData *data);
+
+/**
+ * Writes the values of a sample as the members of an object that the caller has begun, e.g. to add other members.
+ *
+ * @param json The writer.
+ * @param data The sample.
+ */
+void writeSensorsJsonMembers(JsonWriter &json, const FuFarmSensorsData *data);
+
+#if SENSORS_WINDOW_STATS
+/**
+ * Writes the statistics of a value over a window as a JSON object: {"mean":..,"min":..,"max":..,"stddev":..,"count":..}.
+ * The statistics are null when no read of the window was valid.
+ *
+ * @param json The writer, its buffer should hold windowStatsJsonCapacity characters.
+ * @param stats The statistics.
+ */
+void writeWindowStatsJson(JsonWriter &json, const WindowStats &stats);
+
+/**
+ * Writes the statistics of a sample as a JSON object of the statistics of each value, with the same keys as
+ * writeSensorsJson() e.g. {"tempair":{"mean":..},"tempwet2":{..}}. The binary values have none.
+ *
+ * @param json The writer, its buffer should hold sensorsWindowStatsJsonCapacity characters.
+ * @param data The sample.
+ */
+void writeSensorsWindowStatsJson(JsonWriter &json, const FuFarmSensorsData *data);
+#endif
+
+#endif // SENSORS_JSON_H
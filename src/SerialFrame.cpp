@@ -0,0 +1,150 @@
+#include "SerialFrame.h"
+
+#include <math.h>
+
+// Offsets in the frame
+#define SERIAL_FRAME_LENGTH_OFFSET 2
+#define SERIAL_FRAME_PRESENCE_OFFSET 3
+#define SERIAL_FRAME_HEADER_LENGTH 5
+
+SerialFrameWriter::SerialFrameWriter(uint8_t *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _length(0), _presence(0), _lastBit(-1), _failed(false)
+{
+  write(SERIAL_FRAME_SYNC);
+  write(SERIAL_FRAME_VERSION);
+  write(0); // length
+  write(0); // presence
+  write(0);
+}
+
+void SerialFrameWriter::value(uint8_t bit, float value, uint8_t decimals)
+{
+  if (present(bit))
+  {
+    writeScaled(value, decimals);
+  }
+}
+
+void SerialFrameWriter::value(uint8_t bit, int32_t value, uint8_t decimals)
+{
+  if (!present(bit))
+  {
+    return;
+  }
+  if (decimals > 0)
+  {
+    writeScaled((float)value, decimals);
+    return;
+  }
+  // keep the zigzag encoding plus 1 within 32 bits
+  if (value == INT32_MIN)
+  {
+    value++;
+  }
+  writeVarint((((uint32_t)value << 1) ^ (uint32_t)(value >> 31)) + 1);
+}
+
+void SerialFrameWriter::values(uint8_t bit, const float *values, uint8_t count, uint8_t decimals)
+{
+  if (!present(bit))
+  {
+    return;
+  }
+  writeVarint(count);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    writeScaled(values[i], decimals);
+  }
+}
+
+size_t SerialFrameWriter::end(uint16_t sequence)
+{
+  write((uint8_t)sequence);
+  write((uint8_t)(sequence >> 8));
+
+  size_t payload = _length - SERIAL_FRAME_PRESENCE_OFFSET;
+  if (_failed || payload > 0xFF || _length + 2 > _capacity)
+  {
+    return 0;
+  }
+  _buffer[SERIAL_FRAME_LENGTH_OFFSET] = (uint8_t)payload;
+  _buffer[SERIAL_FRAME_PRESENCE_OFFSET] = (uint8_t)_presence;
+  _buffer[SERIAL_FRAME_PRESENCE_OFFSET + 1] = (uint8_t)(_presence >> 8);
+
+  // the sync byte is not covered so that the CRC is the same wherever the receiver synchronised
+  uint16_t crc = serialFrameCrc(_buffer + 1, _length - 1);
+  write((uint8_t)crc);
+  write((uint8_t)(crc >> 8));
+  return _length;
+}
+
+bool SerialFrameWriter::present(uint8_t bit)
+{
+  if (bit > 15 || (int8_t)bit <= _lastBit)
+  {
+    _failed = true;
+    return false;
+  }
+  _lastBit = (int8_t)bit;
+  _presence |= (uint16_t)(1U << bit);
+  return true;
+}
+
+void SerialFrameWriter::write(uint8_t byte)
+{
+  if (_length >= _capacity)
+  {
+    _failed = true;
+    return;
+  }
+  _buffer[_length++] = byte;
+}
+
+void SerialFrameWriter::writeVarint(uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    write((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  write((uint8_t)value);
+}
+
+void SerialFrameWriter::writeScaled(float value, uint8_t decimals)
+{
+  if (isnan(value) || isinf(value))
+  {
+    writeVarint(0); // null
+    return;
+  }
+
+  double scaled = value;
+  for (uint8_t i = 0; i < decimals; i++)
+  {
+    scaled *= 10;
+  }
+  scaled = round(scaled);
+  if (scaled > (double)INT32_MAX)
+  {
+    scaled = (double)INT32_MAX;
+  }
+  else if (scaled < -(double)INT32_MAX)
+  {
+    scaled = -(double)INT32_MAX;
+  }
+  int32_t integer = (int32_t)scaled;
+  writeVarint((((uint32_t)integer << 1) ^ (uint32_t)(integer >> 31)) + 1);
+}
+
+uint16_t serialFrameCrc(const uint8_t *data, size_t length, uint16_t crc)
+{
+  while (length--)
+  {
+    crc ^= (uint16_t)(*data++ << 8);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
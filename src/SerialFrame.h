@@ -0,0 +1,88 @@
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERIAL_FRAME_SYNC 0xA5 // not an ASCII character so that frames stand out from log lines
+#define SERIAL_FRAME_VERSION 1
+
+// sync, version, length, presence bitmap (2), sequence number (2), CRC (2)
+#define SERIAL_FRAME_OVERHEAD 9
+// Maximum length of an encoded value (a varint of 32 bits)
+#define SERIAL_FRAME_MAX_VALUE_LENGTH 5
+
+/**
+ * Writes a sample as a binary frame, a compact alternative to JSON for slow serial links:
+ *
+ *   sync (0xA5) | version | length | presence (uint16) | values... | sequence (uint16) | CRC16
+ *
+ * - length: the number of bytes from the presence bitmap to the sequence number, inclusive
+ * - presence: one bit per value in the frame, the bit of each value is given by the sensor registry
+ * - values: in the order of their bits, each one scaled by 10^decimals, rounded, zigzag encoded and written as a
+ *   varint (7 bits per byte, least significant first) plus 1; 0 stands for null (NaN). Values with several probes
+ *   start with the number of probes, as a varint.
+ * - sequence: incremented for each frame so that the receiver can tell how many frames were lost
+ * - CRC16: CRC-16/CCITT-FALSE of the version up to the sequence number, inclusive
+ *
+ * Multi-byte fields are little endian. scripts/fufarm_serial.py decodes the frames.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class SerialFrameWriter
+{
+public:
+  /**
+   * Creates a new instance of the SerialFrameWriter class.
+   *
+   * @param buffer Where the frame is written.
+   * @param capacity The size of the buffer.
+   */
+  SerialFrameWriter(uint8_t *buffer, size_t capacity);
+
+  /**
+   * Writes a value. Values must be written in increasing order of their bits.
+   *
+   * @param bit The position of the value in the presence bitmap (0 to 15).
+   * @param value The value.
+   * @param decimals The number of decimals that are kept.
+   */
+  void value(uint8_t bit, float value, uint8_t decimals);
+  void value(uint8_t bit, int32_t value, uint8_t decimals = 0);
+  void value(uint8_t bit, uint16_t value, uint8_t decimals = 0) { this->value(bit, (int32_t)value, decimals); }
+  void value(uint8_t bit, bool value, uint8_t decimals = 0) { this->value(bit, (int32_t)value, decimals); }
+
+  /**
+   * Writes the values of several probes under a single bit.
+   */
+  void values(uint8_t bit, const float *values, uint8_t count, uint8_t decimals);
+
+  /**
+   * Completes the frame.
+   *
+   * @param sequence The sequence number of the frame.
+   * @return The length of the frame or 0 if the buffer was too small or the bits were not in order.
+   */
+  size_t end(uint16_t sequence);
+
+private:
+  uint8_t *_buffer;
+  size_t _capacity;
+  size_t _length;
+  uint16_t _presence;
+  int8_t _lastBit;
+  bool _failed;
+
+private:
+  bool present(uint8_t bit);
+  void write(uint8_t byte);
+  void writeVarint(uint32_t value);
+  void writeScaled(float value, uint8_t decimals);
+};
+
+/**
+ * Computes the CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of the data.
+ */
+uint16_t serialFrameCrc(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+
+#endif // SERIAL_FRAME_H
@@ -0,0 +1,119 @@
+#include "SerialLink.h"
+
+#if !HAVE_NETWORK
+
+#include "Profiler.h"
+
+// Rates the host can ask for, up to SERIAL_BAUD_MAX
+static const uint32_t supportedBaudRates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+
+SerialLink::SerialLink(uint32_t baud, bool binary)
+    : _defaultBaud(baud), _defaultBinary(binary), _baud(baud), _binary(binary), _sequence(0),
+      _receivedMillis(0), _lineLength(0)
+{
+}
+
+void SerialLink::begin()
+{
+  Serial.begin(_baud);
+}
+
+void SerialLink::maintain()
+{
+  while (Serial.available() > 0)
+  {
+    char received = (char)Serial.read();
+    _receivedMillis = millis();
+    if (received == '\n' || received == '\r')
+    {
+      if (_lineLength > 0)
+      {
+        _line[_lineLength] = '\0';
+        _lineLength = 0;
+        handle(_line);
+      }
+    }
+    else if (_lineLength < sizeof(_line) - 1)
+    {
+      _line[_lineLength++] = (char)toupper((unsigned char)received);
+    }
+  }
+
+  if ((_baud != _defaultBaud || _binary != _defaultBinary) && millis() - _receivedMillis >= SERIAL_LINK_IDLE_MILLIS)
+  {
+    _binary = _defaultBinary;
+    setBaud(_defaultBaud);
+  }
+}
+
+#if USE_PROFILER
+static void printProfile(const char *text, void *context)
+{
+  Serial.print(text);
+}
+#endif
+
+void SerialLink::handle(char *command)
+{
+  if (strncmp(command, "BAUD ", 5) == 0)
+  {
+    uint32_t baud = strtoul(command + 5, nullptr, 10);
+    for (uint8_t i = 0; i < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); i++)
+    {
+      if (supportedBaudRates[i] == baud && baud <= SERIAL_BAUD_MAX)
+      {
+        // the answer is sent at the current rate so that the host knows when to switch
+        Serial.print(F("{\"baud\":"));
+        Serial.print(baud);
+        Serial.println(F("}"));
+        setBaud(baud);
+        return;
+      }
+    }
+  }
+  else if (strcmp(command, "FORMAT BINARY") == 0)
+  {
+    _binary = true;
+  }
+  else if (strcmp(command, "FORMAT JSON") == 0)
+  {
+    _binary = false;
+  }
+#if USE_PROFILER
+  // answered with a line of JSON instead of the usual reply
+  else if (strcmp(command, "PROFILE") == 0 && Profiler::instance())
+  {
+    Profiler::instance()->writeSummary(printProfile, nullptr);
+    Serial.println();
+    return;
+  }
+  else if (strcmp(command, "TRACE") == 0 && Profiler::instance())
+  {
+    Profiler::instance()->writeTrace(printProfile, nullptr);
+    Serial.println();
+    return;
+  }
+#endif
+  reply();
+}
+
+void SerialLink::setBaud(uint32_t baud)
+{
+  if (baud == _baud)
+  {
+    return;
+  }
+  Serial.flush();
+  Serial.begin(baud);
+  _baud = baud;
+}
+
+void SerialLink::reply()
+{
+  Serial.print(F("{\"baud\":"));
+  Serial.print(_baud);
+  Serial.print(_binary ? F(",\"format\":\"binary\"}") : F(",\"format\":\"json\"}"));
+  Serial.println();
+}
+
+#endif // !HAVE_NETWORK
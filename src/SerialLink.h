@@ -0,0 +1,75 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#if !HAVE_NETWORK
+
+/**
+ * Settings of the serial link that the host can change, for when samples are sent via Serial.
+ *
+ * The host sends commands as lines of text:
+ *   BAUD <rate>     switches to the rate (up to SERIAL_BAUD_MAX), answered with {"baud":<rate>} before switching
+ *   FORMAT BINARY   sends the samples as frames (see SerialFrame.h)
+ *   FORMAT JSON     sends the samples as lines of JSON
+ *   PROFILE         with USE_PROFILER, answered with the summary of the profiler as a line of JSON (see Profiler.h)
+ *   TRACE           with USE_PROFILER, answered with the trace of the profiler as a line of Chrome trace JSON
+ * The FORMAT commands, unknown commands and unsupported rates are answered with the current settings in JSON
+ * e.g. {"baud":9600,"format":"json"}.
+ *
+ * The defaults are restored when nothing has been received for SERIAL_LINK_IDLE_MILLIS, so a host that
+ * restarts and only knows the defaults gets them back. A host that changed them should send a command
+ * (e.g. the same BAUD) more often than that.
+ */
+class SerialLink
+{
+public:
+  /**
+   * Creates a new instance of the SerialLink class.
+   *
+   * @param baud The default baud rate.
+   * @param binary The default format, true for binary frames, false for JSON.
+   */
+  SerialLink(uint32_t baud, bool binary);
+
+  /**
+   * Opens the serial port with the defaults.
+   */
+  void begin();
+
+  /**
+   * Handles the commands received from the host and restores the defaults when it has gone quiet.
+   * This should be called frequently, e.g. in the main loop.
+   */
+  void maintain();
+
+  /**
+   * Returns true if samples should be sent as binary frames.
+   */
+  inline bool binary() const { return _binary; }
+
+  /**
+   * Returns the sequence number of the next frame.
+   */
+  inline uint16_t nextSequence() { return _sequence++; }
+
+private:
+  uint32_t _defaultBaud;
+  bool _defaultBinary;
+  uint32_t _baud;
+  bool _binary;
+  uint16_t _sequence;
+  uint32_t _receivedMillis; // when the last byte was received
+  char _line[24];
+  uint8_t _lineLength;
+
+private:
+  void handle(char *command);
+  void setBaud(uint32_t baud);
+  void reply();
+};
+
+#endif // !HAVE_NETWORK
+
+#endif // SERIAL_LINK_H
@@ -3,6 +3,16 @@
 #if NETWORK_SERVICE_DISCOVERY
 
 #include "reboot.h"
+#include "Profiler.h"
+#include "Logger.h"
+
+#if NETWORK_SERVICE_DISCOVERY_CACHE
+#include <Preferences.h>
+
+#define PREFERENCES_NAMESPACE "discovery"
+#define PREFERENCES_HA_IP_KEY "haIp"
+#define PREFERENCES_HA_PORT_KEY "haPort"
+#endif
 
 #define HOME_ASSISTANT_SERVICE_NAME "_home-assistant"
 
@@ -13,7 +23,7 @@ static void serviceFoundCallback(const char* type, MDNSServiceProtocol_t protoco
   ServiceDiscovery::instance()->serviceFound(type, protocol, name, address, port, txt);
 }
 
-ServiceDiscovery::ServiceDiscovery(UDP& udpClient) : mdns(udpClient)
+ServiceDiscovery::ServiceDiscovery(UDP& udpClient) : mdns(udpClient), _updates(0)
 {
   _instance = this;
 }
@@ -26,7 +36,7 @@ ServiceDiscovery::~ServiceDiscovery()
 void ServiceDiscovery::begin(IPAddress ip, const char* hostname, uint8_t* mac)
 {
   if (!mdns.begin(ip, hostname)) {
-    Serial.println("Error setting up MDNS!");
+    Serial.println("Error setting up MDNS!"); // not queued, the device reboots before it would be written
     reboot();
   }
 
@@ -64,6 +74,7 @@ void ServiceDiscovery::maintain()
     }
   }
 
+  PROFILE_SCOPE("mdns.run");
   mdns.run();
 }
 
@@ -73,10 +84,10 @@ void ServiceDiscovery::discover(bool initial)
   // The mosquitto add-on does not advertise itself so we search for Home Assistant instead
   // On macOS, you can run "dns-sd -B _services._dns-sd._udp local" to see available services
   if (initial) {
-    Serial.println(F("Searching for " HOME_ASSISTANT_SERVICE_NAME "._tcp.local service ... "));
+    LOG_INFO("Searching for " HOME_ASSISTANT_SERVICE_NAME "._tcp.local service ... ");
   }
   if (!mdns.startDiscoveringService(HOME_ASSISTANT_SERVICE_NAME, _MDNSServiceProtocol_t::MDNSServiceTCP, 5000)) {
-    Serial.println("Error starting mDNS discovery!");
+    LOG_ERROR("Error starting mDNS discovery!");
   }
 #endif // USE_HOME_ASSISTANT
 }
@@ -92,8 +103,8 @@ void ServiceDiscovery::serviceFound(const char* type,
   if (name == NULL) {
     // if the endpoint type is still unknown set it to defaults
     if (_haEndpoint.type == NetworkEndpointType::UNKNOWN) {
-      Serial.println(F("No Home Assistant service found. Ensure you are on the same network."));
-      Serial.println(F("Custom network configurations such as through Tailscale may affect discovery."));
+      LOG_WARN("No Home Assistant service found. Ensure you are on the same network.");
+      LOG_WARN("Custom network configurations such as through Tailscale may affect discovery.");
     }
 
     return;
@@ -107,18 +118,53 @@ void ServiceDiscovery::serviceFound(const char* type,
   updateNetworkEndpoint(&_haEndpoint, &address, NULL, HOME_ASSISTANT_MQTT_PORT );
 
   if (changed) {
-    Serial.print(initial ? F("Found Home Assistant service at ") : F("Found updated Home Assistant service at "));
-    Serial.print(_haEndpoint.ip);
-    Serial.print(F(":"));
-    Serial.println(port); // Serial.println(_haEndpoint.port);
+    if (!initial) {
+      _updates++;
+    }
+    LOG_INFO("Found %sHome Assistant service at %s:%u", initial ? "" : "updated ", _haEndpoint.ip.toString().c_str(),
+             port);
 
     if (haEndpointUpdatedCallback) {
       haEndpointUpdatedCallback(&_haEndpoint);
     }
+
+#if NETWORK_SERVICE_DISCOVERY_CACHE
+    // written only when it changes to spare the flash
+    Preferences preferences;
+    preferences.begin(PREFERENCES_NAMESPACE, false);
+    preferences.putUInt(PREFERENCES_HA_IP_KEY, (uint32_t)_haEndpoint.ip);
+    preferences.putUShort(PREFERENCES_HA_PORT_KEY, _haEndpoint.port);
+    preferences.end();
+#endif
   }
 #endif // USE_HOME_ASSISTANT
 }
 
+#if NETWORK_SERVICE_DISCOVERY_CACHE && USE_HOME_ASSISTANT
+bool ServiceDiscovery::restore()
+{
+  Preferences preferences;
+  preferences.begin(PREFERENCES_NAMESPACE, true);
+  uint32_t ip = preferences.getUInt(PREFERENCES_HA_IP_KEY, 0);
+  uint16_t port = preferences.getUShort(PREFERENCES_HA_PORT_KEY, 0);
+  preferences.end();
+  if (ip == 0 || port == 0)
+  {
+    return false;
+  }
+
+  // discovery still runs once connected, an endpoint that moved is then replaced
+  IPAddress address(ip);
+  updateNetworkEndpoint(&_haEndpoint, &address, NULL, port);
+  LOG_INFO("Using the last Home Assistant service found at %s:%u", _haEndpoint.ip.toString().c_str(), _haEndpoint.port);
+
+  if (haEndpointUpdatedCallback) {
+    haEndpointUpdatedCallback(&_haEndpoint);
+  }
+  return true;
+}
+#endif
+
 void ServiceDiscovery::updateNetworkEndpoint(NetworkEndpoint *endpoint, IPAddress* ip, const char *hostname, uint16_t port)
 {
   if (ip != NULL) {
@@ -62,6 +62,16 @@ public:
    */
   void maintain();
 
+#if NETWORK_SERVICE_DISCOVERY_CACHE && USE_HOME_ASSISTANT
+  /**
+   * Restores the last endpoint found from NVS and reports it to the callback straight away, so that a connection
+   * can be made before discovery finds it again. Call after registering the callback.
+   *
+   * @return true if an endpoint was restored.
+   */
+  bool restore();
+#endif
+
 #if USE_HOME_ASSISTANT
   /**
    * Returns the network endpoint to use for home assistant
@@ -76,6 +86,11 @@ public:
   inline void onHaEndpointUpdated(void (*callback)(NetworkEndpoint *endpoint)) { haEndpointUpdatedCallback = callback; }
 #endif
 
+  /**
+   * Returns the number of times the endpoint found earlier was replaced by a new one.
+   */
+  inline uint32_t updates() const { return _updates; }
+
   /**
    * Returns existing instance (singleton) of the ServiceDiscovery class.
    * It may be a null pointer if the ServiceDiscovery object was never constructed or it was destroyed.
@@ -98,6 +113,7 @@ private:
 private:
   void (*haEndpointUpdatedCallback)(NetworkEndpoint *endpoint);
   uint32_t discoverTimepoint;
+  uint32_t _updates;
 
   /// Living instance of the ServiceDiscovery class. It can be nullptr.
   static ServiceDiscovery *_instance;
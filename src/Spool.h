@@ -0,0 +1,258 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stdint.h>
+#include "SpoolStorage.h"
+
+#define SPOOL_MAGIC 0x5350 // "SP"
+
+// Written at the start of every block
+struct SpoolBlockHeader
+{
+  uint16_t magic;
+  uint16_t recordSize; // sizeof(T) of the firmware that wrote the block
+};
+
+/**
+ * Bounded store-and-forward queue of records, e.g. the samples taken while the broker is unreachable.
+ *
+ * Records are kept in a RAM ring of RamCapacity first. When it is full, the oldest BlockRecords are written to a
+ * block of the storage so that a long outage or a reboot does not lose them. When there are more than MaxBlocks
+ * blocks, the oldest one is deleted. The records always come out oldest first.
+ *
+ * A block holds the raw records behind a header with the size of a record, so the blocks written by a firmware
+ * with a different T are discarded instead of being misread.
+ * A record is only removed once drop() acknowledges it, so a block that was partially replayed before a reboot
+ * is replayed from its start again.
+ *
+ * The records are passed to the prepare function, if any, before they are written to the storage or returned
+ * by peek(), e.g. to timestamp them once the wall clock is known.
+ *
+ * This file does not depend on Arduino so that it can be tested on the host.
+ */
+template <typename T, uint16_t RamCapacity, uint16_t BlockRecords, uint32_t MaxBlocks>
+class Spool
+{
+  static_assert(BlockRecords > 0 && BlockRecords <= RamCapacity, "a block must fit in the RAM ring");
+
+public:
+  typedef void (*Prepare)(T *record);
+
+  /**
+   * Creates a new instance of the Spool class.
+   *
+   * @param storage Where the records go once the RAM ring is full.
+   * @param prepare Called on a record before it is stored or returned by peek(), nullptr for none.
+   */
+  Spool(SpoolStorage &storage, Prepare prepare = nullptr)
+      : _storage(storage), _prepare(prepare), _head(0), _count(0), _stored(false), _firstBlock(0), _nextBlock(0),
+        _blockOffset(0), _storedRecords(0), _dropped(0)
+  {
+  }
+
+  /**
+   * Prepares the storage and finds the records left by a previous boot.
+   *
+   * @return false if the storage cannot be used, the records are then only kept in RAM.
+   */
+  bool begin()
+  {
+    _stored = _storage.begin();
+    if (!_stored)
+    {
+      return false;
+    }
+
+    // the blocks are numbered in the order they were written, there may be gaps if one was lost
+    uint32_t first, last;
+    if (_storage.find(&first, &last))
+    {
+      _firstBlock = first;
+      _nextBlock = last + 1;
+      for (uint32_t block = first; block != _nextBlock; block++)
+      {
+        _storedRecords += blockRecords(block);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Adds a record, the oldest one is dropped if it cannot be made room for.
+   *
+   * @param record The record.
+   */
+  void push(const T &record)
+  {
+    if (_count == RamCapacity)
+    {
+      spill(BlockRecords);
+    }
+    if (_count == RamCapacity)
+    {
+      // could not be stored, the oldest record makes room
+      _head = (_head + 1) % RamCapacity;
+      _count--;
+      _dropped++;
+    }
+
+    _ram[(_head + _count) % RamCapacity] = record;
+    _count++;
+  }
+
+  /**
+   * Gets the oldest record without removing it.
+   *
+   * @param dest The destination for the record.
+   * @return false if the spool is empty.
+   */
+  bool peek(T *dest)
+  {
+    // the blocks hold older records than the RAM
+    while (_firstBlock != _nextBlock)
+    {
+      if (_blockOffset < blockRecords(_firstBlock)
+          && _storage.read(_firstBlock, sizeof(SpoolBlockHeader) + _blockOffset * sizeof(T), dest, sizeof(T)))
+      {
+        return true;
+      }
+      // empty, from another firmware or unreadable
+      removeFirstBlock();
+    }
+
+    if (_count == 0)
+    {
+      return false;
+    }
+    prepare(&_ram[_head]);
+    *dest = _ram[_head];
+    return true;
+  }
+
+  /**
+   * Removes the oldest record, once it has been handled (e.g. published).
+   */
+  void drop()
+  {
+    if (_firstBlock != _nextBlock)
+    {
+      _blockOffset++;
+      _storedRecords--;
+      if (_blockOffset >= blockRecords(_firstBlock))
+      {
+        removeFirstBlock();
+      }
+      return;
+    }
+
+    if (_count > 0)
+    {
+      _head = (_head + 1) % RamCapacity;
+      _count--;
+    }
+  }
+
+  /**
+   * Writes the records held in RAM to the storage, e.g. before a reboot.
+   */
+  void save() { spill(_count); }
+
+  /**
+   * Returns the number of records in the spool.
+   */
+  inline uint32_t size() const { return _storedRecords + _count; }
+
+  /**
+   * Returns the number of records in the storage.
+   */
+  inline uint32_t stored() const { return _storedRecords; }
+
+  /**
+   * Returns the number of records that were lost because the spool was full or could not be written.
+   */
+  inline uint32_t dropped() const { return _dropped; }
+
+private:
+  SpoolStorage &_storage;
+  Prepare _prepare;
+  T _ram[RamCapacity];
+  uint16_t _head;  // oldest record in RAM
+  uint16_t _count; // records in RAM
+  bool _stored;    // whether the storage can be used
+  uint32_t _firstBlock;    // number of the oldest block
+  uint32_t _nextBlock;     // number of the next block to write, no block when equal to _firstBlock
+  uint16_t _blockOffset;   // records of the oldest block already replayed
+  uint32_t _storedRecords; // records in the blocks, not counting the replayed ones
+  uint32_t _dropped;
+
+private:
+  void prepare(T *record)
+  {
+    if (_prepare != nullptr)
+    {
+      _prepare(record);
+    }
+  }
+
+  void spill(uint16_t count)
+  {
+    if (!_stored || count == 0)
+    {
+      return;
+    }
+    if (_nextBlock - _firstBlock >= MaxBlocks)
+    {
+      removeFirstBlock();
+    }
+
+    SpoolBlockHeader header = {SPOOL_MAGIC, (uint16_t)sizeof(T)};
+    bool written = _storage.append(_nextBlock, &header, sizeof(header));
+    for (uint16_t i = 0; written && i < count; i++)
+    {
+      T &record = _ram[(_head + i) % RamCapacity];
+      prepare(&record);
+      written = _storage.append(_nextBlock, &record, sizeof(T));
+    }
+    if (!written)
+    {
+      // e.g. the storage is full, the records stay in RAM
+      _storage.remove(_nextBlock);
+      return;
+    }
+
+    _head = (_head + count) % RamCapacity;
+    _count -= count;
+    _nextBlock++;
+    _storedRecords += count;
+  }
+
+  uint16_t blockRecords(uint32_t block)
+  {
+    uint32_t size = _storage.size(block);
+    SpoolBlockHeader header;
+    bool valid = size >= sizeof(header) && _storage.read(block, 0, &header, sizeof(header))
+        && header.magic == SPOOL_MAGIC && header.recordSize == sizeof(T);
+    if (!valid)
+    {
+      _storage.remove(block);
+      return 0;
+    }
+    return (size - sizeof(header)) / sizeof(T);
+  }
+
+  void removeFirstBlock()
+  {
+    uint16_t records = blockRecords(_firstBlock);
+    if (records > _blockOffset)
+    {
+      // not replayed yet, lost
+      _dropped += records - _blockOffset;
+      _storedRecords -= records - _blockOffset;
+    }
+    _storage.remove(_firstBlock);
+    _firstBlock++;
+    _blockOffset = 0;
+  }
+};
+
+#endif // SPOOL_H
@@ -0,0 +1,69 @@
+#ifndef SPOOL_STORAGE_H
+#define SPOOL_STORAGE_H
+
+#include <stdint.h>
+
+/**
+ * Persistent storage of the spool (see Spool.h): numbered blocks of bytes that survive a reboot, e.g. files.
+ *
+ * This file does not depend on Arduino so that the spool can be exercised on the host against a fake storage
+ * which keeps the blocks in RAM.
+ */
+class SpoolStorage
+{
+public:
+  virtual ~SpoolStorage() {}
+
+  /**
+   * Prepares the storage, e.g. mounts the file system.
+   *
+   * @return false if the storage cannot be used.
+   */
+  virtual bool begin() = 0;
+
+  /**
+   * Finds the blocks left by a previous boot.
+   *
+   * @param first The destination for the lowest block number.
+   * @param last The destination for the highest block number.
+   * @return false if there are none.
+   */
+  virtual bool find(uint32_t *first, uint32_t *last) = 0;
+
+  /**
+   * Returns the size of a block in bytes, 0 if it does not exist.
+   *
+   * @param block The block number.
+   */
+  virtual uint32_t size(uint32_t block) = 0;
+
+  /**
+   * Reads bytes from a block.
+   *
+   * @param block The block number.
+   * @param offset The position of the first byte in the block.
+   * @param dest The destination for the bytes.
+   * @param length The number of bytes to read.
+   * @return true if all the bytes were read.
+   */
+  virtual bool read(uint32_t block, uint32_t offset, void *dest, uint32_t length) = 0;
+
+  /**
+   * Appends bytes to a block, creating it if needed.
+   *
+   * @param block The block number.
+   * @param data The bytes to write.
+   * @param length The number of bytes to write.
+   * @return true if all the bytes were written.
+   */
+  virtual bool append(uint32_t block, const void *data, uint32_t length) = 0;
+
+  /**
+   * Deletes a block, if it exists.
+   *
+   * @param block The block number.
+   */
+  virtual void remove(uint32_t block) = 0;
+};
+
+#endif // SPOOL_STORAGE_H
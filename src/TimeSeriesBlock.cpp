@@ -0,0 +1,297 @@
+#include "TimeSeriesBlock.h"
+
+#include <string.h>
+
+// The header is little endian: count (2 bytes), first time (4 bytes), bits of the first value (4 bytes)
+static void writeHeaderField(uint8_t *dest, uint32_t value, uint8_t length)
+{
+  for (uint8_t i = 0; i < length; i++)
+  {
+    dest[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint32_t readHeaderField(const uint8_t *src, uint8_t length)
+{
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    value |= (uint32_t)src[i] << (8 * i);
+  }
+  return value;
+}
+
+static uint32_t floatBits(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float bitsFloat(uint32_t bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static uint8_t leadingZeros(uint32_t value)
+{
+  uint8_t count = 0;
+  for (uint32_t mask = 0x80000000; mask && !(value & mask); mask >>= 1)
+  {
+    count++;
+  }
+  return count;
+}
+
+static uint8_t trailingZeros(uint32_t value)
+{
+  uint8_t count = 0;
+  for (uint32_t mask = 1; mask && !(value & mask); mask <<= 1)
+  {
+    count++;
+  }
+  return count;
+}
+
+TimeSeriesEncoder::TimeSeriesEncoder(uint8_t *buffer, size_t capacity)
+    : _buffer(buffer), _capacityBits(capacity * 8), _bits(0), _count(0), _time(0), _delta(0), _value(0),
+      _leading(0xFF), _trailing(0)
+{
+  if (capacity >= 2)
+  {
+    writeHeaderField(_buffer, 0, 2);
+  }
+}
+
+bool TimeSeriesEncoder::append(uint32_t time, float value)
+{
+  if (_count == UINT16_MAX)
+  {
+    return false;
+  }
+
+  uint32_t bits = floatBits(value);
+  if (_count == 0)
+  {
+    if (_capacityBits < TIME_SERIES_HEADER_SIZE * 8)
+    {
+      return false;
+    }
+    writeHeaderField(_buffer + 2, time, 4);
+    writeHeaderField(_buffer + 6, bits, 4);
+    _bits = TIME_SERIES_HEADER_SIZE * 8;
+  }
+  else
+  {
+    // nothing is kept of a point that does not fit
+    size_t written = _bits;
+    uint8_t leading = _leading, trailing = _trailing;
+    if (!writeTime(time) || !writeValue(bits))
+    {
+      _bits = written;
+      _leading = leading;
+      _trailing = trailing;
+      return false;
+    }
+    _delta = (int32_t)(time - _time);
+  }
+
+  _time = time;
+  _value = bits;
+  _count++;
+  writeHeaderField(_buffer, _count, 2);
+  return true;
+}
+
+bool TimeSeriesEncoder::writeBits(uint32_t value, uint8_t count)
+{
+  if (_bits + count > _capacityBits)
+  {
+    return false;
+  }
+
+  // most significant bit first, the bits of each byte are assigned so that a rolled back point leaves no trace
+  while (count > 0)
+  {
+    uint8_t free = 8 - (_bits % 8);
+    uint8_t length = count < free ? count : free;
+    uint8_t chunk = (uint8_t)((value >> (count - length)) & ((1u << length) - 1));
+    uint8_t mask = (uint8_t)(((1u << length) - 1) << (free - length));
+    uint8_t &byte = _buffer[_bits / 8];
+    byte = (byte & ~mask) | (chunk << (free - length));
+    _bits += length;
+    count -= length;
+  }
+  return true;
+}
+
+bool TimeSeriesEncoder::writeTime(uint32_t time)
+{
+  int32_t delta = (int32_t)(time - _time);
+  int32_t dod = (int32_t)((uint32_t)delta - (uint32_t)_delta);
+
+  if (dod == 0)
+  {
+    return writeBits(0, 1);
+  }
+  if (dod >= -63 && dod <= 64)
+  {
+    return writeBits(0x2, 2) && writeBits(dod + 63, 7);
+  }
+  if (dod >= -255 && dod <= 256)
+  {
+    return writeBits(0x6, 3) && writeBits(dod + 255, 9);
+  }
+  if (dod >= -2047 && dod <= 2048)
+  {
+    return writeBits(0xE, 4) && writeBits(dod + 2047, 12);
+  }
+  return writeBits(0xF, 4) && writeBits((uint32_t)dod, 32);
+}
+
+bool TimeSeriesEncoder::writeValue(uint32_t value)
+{
+  uint32_t x = value ^ _value;
+  if (x == 0)
+  {
+    return writeBits(0, 1);
+  }
+
+  uint8_t leading = leadingZeros(x);
+  uint8_t trailing = trailingZeros(x);
+  if (_leading != 0xFF && leading >= _leading && trailing >= _trailing)
+  {
+    // the meaningful bits fit in the window of the previous value
+    return writeBits(0x2, 2) && writeBits(x >> _trailing, 32 - _leading - _trailing);
+  }
+
+  _leading = leading;
+  _trailing = trailing;
+  uint8_t length = 32 - leading - trailing;
+  return writeBits(0x3, 2) && writeBits(leading, 5) && writeBits(length - 1, 5) && writeBits(x >> trailing, length);
+}
+
+TimeSeriesDecoder::TimeSeriesDecoder(const uint8_t *buffer, size_t size)
+    : _buffer(buffer), _sizeBits(size * 8), _bits(0), _count(0), _read(0), _time(0), _delta(0), _value(0),
+      _leading(0), _trailing(0)
+{
+  if (size >= TIME_SERIES_HEADER_SIZE)
+  {
+    _count = (uint16_t)readHeaderField(_buffer, 2);
+  }
+}
+
+bool TimeSeriesDecoder::next(uint32_t *time, float *value)
+{
+  if (_read >= _count)
+  {
+    return false;
+  }
+
+  if (_read == 0)
+  {
+    _time = readHeaderField(_buffer + 2, 4);
+    _value = readHeaderField(_buffer + 6, 4);
+    _bits = TIME_SERIES_HEADER_SIZE * 8;
+  }
+  else if (!readTime() || !readValue())
+  {
+    _read = _count; // truncated, nothing more can be read
+    return false;
+  }
+
+  _read++;
+  *time = _time;
+  *value = bitsFloat(_value);
+  return true;
+}
+
+bool TimeSeriesDecoder::readBits(uint8_t count, uint32_t *dest)
+{
+  if (_bits + count > _sizeBits)
+  {
+    return false;
+  }
+
+  uint32_t value = 0;
+  while (count > 0)
+  {
+    uint8_t available = 8 - (_bits % 8);
+    uint8_t length = count < available ? count : available;
+    uint8_t chunk = (_buffer[_bits / 8] >> (available - length)) & ((1u << length) - 1);
+    value = (value << length) | chunk;
+    _bits += length;
+    count -= length;
+  }
+  *dest = value;
+  return true;
+}
+
+bool TimeSeriesDecoder::readTime()
+{
+  // the prefix is up to 4 bits: 0, 10, 110, 1110 or 1111
+  uint8_t ones = 0;
+  uint32_t bit;
+  while (ones < 4)
+  {
+    if (!readBits(1, &bit))
+    {
+      return false;
+    }
+    if (!bit)
+    {
+      break;
+    }
+    ones++;
+  }
+
+  static const uint8_t lengths[] = {0, 7, 9, 12, 32};
+  static const int32_t offsets[] = {0, 63, 255, 2047, 0};
+  uint32_t dod = 0;
+  if (ones > 0 && !readBits(lengths[ones], &dod))
+  {
+    return false;
+  }
+
+  _delta = (int32_t)((uint32_t)_delta + dod - (uint32_t)offsets[ones]);
+  _time += (uint32_t)_delta;
+  return true;
+}
+
+bool TimeSeriesDecoder::readValue()
+{
+  uint32_t control;
+  if (!readBits(1, &control))
+  {
+    return false;
+  }
+  if (!control)
+  {
+    return true; // same value
+  }
+
+  if (!readBits(1, &control))
+  {
+    return false;
+  }
+  if (control)
+  {
+    uint32_t leading, length;
+    if (!readBits(5, &leading) || !readBits(5, &length) || leading + length + 1 > 32)
+    {
+      return false;
+    }
+    _leading = (uint8_t)leading;
+    _trailing = (uint8_t)(32 - leading - (length + 1));
+  }
+
+  uint32_t meaningful;
+  if (!readBits(32 - _leading - _trailing, &meaningful))
+  {
+    return false;
+  }
+  _value ^= meaningful << _trailing;
+  return true;
+}
@@ -0,0 +1,130 @@
+#ifndef TIME_SERIES_BLOCK_H
+#define TIME_SERIES_BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of a block, the erase unit (sector) of the ESP32 flash and the block size of LittleFS on it
+#ifndef TIME_SERIES_BLOCK_SIZE
+#define TIME_SERIES_BLOCK_SIZE 4096
+#endif
+
+// Size of the header of a block: the number of points, the first time and the first value
+#define TIME_SERIES_HEADER_SIZE 10
+
+/**
+ * Writes the points (time, value) of one series (e.g. the air temperature) into a compressed block, as in
+ * Facebook's Gorilla (http://www.vldb.org/pvldb/vol8/p1816-teller.pdf) adapted to 32 bit times and floats:
+ *
+ * - the first time (seconds) and value are stored as they are in the header, with the number of points
+ * - each time is stored as the change of its delta to the previous time (delta-of-delta), which is 0 for regular
+ *   samples and costs a single bit:
+ *     '0' 0, '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits, '1111' + 32 bits
+ * - each value is XORed with the previous one, an unchanged value costs a single bit and the others only store
+ *   the bits that differ:
+ *     '0' same value
+ *     '10' + the meaningful bits, when they fit in the window of the previous XOR (same leading and trailing zeros)
+ *     '11' + 5 bits of leading zeros + 5 bits of length - 1 + the meaningful bits
+ *
+ * The bits are appended, the block is never rewritten except for the number of points in its header, so a block
+ * in RAM can be written to flash as it is once full (append() returns false).
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class TimeSeriesEncoder
+{
+public:
+  /**
+   * Creates a new instance of the TimeSeriesEncoder class.
+   *
+   * @param buffer The block, at least TIME_SERIES_HEADER_SIZE bytes, usually TIME_SERIES_BLOCK_SIZE.
+   * @param capacity The size of the block in bytes.
+   */
+  TimeSeriesEncoder(uint8_t *buffer, size_t capacity);
+
+  /**
+   * Adds a point. The times must not go backwards by more than the delta of the previous points allows,
+   * they are normally increasing.
+   *
+   * @param time The time in seconds, e.g. since the epoch.
+   * @param value The value, NaN is stored as any other value.
+   * @return false if the block is full, the point was not added.
+   */
+  bool append(uint32_t time, float value);
+
+  /**
+   * Returns the number of points in the block.
+   */
+  inline uint16_t count() const { return _count; }
+
+  /**
+   * Returns the number of bytes of the block that are used.
+   */
+  inline size_t size() const { return (_bits + 7) / 8; }
+
+private:
+  uint8_t *_buffer;
+  size_t _capacityBits;
+  size_t _bits; // written so far
+  uint16_t _count;
+  uint32_t _time;
+  int32_t _delta;
+  uint32_t _value;   // bits of the previous value
+  uint8_t _leading;  // leading zeros of the previous XOR, 0xFF before the first one
+  uint8_t _trailing; // trailing zeros of the previous XOR
+
+private:
+  bool writeBits(uint32_t value, uint8_t count);
+  bool writeTime(uint32_t time);
+  bool writeValue(uint32_t value);
+};
+
+/**
+ * Reads the points of a block written by TimeSeriesEncoder, one at a time without decompressing the whole block.
+ *
+ * This file does not depend on Arduino so that it can be used on the host.
+ */
+class TimeSeriesDecoder
+{
+public:
+  /**
+   * Creates a new instance of the TimeSeriesDecoder class.
+   *
+   * @param buffer The block.
+   * @param size The size of the block in bytes, at least the size that was used when it was written.
+   */
+  TimeSeriesDecoder(const uint8_t *buffer, size_t size);
+
+  /**
+   * Returns the number of points in the block.
+   */
+  inline uint16_t count() const { return _count; }
+
+  /**
+   * Reads the next point.
+   *
+   * @param time The destination for the time.
+   * @param value The destination for the value.
+   * @return false when all the points have been read or the block is truncated.
+   */
+  bool next(uint32_t *time, float *value);
+
+private:
+  const uint8_t *_buffer;
+  size_t _sizeBits;
+  size_t _bits; // read so far
+  uint16_t _count;
+  uint16_t _read;
+  uint32_t _time;
+  int32_t _delta;
+  uint32_t _value;
+  uint8_t _leading;
+  uint8_t _trailing;
+
+private:
+  bool readBits(uint8_t count, uint32_t *dest);
+  bool readTime();
+  bool readValue();
+};
+
+#endif // TIME_SERIES_BLOCK_H
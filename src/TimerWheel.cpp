@@ -0,0 +1,109 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(uint32_t tickMs)
+    : _count(0), _tickMs(tickMs > 0 ? tickMs : 1), _tick(0), _lastJitter(0)
+{
+  for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++)
+  {
+    _slots[i] = -1;
+  }
+}
+
+int8_t TimerWheel::add(uint32_t periodMs, uint32_t now)
+{
+  if (_count >= TIMER_WHEEL_MAX_TIMERS || periodMs == 0)
+  {
+    return -1;
+  }
+
+  int8_t id = (int8_t)_count++;
+  _timers[id].periodMs = periodMs;
+  _timers[id].deadline = now;
+  if (_count == 1)
+  {
+    _tick = now / _tickMs;
+  }
+  link(id);
+  return id;
+}
+
+void TimerWheel::link(int8_t id)
+{
+  uint8_t slot = (_timers[id].deadline / _tickMs) % TIMER_WHEEL_SLOTS;
+  _timers[id].next = _slots[slot];
+  _slots[slot] = id;
+}
+
+uint16_t TimerWheel::poll(uint32_t now)
+{
+  // the slots from the last polled tick up to now, all of them once if more than a revolution went past.
+  // The last polled tick is visited again because its timers may not have been due yet.
+  uint32_t tick = now / _tickMs;
+  uint32_t slots = tick - _tick + 1;
+  if (slots > TIMER_WHEEL_SLOTS)
+  {
+    slots = TIMER_WHEEL_SLOTS;
+  }
+
+  uint16_t expired = 0;
+  uint32_t jitter = 0;
+  for (uint32_t i = 0; i < slots; i++)
+  {
+    uint8_t slot = (_tick + i) % TIMER_WHEEL_SLOTS;
+    int8_t *entry = &_slots[slot];
+    while (*entry >= 0)
+    {
+      Timer &timer = _timers[*entry];
+      // subtraction keeps the comparison correct when millis() wraps around
+      int32_t late = (int32_t)(now - timer.deadline);
+      if (late < 0)
+      {
+        entry = &timer.next; // a later revolution
+        continue;
+      }
+
+      if ((uint32_t)late > jitter)
+      {
+        jitter = late;
+      }
+      expired |= (uint16_t)(1U << *entry);
+      *entry = timer.next; // unlinked, linked again below once the slots have been visited
+    }
+  }
+  _tick = tick;
+  if (expired)
+  {
+    _lastJitter = jitter;
+  }
+
+  for (int8_t id = 0; id < (int8_t)_count; id++)
+  {
+    if (expired & (1U << id))
+    {
+      Timer &timer = _timers[id];
+      uint32_t late = now - timer.deadline;
+      timer.deadline += (late / timer.periodMs + 1) * timer.periodMs;
+      link(id);
+    }
+  }
+  return expired;
+}
+
+uint32_t TimerWheel::nextIn(uint32_t now) const
+{
+  // there are only a few timers, looking at all of them is cheaper than walking the empty slots
+  uint32_t next = UINT32_MAX;
+  for (uint8_t id = 0; id < _count; id++)
+  {
+    int32_t remaining = (int32_t)(_timers[id].deadline - now);
+    if (remaining <= 0)
+    {
+      return 0;
+    }
+    if ((uint32_t)remaining < next)
+    {
+      next = remaining;
+    }
+  }
+  return next;
+}
@@ -0,0 +1,80 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Maximum number of timers in a wheel, one bit each in the mask returned by poll()
+#define TIMER_WHEEL_MAX_TIMERS 16
+
+// Number of slots of the wheel, a timer goes in the slot of the tick of its deadline modulo this
+#define TIMER_WHEEL_SLOTS 16
+
+/**
+ * Periodic timers with their own deadlines, multiplexed on a hashed timer wheel.
+ *
+ * Time is divided into ticks and each timer is linked in the slot of the tick its deadline falls in, so a poll
+ * only looks at the timers of the slots it went past rather than at all of them. A timer whose deadline is more
+ * than a revolution away stays in its slot until the wheel comes round to it again.
+ * As with SampleClock, each deadline is derived from the previous one so a late poll does not delay the ones
+ * that follow, and periods that were missed entirely are skipped.
+ *
+ * This file does not depend on Arduino so that it can be used on the host; the time is passed in.
+ */
+class TimerWheel
+{
+public:
+  /**
+   * Creates a new instance of the TimerWheel class.
+   *
+   * @param tickMs The resolution of the wheel in milliseconds, the timers expire at most this late.
+   */
+  TimerWheel(uint32_t tickMs);
+
+  /**
+   * Adds a timer, it is due straight away and then once per period.
+   *
+   * @param periodMs The period of the timer in milliseconds.
+   * @param now The current time in milliseconds.
+   * @return The id of the timer, i.e. its bit in the mask returned by poll(), or -1 if there is no more room.
+   */
+  int8_t add(uint32_t periodMs, uint32_t now);
+
+  /**
+   * Expires the timers whose deadline has been reached and moves them to their next deadline.
+   *
+   * @param now The current time in milliseconds.
+   * @return A bit per timer that expired (1 << id), 0 if none did.
+   */
+  uint16_t poll(uint32_t now);
+
+  /**
+   * Returns the number of milliseconds until the next deadline, 0 if one has been reached and UINT32_MAX if
+   * there is no timer.
+   */
+  uint32_t nextIn(uint32_t now) const;
+
+  /**
+   * Returns how late (in milliseconds) the earliest timer that expired on the last poll was handled.
+   */
+  inline uint32_t lastJitter() const { return _lastJitter; }
+
+private:
+  struct Timer
+  {
+    uint32_t periodMs;
+    uint32_t deadline;
+    int8_t next; // in the same slot, -1 for the last one
+  };
+
+  Timer _timers[TIMER_WHEEL_MAX_TIMERS];
+  int8_t _slots[TIMER_WHEEL_SLOTS]; // first timer of each slot, -1 if empty
+  uint8_t _count;
+  uint32_t _tickMs;
+  uint32_t _tick; // the last tick that was polled
+  uint32_t _lastJitter;
+
+private:
+  void link(int8_t id);
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,91 @@
+#include "WaterLevelSwitch.h"
+
+#ifdef HAVE_WATER_LEVEL_STATE
+
+WaterLevelSwitch::WaterLevelSwitch(uint32_t debounceMs)
+    : _pin(0), _debounceMicros(debounceMs * 1000), _state(false), _changedAtMicros(0), _waiter(nullptr),
+      _pending(false), _firstEdgeMicros(0), _lastEdgeMicros(0)
+{
+}
+
+void WaterLevelSwitch::begin(uint8_t pin)
+{
+  _pin = pin;
+  pinMode(pin, INPUT);
+  _state = (bool)digitalRead(pin);
+  attachInterruptArg(digitalPinToInterrupt(pin), handleInterrupt, this, CHANGE);
+}
+
+void IRAM_ATTR WaterLevelSwitch::handleInterrupt(void *arg)
+{
+  WaterLevelSwitch *sw = static_cast<WaterLevelSwitch *>(arg);
+  uint32_t now = micros();
+
+  portENTER_CRITICAL_ISR(&sw->_mux);
+  if (!sw->_pending)
+  {
+    sw->_pending = true;
+    sw->_firstEdgeMicros = now;
+  }
+  sw->_lastEdgeMicros = now;
+  portEXIT_CRITICAL_ISR(&sw->_mux);
+
+  if (sw->_waiter)
+  {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sw->_waiter, &woken);
+    if (woken)
+    {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
+bool WaterLevelSwitch::maintain()
+{
+  if (!_waiter)
+  {
+    _waiter = xTaskGetCurrentTaskHandle();
+  }
+
+  // the pending flag is checked and cleared at once so that an edge arriving in between starts a new change
+  bool settled = false;
+  uint32_t firstEdgeMicros = 0;
+  portENTER_CRITICAL(&_mux);
+  if (_pending && (micros() - _lastEdgeMicros) >= _debounceMicros)
+  {
+    _pending = false;
+    settled = true;
+    firstEdgeMicros = _firstEdgeMicros;
+  }
+  portEXIT_CRITICAL(&_mux);
+
+  if (!settled)
+  {
+    return false;
+  }
+
+  // the input may have bounced back to where it was
+  bool level = (bool)digitalRead(_pin);
+  if (level == _state)
+  {
+    return false;
+  }
+
+  _state = level;
+  _changedAtMicros = firstEdgeMicros;
+  return true;
+}
+
+uint32_t WaterLevelSwitch::nextDueIn() const
+{
+  if (!_pending)
+  {
+    return UINT32_MAX;
+  }
+
+  uint32_t quiet = micros() - _lastEdgeMicros;
+  return quiet >= _debounceMicros ? 0 : (_debounceMicros - quiet + 999) / 1000;
+}
+
+#endif // HAVE_WATER_LEVEL_STATE
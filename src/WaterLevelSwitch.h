@@ -0,0 +1,75 @@
+#ifndef WATER_LEVEL_SWITCH_H
+#define WATER_LEVEL_SWITCH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#ifdef HAVE_WATER_LEVEL_STATE
+
+/**
+ * Driver for a digital level switch (e.g. SEN0204) that reports changes as soon as they happen.
+ *
+ * The interrupt handler records when the input changes and wakes the task that maintains the switch.
+ * The level is only read once the input has been quiet for the debounce time, so a splashing sump
+ * produces a single change instead of a burst of them.
+ */
+class WaterLevelSwitch
+{
+public:
+  /**
+   * Creates a new instance of the WaterLevelSwitch class.
+   *
+   * @param debounceMs The time in milliseconds the input must be stable for before a change is reported.
+   */
+  WaterLevelSwitch(uint32_t debounceMs);
+
+  /**
+   * Reads the initial level and attaches the interrupt handler to the pin.
+   *
+   * @param pin The pin the sensor is connected to.
+   */
+  void begin(uint8_t pin);
+
+  /**
+   * Checks whether the debounced level has changed.
+   * The task that calls this method is woken up by the interrupt handler, see ulTaskNotifyTake().
+   *
+   * @return true if the level changed since the last call.
+   */
+  bool maintain();
+
+  /**
+   * Returns the debounced level.
+   */
+  inline bool state() const { return _state; }
+
+  /**
+   * Returns the time (micros()) of the first edge of the last change.
+   */
+  inline uint32_t changedAtMicros() const { return _changedAtMicros; }
+
+  /**
+   * Returns the number of milliseconds until the input is expected to settle, UINT32_MAX if nothing is pending.
+   */
+  uint32_t nextDueIn() const;
+
+private:
+  static void IRAM_ATTR handleInterrupt(void *arg);
+
+private:
+  uint8_t _pin;
+  uint32_t _debounceMicros;
+  bool _state;
+  uint32_t _changedAtMicros;
+  TaskHandle_t _waiter; // task to wake up on an edge
+
+  // written by the interrupt handler, read under _mux
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  volatile bool _pending; // edges have been seen since the level was last read
+  volatile uint32_t _firstEdgeMicros;
+  volatile uint32_t _lastEdgeMicros;
+};
+
+#endif // HAVE_WATER_LEVEL_STATE
+
+#endif // WATER_LEVEL_SWITCH_H
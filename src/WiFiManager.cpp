@@ -3,9 +3,33 @@
 #if HAVE_WIFI
 
 #include <esp_eap_client.h>
-#include "reboot.h"
+#include "Profiler.h"
+#include "Logger.h"
 
-WiFiManager::WiFiManager() : _status(WL_IDLE_STATUS)
+#if defined(WIFI_PASSPHRASE)
+#define WIFI_BEGIN_PASSPHRASE WIFI_PASSPHRASE
+#else
+#define WIFI_BEGIN_PASSPHRASE nullptr
+#endif
+
+#if WIFI_FAST_RECONNECT
+#define WIFI_CACHE_MAGIC 0x57494649 // "WIFI"
+
+// The last connection, in RTC memory that is not initialised so that it survives a reset (but not a power cycle,
+// after which the magic number does not match)
+struct WiFiCache
+{
+  uint32_t magic; // WIFI_CACHE_MAGIC when the rest is valid
+  uint8_t bssid[MAC_ADDRESS_LENGTH];
+  uint8_t channel;
+};
+static RTC_NOINIT_ATTR WiFiCache cache;
+#endif
+
+WiFiManager::WiFiManager()
+    : _health(0, WIFI_BACKOFF_MIN_MILLIS, WIFI_BACKOFF_MAX_MILLIS), _connecting(false), _fastAttempt(false),
+      _offline(false), _attemptStarted(0), _offlineSince(0), _connectTime(0), _lastOutage(0), _gotIpEvents(0),
+      _disconnectEvents(0), _gotIpSeen(0), _disconnectSeen(0)
 {
 }
 
@@ -15,6 +39,7 @@ WiFiManager::~WiFiManager()
 
 void WiFiManager::begin()
 {
+  PROFILE_SCOPE("wifi.begin");
   // Set WiFi to station mode and disconnect from an AP if it was previously connected.
   WiFi.mode(WIFI_STA);
 
@@ -23,28 +48,179 @@ void WiFiManager::begin()
 #if !WIFI_SKIP_LIST_NETWORKS
   listNetworks();
 #endif
-  connect(true);
+
+  // Change the hostname to a more useful name. E.g. a default value like "esp32s3-594E40" changes to "fufarm-594E40"
+  // The WiFi stack needs to have been activated (station mode above) hence why this is done here. Otherwise just zeros.
+  WiFi.macAddress(_macAddress);
+  char mac[MAC_ADDRESS_TEXT_LENGTH];
+  formatMacAddress(_macAddress, mac);
+  LOG_INFO("MAC address: %s", mac);
+  snprintf(_hostname, sizeof(_hostname), "fufarm-%02X%02X%02X", _macAddress[3], _macAddress[4], _macAddress[5]);
+  WiFi.setHostname(_hostname);
+  LOG_INFO("Set hostname to %s", _hostname);
+
+#if defined(WIFI_ENTERPRISE_IDENTITY)
+  esp_eap_client_set_identity((uint8_t *)WIFI_ENTERPRISE_IDENTITY, strlen(WIFI_ENTERPRISE_IDENTITY));
+#endif
+#if defined(WIFI_ENTERPRISE_USERNAME)
+  esp_eap_client_set_username((uint8_t *)WIFI_ENTERPRISE_USERNAME, strlen(WIFI_ENTERPRISE_USERNAME));
+#endif
+#if defined(WIFI_ENTERPRISE_PASSWORD)
+  esp_eap_client_set_password((uint8_t *)WIFI_ENTERPRISE_PASSWORD, strlen(WIFI_ENTERPRISE_PASSWORD));
+#endif
+#ifdef WIFI_ENTERPRISE_PASSWORD
+  esp_wifi_sta_enterprise_enable();
+#endif
+
+  // the attempts are paced by this class, the driver would otherwise retry on its own
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+  startAttempt(millis());
 }
 
 void WiFiManager::maintain()
 {
-  connect(false);
-}
+  PROFILE_SCOPE("wifi.maintain");
+  uint32_t now = millis();
 
-void WiFiManager::printMacAddress(uint8_t mac[])
-{
-  for (int i = 5; i >= 0; i--)
+  // an IP address is handled first so that a disconnection reported with it counts as a loss of the connection
+  uint8_t gotIpEvents = _gotIpEvents;
+  if (gotIpEvents != _gotIpSeen)
+  {
+    _gotIpSeen = gotIpEvents;
+    if (_connecting)
+    {
+      connectionEstablished(now);
+    }
+  }
+
+  uint8_t disconnectEvents = _disconnectEvents;
+  if (disconnectEvents != _disconnectSeen)
   {
-    if (mac[i] < 16)
+    _disconnectSeen = disconnectEvents;
+    if (_connecting)
     {
-      Serial.print(F("0"));
+      attemptFailed(now);
     }
-    Serial.print(mac[i], HEX);
-    if (i > 0)
+    else if (_health.ok())
     {
-      Serial.print(F(":"));
+      connectionLost(now);
     }
   }
+
+  if (_connecting && (now - _attemptStarted) >= WIFI_CONNECTION_TIMEOUT_MILLIS)
+  {
+    LOG_WARN("WiFi connection taken too long");
+    attemptFailed(now);
+  }
+
+  if (!_connecting && _health.tick(now))
+  {
+    startAttempt(now);
+  }
+}
+
+void WiFiManager::onEvent(arduino_event_id_t event, arduino_event_info_t info)
+{
+  // runs in the task of the WiFi events, the state is only changed by maintain()
+  switch (event)
+  {
+  case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+    _gotIpEvents++;
+    break;
+  case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    // the disconnections asked for by this class are not failures
+    if (info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE)
+    {
+      _disconnectEvents++;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void WiFiManager::startAttempt(uint32_t now)
+{
+  _connecting = true;
+  _attemptStarted = now;
+
+  int32_t channel = 0;
+  const uint8_t *bssid = nullptr;
+#if WIFI_FAST_RECONNECT
+  _fastAttempt = cache.magic == WIFI_CACHE_MAGIC;
+  if (_fastAttempt)
+  {
+    // straight to the last access point, no scan. The address still comes from DHCP, a cached lease could have
+    // expired and been handed out to another device meanwhile
+    LOG_INFO("Reconnecting to the last WiFi access point");
+    channel = cache.channel;
+    bssid = cache.bssid;
+  }
+#endif
+  if (!_fastAttempt)
+  {
+    LOG_INFO("Attempting to connect to WiFi SSID: %s", WIFI_SSID);
+  }
+
+  WiFi.begin(WIFI_SSID, WIFI_BEGIN_PASSPHRASE, channel, bssid);
+}
+
+void WiFiManager::attemptFailed(uint32_t now)
+{
+  _connecting = false;
+  WiFi.disconnect(); // stops the driver from trying any further
+
+#if WIFI_FAST_RECONNECT
+  // the access point may have moved to another channel or gone, the next attempt scans
+  if (_fastAttempt)
+  {
+    cache.magic = 0;
+  }
+#endif
+
+  _health.initialised(now, false);
+  LOG_WARN("WiFi connection failed, retrying later");
+}
+
+void WiFiManager::connectionLost(uint32_t now)
+{
+  LOG_WARN("WiFi disconnected");
+  _offline = true;
+  _offlineSince = now;
+  _health.failed(now); // retried straight away, then with the backoff
+}
+
+void WiFiManager::connectionEstablished(uint32_t now)
+{
+  _connecting = false;
+  _connectTime = now - _attemptStarted;
+  if (_offline)
+  {
+    _offline = false;
+    _lastOutage = now - _offlineSince;
+  }
+  _health.initialised(now, true);
+
+  uint8_t mac[MAC_ADDRESS_LENGTH];
+  WiFi.BSSID(mac);
+  char bssid[MAC_ADDRESS_TEXT_LENGTH];
+  formatMacAddress(mac, bssid);
+  LOG_INFO("WiFi connected successfully!");
+  LOG_INFO("SSID: %s, BSSID: %s, signal strength (RSSI): %d dBm", WiFi.SSID().c_str(), bssid, (int)WiFi.RSSI());
+  LOG_INFO("IP Address: %s, connect time (ms): %lu", WiFi.localIP().toString().c_str(), (unsigned long)_connectTime);
+
+#if WIFI_FAST_RECONNECT
+  memcpy(cache.bssid, mac, sizeof(cache.bssid));
+  cache.channel = WiFi.channel();
+  cache.magic = WIFI_CACHE_MAGIC;
+#endif
+}
+
+void WiFiManager::formatMacAddress(const uint8_t mac[], char dest[MAC_ADDRESS_TEXT_LENGTH])
+{
+  snprintf(dest, MAC_ADDRESS_TEXT_LENGTH, "%02X:%02X:%02X:%02X:%02X:%02X", mac[5], mac[4], mac[3], mac[2], mac[1],
+           mac[0]);
 }
 
 const __FlashStringHelper *encryptionTypeToString(wifi_auth_mode_t mode)
@@ -120,91 +296,4 @@ void WiFiManager::listNetworks()
 }
 #endif
 
-void WiFiManager::connect(bool initial)
-{
-  // if already connected, there is nothing more to do
-  uint8_t status = WiFi.status();
-  if (status == WL_CONNECTED)
-  {
-    return;
-  }
-
-  // detect disconnection
-  if (_status == WL_CONNECTED && _status != status)
-  {
-    Serial.println(F("WiFi disconnected"));
-  }
-
-  Serial.print(F("Attempting to connect to WiFi SSID: "));
-  Serial.println(WIFI_SSID);
-
-#if defined(WIFI_ENTERPRISE_IDENTITY)
-  esp_eap_client_set_identity((uint8_t *)WIFI_ENTERPRISE_IDENTITY, strlen(WIFI_ENTERPRISE_IDENTITY));
-#endif
-#if defined(WIFI_ENTERPRISE_USERNAME)
-  esp_eap_client_set_username((uint8_t *)WIFI_ENTERPRISE_USERNAME, strlen(WIFI_ENTERPRISE_USERNAME));
-#endif
-#if defined(WIFI_ENTERPRISE_PASSWORD)
-  esp_eap_client_set_password((uint8_t *)WIFI_ENTERPRISE_PASSWORD, strlen(WIFI_ENTERPRISE_PASSWORD));
-#endif
-#ifdef WIFI_ENTERPRISE_PASSWORD
-  esp_wifi_sta_enterprise_enable();
-#endif
-
-#if defined(WIFI_PASSPHRASE)
-  status = WiFi.begin(WIFI_SSID, WIFI_PASSPHRASE);
-#else
-  status = WiFi.begin(WIFI_SSID);
-#endif
-
-  uint32_t started = millis();
-  while (status != WL_CONNECTED)
-  {
-    // Timeout reached – perform a reset
-    if ((millis() - started) > WIFI_CONNECTION_REBOOT_TIMEOUT_MILLIS) {
-      Serial.println(F(" taken too long. Rebooting ...."));
-      reboot();
-    }
-
-    delay(500);
-    Serial.print(F("."));
-    status = WiFi.status();
-  }
-  _status = WL_CONNECTED;
-
-  Serial.println();
-  Serial.println(F("WiFi connected successfully!"));
-  Serial.print(F("SSID: "));
-  Serial.println(WiFi.SSID());
-
-  uint8_t mac[MAC_ADDRESS_LENGTH];
-  WiFi.BSSID(mac);
-  Serial.print(F("BSSID: "));
-  printMacAddress(mac);
-  Serial.println();
-
-  Serial.print(F("Signal strength (RSSI): "));
-  Serial.print(WiFi.RSSI());
-  Serial.println(F(" dBm"));
-
-  Serial.print(F("IP Address: "));
-  Serial.println(WiFi.localIP());
-
-  WiFi.macAddress(_macAddress);
-  Serial.print(F("MAC address: "));
-  printMacAddress(_macAddress);
-  Serial.println();
-
-  // For the first time, set the hostname using the mac address.
-  // Change the hostname to a more useful name. E.g. a default value like "esp32s3-594E40" changes to "fufarm-594E40"
-  // The WiFi stack needs to have been activated by scanning or connecting hence why this is done last. Otherwise just zeros.
-  if (initial)
-  {
-    snprintf(_hostname, sizeof(_hostname), "fufarm-%02X%02X%02X", _macAddress[3], _macAddress[4], _macAddress[5]);
-    WiFi.setHostname(_hostname);
-    Serial.print("Set hostname to ");
-    Serial.println(_hostname);
-  }
-}
-
 #endif // HAVE_WIFI
@@ -6,10 +6,20 @@
 #if HAVE_WIFI
 
 #include <WiFi.h>
+#include "DeviceHealth.h"
+
+#define MAC_ADDRESS_TEXT_LENGTH (MAC_ADDRESS_LENGTH * 3) // e.g. "01:23:45:67:89:AB" plus EOF
 
 /**
  * This class is a wrapper for the WiFi logic.
  * It is where all the WiFi related code is located.
+ *
+ * Connecting never blocks: an attempt is started and the WiFi events report its outcome, which maintain()
+ * picks up. Failed attempts are retried with an exponential backoff (see DeviceHealth.h) rather than rebooting,
+ * so the sensors keep being sampled and spooled while the network is down.
+ * With WIFI_FAST_RECONNECT, the access point and channel of the last connection are kept in RTC memory, which
+ * survives a reset, so that reconnecting skips the scan. The address is always obtained with DHCP. When that fails,
+ * the cache is dropped and the next attempt scans as usual.
  */
 class WiFiManager
 {
@@ -26,7 +36,7 @@ public:
   ~WiFiManager();
 
   /**
-   * Scan for networks and connect to the one configured.
+   * Scan for networks and start connecting to the one configured.
    */
   void begin();
 
@@ -36,11 +46,21 @@ public:
    */
   void maintain();
 
+  /**
+   * Returns true if connected and an IP address was obtained.
+   */
+  inline bool connected() const { return _health.ok(); }
+
   /**
    * Get the station interface IP address.
    */
   inline IPAddress localIP() { return WiFi.localIP(); }
 
+  /**
+   * Get the signal strength (dBm) of the connection.
+   */
+  inline int8_t rssi() { return WiFi.RSSI(); }
+
   /**
    * Get the station interface IP address.
    */
@@ -51,17 +71,45 @@ public:
    */
   inline const char* hostname() { return _hostname; }
 
+  /**
+   * Returns how long (ms) the last successful attempt took from its start until an IP address was obtained.
+   */
+  inline uint32_t connectTime() const { return _connectTime; }
+
+  /**
+   * Returns how long (ms) the last outage lasted, from the loss of the connection until it was back.
+   */
+  inline uint32_t lastOutage() const { return _lastOutage; }
+
 private:
-  uint8_t _status;
   char _hostname[20]; // e.g. "fufarm-012345678901" plus EOF
   uint8_t _macAddress[MAC_ADDRESS_LENGTH];
+  DeviceHealth _health;
+  bool _connecting;
+  bool _fastAttempt; // the current attempt uses the cache
+  bool _offline; // the connection was lost and is not back yet
+  uint32_t _attemptStarted;
+  uint32_t _offlineSince;
+  uint32_t _connectTime;
+  uint32_t _lastOutage;
+
+  // written by the WiFi event handler, each counter is only incremented there so maintain() can compare it with
+  // the last value it saw without a lock
+  volatile uint8_t _gotIpEvents;
+  volatile uint8_t _disconnectEvents;
+  uint8_t _gotIpSeen;
+  uint8_t _disconnectSeen;
 
 private:
-void printMacAddress(uint8_t mac[]);
+  static void formatMacAddress(const uint8_t mac[], char dest[MAC_ADDRESS_TEXT_LENGTH]);
 #if !WIFI_SKIP_LIST_NETWORKS
   void listNetworks();
 #endif
-  void connect(bool initial);
+  void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+  void startAttempt(uint32_t now);
+  void attemptFailed(uint32_t now);
+  void connectionLost(uint32_t now);
+  void connectionEstablished(uint32_t now);
 };
 
 #endif // HAVE_WIFI
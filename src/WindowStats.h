@@ -0,0 +1,79 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * Running statistics of the values read during a sample window, in constant memory.
+ *
+ * The mean and variance are accumulated with Welford's algorithm, which stays accurate for long windows and
+ * values far from zero (e.g. 1000 ppm of CO2) where summing the squares in a float would not.
+ * add() has no branch other than those of fminf/fmaxf, which compile to min/max instructions where available.
+ *
+ * This file does not depend on Arduino so that it can be checked for accuracy on the host.
+ */
+class WindowStats
+{
+public:
+  WindowStats() { reset(); }
+
+  /**
+   * Adds a value. Invalid values (e.g. -1 for a sensor that failed) should be filtered by the caller.
+   */
+  inline void add(float value)
+  {
+    _count++;
+    float delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+    _min = fminf(_min, value);
+    _max = fmaxf(_max, value);
+  }
+
+  /**
+   * Forgets the values, e.g. when a new window starts.
+   */
+  inline void reset()
+  {
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+    _min = INFINITY;
+    _max = -INFINITY;
+  }
+
+  /**
+   * Returns the number of values added.
+   */
+  inline uint16_t count() const { return _count; }
+
+  /**
+   * Returns the mean of the values, NaN if there are none.
+   */
+  inline float mean() const { return _count ? _mean : NAN; }
+
+  /**
+   * Returns the smallest value, NaN if there are none.
+   */
+  inline float min() const { return _count ? _min : NAN; }
+
+  /**
+   * Returns the largest value, NaN if there are none.
+   */
+  inline float max() const { return _count ? _max : NAN; }
+
+  /**
+   * Returns the sample standard deviation of the values, 0 for a single value and NaN if there are none.
+   */
+  inline float stddev() const { return _count > 1 ? sqrtf(_m2 / (_count - 1)) : (_count ? 0 : NAN); }
+
+private:
+  uint16_t _count;
+  float _mean;
+  float _m2; // sum of the squared differences to the mean
+  float _min;
+  float _max;
+};
+
+#endif // WINDOW_STATS_H
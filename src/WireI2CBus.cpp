@@ -0,0 +1,117 @@
+#include "WireI2CBus.h"
+
+// endTransmission() results that mean the device did not acknowledge, the bus itself is fine
+#define I2C_BUS_ERROR_NACK_ADDRESS 2
+#define I2C_BUS_ERROR_NACK_DATA 3
+// requestFrom() returned fewer bytes than requested
+#define I2C_BUS_ERROR_READ 0xFF
+
+// Half a period of the bus clock when toggled by hand (100 kHz)
+#define I2C_BUS_RECOVERY_HALF_PERIOD_MICROS 5
+
+WireI2CBus::WireI2CBus(TwoWire &wire, uint8_t sda, uint8_t scl, uint32_t clockHz, uint16_t timeoutMs)
+    : _wire(wire), _sda(sda), _scl(scl), _clockHz(clockHz), _timeoutMs(timeoutMs), _started(false), _lastError(0)
+{
+}
+
+void WireI2CBus::begin()
+{
+  if (_started)
+  {
+    return;
+  }
+
+  // a device may have been left in the middle of a transaction by a reset of the microcontroller
+  release();
+  start();
+}
+
+void WireI2CBus::start()
+{
+  _wire.begin(_sda, _scl, _clockHz);
+  _wire.setTimeOut(_timeoutMs);
+  _started = true;
+}
+
+bool WireI2CBus::transfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength)
+{
+  if (txLength > 0 || rxLength == 0)
+  {
+    _wire.beginTransmission(address);
+    if (txLength > 0)
+    {
+      _wire.write(tx, txLength);
+    }
+    // a read that follows uses a repeated start so that nothing can get in between
+    _lastError = _wire.endTransmission(rxLength == 0);
+    if (_lastError != 0)
+    {
+      return false;
+    }
+  }
+
+  if (rxLength > 0)
+  {
+    if (_wire.requestFrom(address, rxLength) != rxLength)
+    {
+      _lastError = I2C_BUS_ERROR_READ;
+      return false;
+    }
+    for (uint8_t i = 0; i < rxLength; i++)
+    {
+      rx[i] = _wire.read();
+    }
+  }
+
+  _lastError = 0;
+  return true;
+}
+
+bool WireI2CBus::recover()
+{
+  if (_lastError == I2C_BUS_ERROR_NACK_ADDRESS || _lastError == I2C_BUS_ERROR_NACK_DATA)
+  {
+    return false;
+  }
+
+  // the pins have to be detached from the peripheral to be read and driven by hand
+  _wire.end();
+  bool stuck = release();
+  start();
+  return stuck;
+}
+
+bool WireI2CBus::release()
+{
+  pinMode(_sda, INPUT_PULLUP);
+  pinMode(_scl, INPUT_PULLUP);
+  if (digitalRead(_sda) == HIGH)
+  {
+    return false;
+  }
+
+  // A device holds SDA low because it expects more clock pulses (e.g. it was interrupted while sending a byte).
+  // Up to 9 pulses let it finish the byte and see a NACK, after which it releases SDA.
+  pinMode(_scl, OUTPUT_OPEN_DRAIN);
+  for (uint8_t i = 0; i < 9 && digitalRead(_sda) == LOW; i++)
+  {
+    digitalWrite(_scl, LOW);
+    delayMicroseconds(I2C_BUS_RECOVERY_HALF_PERIOD_MICROS);
+    digitalWrite(_scl, HIGH);
+    delayMicroseconds(I2C_BUS_RECOVERY_HALF_PERIOD_MICROS);
+  }
+
+  // STOP condition: SDA goes high while SCL is high
+  digitalWrite(_scl, LOW);
+  pinMode(_sda, OUTPUT_OPEN_DRAIN);
+  digitalWrite(_sda, LOW);
+  delayMicroseconds(I2C_BUS_RECOVERY_HALF_PERIOD_MICROS);
+  digitalWrite(_scl, HIGH);
+  delayMicroseconds(I2C_BUS_RECOVERY_HALF_PERIOD_MICROS);
+  digitalWrite(_sda, HIGH);
+  delayMicroseconds(I2C_BUS_RECOVERY_HALF_PERIOD_MICROS);
+
+  pinMode(_sda, INPUT_PULLUP);
+  pinMode(_scl, INPUT_PULLUP);
+  return true;
+}
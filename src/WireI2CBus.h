@@ -0,0 +1,49 @@
+#ifndef WIRE_I2C_BUS_H
+#define WIRE_I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "I2CBus.h"
+
+/**
+ * I2C bus on top of an Arduino TwoWire peripheral.
+ */
+class WireI2CBus : public I2CBus
+{
+public:
+  /**
+   * Creates a new instance of the WireI2CBus class.
+   *
+   * @param wire The peripheral to use.
+   * @param sda The SDA pin, needed to detect and free a stuck bus.
+   * @param scl The SCL pin, needed to detect and free a stuck bus.
+   * @param clockHz The bus clock in Hz.
+   * @param timeoutMs The longest a transaction can take before it is abandoned.
+   */
+  WireI2CBus(TwoWire &wire, uint8_t sda, uint8_t scl, uint32_t clockHz, uint16_t timeoutMs);
+
+  /**
+   * Frees the bus if it is stuck and starts the peripheral. Calling it again has no effect.
+   */
+  void begin();
+
+protected:
+  bool transfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength) override;
+  uint32_t clockMicros() override { return micros(); }
+  bool recover() override;
+
+private:
+  TwoWire &_wire;
+  uint8_t _sda;
+  uint8_t _scl;
+  uint32_t _clockHz;
+  uint16_t _timeoutMs;
+  bool _started;
+  uint8_t _lastError; // result of the last endTransmission() or I2C_BUS_ERROR_READ
+
+private:
+  void start();
+  bool release();
+};
+
+#endif // WIRE_I2C_BUS_H
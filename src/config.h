@@ -4,8 +4,77 @@
 // // Uncomment to skip WiFi connection for testing sensors
 // #define HAVE_WIFI 0
 
-// The amount of time to wait for a WiFi connection before rebooting
-#define WIFI_CONNECTION_REBOOT_TIMEOUT_MILLIS 15000 // 15 seconds
+// The amount of time to wait for a WiFi connection attempt before giving up on it and trying again later
+#ifndef WIFI_CONNECTION_TIMEOUT_MILLIS
+#define WIFI_CONNECTION_TIMEOUT_MILLIS 15000 // 15 seconds
+#endif
+
+// The maximum amount of time a sensor read can take before pending conversions are abandoned
+#ifndef ACQUISITION_TIMEOUT_MILLIS
+#define ACQUISITION_TIMEOUT_MILLIS 2000 // 2 seconds
+#endif
+
+// Set SENSORS_WINDOW_STATS to 1 to read the sensors SENSORS_WINDOW_READS times per sample window instead of once,
+// and publish the mean, min, max and standard deviation of the reads along with each value (see WindowStats.h).
+#ifndef SENSORS_WINDOW_STATS
+#define SENSORS_WINDOW_STATS 0
+#endif
+#if SENSORS_WINDOW_STATS
+  #ifndef SENSORS_WINDOW_READS
+  #define SENSORS_WINDOW_READS 6 // every 10 seconds with 1 minute windows
+  #endif
+  #if SAMPLE_WINDOW_MILLIS / SENSORS_WINDOW_READS < ACQUISITION_TIMEOUT_MILLIS * 2
+  #error "SENSORS_WINDOW_READS is too high, a read would start before the previous one could time out"
+  #endif
+#endif
+
+// Set SENSORS_SCHEDULE to 1 to read each group of sensors (see SensorRegistry.h) on its own interval instead of all
+// of them every SAMPLE_WINDOW_MILLIS. A sample is then taken whenever a group is due, and only the values of the
+// groups that were read are published.
+#ifndef SENSORS_SCHEDULE
+#define SENSORS_SCHEDULE 0
+#endif
+#if SENSORS_SCHEDULE
+  #ifndef SENSORS_AIR_INTERVAL_MILLIS
+  #define SENSORS_AIR_INTERVAL_MILLIS SAMPLE_WINDOW_MILLIS
+  #endif
+  #ifndef SENSORS_AIR_QUALITY_INTERVAL_MILLIS
+  #define SENSORS_AIR_QUALITY_INTERVAL_MILLIS 1000 // the ENS160 measures once per second
+  #endif
+  #ifndef SENSORS_TEMP_WET_INTERVAL_MILLIS
+  #define SENSORS_TEMP_WET_INTERVAL_MILLIS SAMPLE_WINDOW_MILLIS
+  #endif
+  #ifndef SENSORS_ANALOG_INTERVAL_MILLIS
+  #define SENSORS_ANALOG_INTERVAL_MILLIS SAMPLE_WINDOW_MILLIS // light, CO2 and moisture
+  #endif
+  #ifndef SENSORS_WATER_INTERVAL_MILLIS
+  #define SENSORS_WATER_INTERVAL_MILLIS 30000 // EC and pH, 30 seconds
+  #endif
+  #ifndef SENSORS_FLOW_INTERVAL_MILLIS
+  #define SENSORS_FLOW_INTERVAL_MILLIS 5000 // 5 seconds
+  #endif
+  #define SENSORS_SCHEDULE_TICK_MILLIS 100
+
+  // the heartbeats and the expiry of the Home Assistant entities are derived from SAMPLE_WINDOW_MILLIS
+  #if SENSORS_AIR_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS || SENSORS_AIR_QUALITY_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS \
+      || SENSORS_TEMP_WET_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS || SENSORS_ANALOG_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS \
+      || SENSORS_WATER_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS || SENSORS_FLOW_INTERVAL_MILLIS > SAMPLE_WINDOW_MILLIS
+  #error "The intervals of SENSORS_SCHEDULE must not be longer than SAMPLE_WINDOW_MILLIS"
+  #endif
+  #if SENSORS_WINDOW_STATS
+  #error "SENSORS_WINDOW_STATS needs all the sensors to be read together, it cannot be used with SENSORS_SCHEDULE"
+  #endif
+#endif
+
+// I2C sensors (AHT20, ENS160) that stop responding are reset and initialised again, in the background.
+// Failed initialisations are retried after a backoff that doubles from MIN up to MAX.
+#define SENSORS_RECOVERY_RESET_MILLIS 20 // AHT20 soft reset time, as per datasheet
+#ifndef SENSORS_RECOVERY_BACKOFF_MIN_MILLIS
+#define SENSORS_RECOVERY_BACKOFF_MIN_MILLIS 1000 // 1 second
+#endif
+#ifndef SENSORS_RECOVERY_BACKOFF_MAX_MILLIS
+#define SENSORS_RECOVERY_BACKOFF_MAX_MILLIS 300000 // 5 minutes
+#endif
 
 #ifdef SENSORS_LIGHT_PIN
   #define HAVE_LIGHT
@@ -27,6 +96,34 @@
   #define HAVE_MOISTURE
 #endif
 
+#if defined(HAVE_LIGHT) || defined(HAVE_CO2) || defined(HAVE_EC) || defined(HAVE_PH) || defined(HAVE_MOISTURE)
+  #define HAVE_ANALOG
+#endif
+
+// Analog channels are oversampled: bursts of samples are spread across the sample window and reduced
+// to a trimmed mean (the lowest and highest ANALOG_TRIM_PERCENT of the samples are discarded).
+#ifndef ANALOG_SAMPLES_PER_BURST
+  #define ANALOG_SAMPLES_PER_BURST 8
+#endif
+#ifndef ANALOG_BURSTS_PER_WINDOW
+  #define ANALOG_BURSTS_PER_WINDOW 6
+#endif
+#ifndef ANALOG_TRIM_PERCENT
+  #define ANALOG_TRIM_PERCENT 20
+#endif
+
+// By default, a background task samples the analog channels at regular intervals and hands the samples to the
+// main loop via a ring buffer. Set to 0 to sample in bursts from the main loop instead.
+#ifndef ANALOG_SAMPLER_TASK
+  #define ANALOG_SAMPLER_TASK 1
+#endif
+#ifndef ANALOG_SAMPLER_TASK_PRIORITY
+  #define ANALOG_SAMPLER_TASK_PRIORITY 2 // the loop runs at 1
+#endif
+#ifndef ANALOG_RING_CAPACITY
+  #define ANALOG_RING_CAPACITY 128 // must be a power of two
+#endif
+
 #ifdef SENSORS_DHT22_PIN
   #define HAVE_DHT22
 #endif
@@ -35,18 +132,64 @@
   #define HAVE_FLOW
 #endif
 
+#ifdef HAVE_FLOW
+  // From the YF-S201 manual, F = 7Q (L/min) i.e. 420 pulses per litre
+  #ifndef SENSORS_SEN0217_PULSES_PER_LITRE
+    #define SENSORS_SEN0217_PULSES_PER_LITRE 420
+  #endif
+  // The flow is considered stopped when there has been no pulse for this long (about 0.07 L/min)
+  #define FLOW_STOPPED_MICROS 2000000 // 2 seconds
+  // The total volume is saved before a reset and at this interval so that little is lost on power failure
+  #ifndef FLOW_TOTAL_SAVE_INTERVAL_MILLIS
+    #define FLOW_TOTAL_SAVE_INTERVAL_MILLIS 3600000 // 1 hour
+  #endif
+#endif
+
 #ifdef SENSORS_SEN0204_PIN
   #define HAVE_WATER_LEVEL_STATE
 #endif
 
+#ifdef HAVE_WATER_LEVEL_STATE
+  // A change of the water level is published once the input has been stable for this long
+  #ifndef SENSORS_SEN0204_DEBOUNCE_MILLIS
+    #define SENSORS_SEN0204_DEBOUNCE_MILLIS 50
+  #endif
+#endif
+
 #ifdef SENSORS_DS18S20_PIN
   #define HAVE_TEMP_WET
 #endif
 
+// The number of DS18S20 probes that can share the bus (e.g. one per reservoir)
+#ifndef SENSORS_DS18S20_MAX_PROBES
+  #define SENSORS_DS18S20_MAX_PROBES 1
+#endif
+
 #ifdef CALIBRATION_TOGGLE_PIN
   #define SUPPORTS_CALIBRATION
 #endif
 
+#if defined(HAVE_AHT20) || defined(HAVE_ENS160)
+  #define HAVE_I2C
+#endif
+
+#ifdef HAVE_I2C
+  // Both the AHT20 and the ENS160 support fast mode (400 kHz)
+  #ifndef I2C_CLOCK_HZ
+    #define I2C_CLOCK_HZ 400000
+  #endif
+  // A transaction that takes longer is abandoned, e.g. when a device stretches the clock forever
+  #ifndef I2C_TIMEOUT_MILLIS
+    #define I2C_TIMEOUT_MILLIS 10
+  #endif
+  #ifndef I2C_SDA_PIN
+    #define I2C_SDA_PIN SDA
+  #endif
+  #ifndef I2C_SCL_PIN
+    #define I2C_SCL_PIN SCL
+  #endif
+#endif
+
 // Validation of the sensor selection
 #if !defined(HAVE_TEMP_WET) && (defined(HAVE_EC) || defined(HAVE_PH))
   #pragma message "⚠️ Without DS18S20 (wet temperature), calibration of EC and PH sensors is done using air temperature which may not be as accurate!"
@@ -69,12 +212,40 @@
   #error "At least one sensor must be configured"
 #endif
 
+// Boot
+// Set FAST_BOOT to 1 to shorten the time until the first publish: the WiFi networks are not listed (set
+// WIFI_SKIP_LIST_NETWORKS to 0 to list them anyway) and the last broker found by service discovery is kept in NVS
+// and connected to straight away while it is discovered again in the background.
+#ifndef FAST_BOOT
+  #define FAST_BOOT 0
+#endif
+#if FAST_BOOT && !defined(WIFI_SKIP_LIST_NETWORKS)
+  #define WIFI_SKIP_LIST_NETWORKS 1
+#endif
+
 // WiFi
 #ifndef HAVE_WIFI
   #define HAVE_WIFI 1
   // #define HAVE_WIFI 0
 #endif
 
+#if HAVE_WIFI
+  // Failed connection attempts are retried after WIFI_BACKOFF_MIN_MILLIS, doubled on each failure up to
+  // WIFI_BACKOFF_MAX_MILLIS. A lost connection is retried straight away.
+  #ifndef WIFI_BACKOFF_MIN_MILLIS
+    #define WIFI_BACKOFF_MIN_MILLIS 1000 // 1 second
+  #endif
+  #ifndef WIFI_BACKOFF_MAX_MILLIS
+    #define WIFI_BACKOFF_MAX_MILLIS 300000 // 5 minutes
+  #endif
+
+  // Set WIFI_FAST_RECONNECT to 0 to always scan for the access point instead of going straight to the access point
+  // and channel of the last connection (e.g. with several access points the device moves between)
+  #ifndef WIFI_FAST_RECONNECT
+    #define WIFI_FAST_RECONNECT 1
+  #endif
+#endif
+
 #if (defined(WIFI_ENTERPRISE_USERNAME) && !defined(WIFI_ENTERPRISE_PASSWORD)) || \
     (!defined(WIFI_ENTERPRISE_USERNAME) && defined(WIFI_ENTERPRISE_PASSWORD))
   #error "Enterprise WIFI (802.1x) requires both username and password"
@@ -104,6 +275,11 @@
 #else
   #define NETWORK_SERVICE_DISCOVERY 0
 #endif
+#if NETWORK_SERVICE_DISCOVERY && FAST_BOOT
+  #define NETWORK_SERVICE_DISCOVERY_CACHE 1
+#else
+  #define NETWORK_SERVICE_DISCOVERY_CACHE 0
+#endif
 
 // Home Assistant
 #if HAVE_NETWORK
@@ -112,6 +288,100 @@
   #define USE_HOME_ASSISTANT 0
 #endif
 
+// Serial
+#ifndef SERIAL_BAUD
+  #define SERIAL_BAUD 9600
+#endif
+
+#if !HAVE_NETWORK
+  // Without a network, samples are sent via Serial as lines of JSON or, with SERIAL_FORMAT_BINARY set to 1,
+  // as binary frames which are several times shorter (see SerialFrame.h). The host can also switch the format
+  // and ask for a faster rate, up to SERIAL_BAUD_MAX (see SerialLink.h).
+  #ifndef SERIAL_FORMAT_BINARY
+    #define SERIAL_FORMAT_BINARY 0
+  #endif
+  #ifndef SERIAL_BAUD_MAX
+    #define SERIAL_BAUD_MAX 115200
+  #endif
+  // The defaults are restored when nothing has been received from the host for this long
+  #ifndef SERIAL_LINK_IDLE_MILLIS
+    #define SERIAL_LINK_IDLE_MILLIS 180000 // 3 minutes
+  #endif
+#endif
+
+// Sample clock
+// Set SAMPLE_CLOCK_ALIGN_WALL to 1 to take samples on wall-clock boundaries (e.g. on every whole minute) once
+// the time has been obtained via SNTP. Only available with a network.
+#ifndef SAMPLE_CLOCK_ALIGN_WALL
+  #define SAMPLE_CLOCK_ALIGN_WALL 0
+#endif
+
+#if SAMPLE_CLOCK_ALIGN_WALL && !HAVE_NETWORK
+  #error "SAMPLE_CLOCK_ALIGN_WALL requires a network to obtain the time"
+#endif
+#if SAMPLE_CLOCK_ALIGN_WALL && SENSORS_SCHEDULE
+  #error "SAMPLE_CLOCK_ALIGN_WALL aligns the sample window, it cannot be used with SENSORS_SCHEDULE"
+#endif
+
+#if SAMPLE_CLOCK_ALIGN_WALL
+  #ifndef SNTP_SERVER
+    #define SNTP_SERVER "pool.ntp.org"
+  #endif
+#endif
+
+// Tasks
+// By default everything runs in the Arduino loop. Set USE_TASKS to 1 to run the sensors and the network
+// in their own tasks, pinned to different cores, with sensor snapshots handed over via a bounded queue.
+#ifndef USE_TASKS
+  #define USE_TASKS 0
+#endif
+
+#if USE_TASKS
+  #define TASKS_SENSOR_CORE ARDUINO_RUNNING_CORE // same as the Arduino loop (1, or 0 on single core chips)
+  #define TASKS_NETWORK_CORE 0 // same as the WiFi stack
+  #define TASKS_SENSOR_STACK_SIZE 4096
+  #define TASKS_NETWORK_STACK_SIZE 8192
+  #define TASKS_NETWORK_INTERVAL_MILLIS 10
+  #ifndef TASKS_QUEUE_CAPACITY
+    #define TASKS_QUEUE_CAPACITY 4
+  #endif
+  // What happens when the network task falls behind: DROP_OLDEST or COALESCE (replace the newest)
+  #ifndef TASKS_QUEUE_POLICY
+    #define TASKS_QUEUE_POLICY DROP_OLDEST
+  #endif
+#endif
+
+// Profiler
+// Set USE_PROFILER to 1 to time the boot and the loop (see Profiler.h). Send "PROFILE" over Serial for the median
+// and 99th percentile of each phase or "TRACE" for the last PROFILER_TRACE_CAPACITY phases as Chrome trace JSON.
+// Without it, the instrumentation compiles to nothing.
+#ifndef USE_PROFILER
+  #define USE_PROFILER 0
+#endif
+
+// Logging
+// The messages are queued (see Logger.h) and written out by a low priority task, or between the samples when
+// there is no network, so logging never waits for Serial. Messages above LOG_LEVEL compile to nothing.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+  #define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+// Each message is logged at most once in this interval, the repeats in between are counted instead
+#ifndef LOG_RATE_LIMIT_MILLIS
+  #define LOG_RATE_LIMIT_MILLIS 10000
+#endif
+// Messages that can wait to be written (a power of two), the ones that do not fit are dropped and counted
+#ifndef LOG_BUFFER_CAPACITY
+  #define LOG_BUFFER_CAPACITY 16
+#endif
+#define LOG_LINE_LENGTH 128
+#define LOG_TASK_STACK_SIZE 2048
+#define LOG_TASK_INTERVAL_MILLIS 50
+
 #include <Version.h>
 #ifndef DEVICE_SOFTWARE_VERSION
 #define DEVICE_SOFTWARE_VERSION "0.1.0"
@@ -130,6 +400,111 @@
   // If we have a lower value here, PING packets are sent every now and then meaning we can detect disconnects sooner.
   // It would be a good idea to calculate the value by halfing the sample duration (SAMPLE_WINDOW_MILLIS) but it may result in too much noise.
   #define HOME_ASSISTANT_MQTT_KEEPALIVE 30
+
+  // By default, each sensor publishes its state on its own topic, i.e. one MQTT message per sensor and sample.
+  // Set HOME_ASSISTANT_BATCHED_STATE to 1 to publish the values of a sample as a single JSON document on a shared
+  // topic instead (<data prefix>/<device id>/state), the discovery configs then use value templates.
+  #ifndef HOME_ASSISTANT_BATCHED_STATE
+    #define HOME_ASSISTANT_BATCHED_STATE 0
+  #endif
+
+  // Set SAMPLE_ADAPTIVE to 1 to adapt the sample window to the signals (see SampleRate.h): it is halved, down to
+  // SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS, while a value moves by more than its deadband per SAMPLE_WINDOW_MILLIS and
+  // doubled, up to SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS, after SAMPLE_ADAPTIVE_QUIET_SAMPLES quiet samples in a row.
+  #ifndef SAMPLE_ADAPTIVE
+    #define SAMPLE_ADAPTIVE 0
+  #endif
+  #if SAMPLE_ADAPTIVE && SENSORS_SCHEDULE
+    #error "SAMPLE_ADAPTIVE changes the window of all the sensors, it cannot be used with SENSORS_SCHEDULE"
+  #endif
+  #if SAMPLE_ADAPTIVE
+    #if !defined(SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS) && SENSORS_WINDOW_STATS
+      // long enough for all the reads of a window
+      #define SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS (ACQUISITION_TIMEOUT_MILLIS * 2 * SENSORS_WINDOW_READS)
+    #elif !defined(SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS)
+      #define SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS (SAMPLE_WINDOW_MILLIS / 6) // 10 seconds with 1 minute windows
+    #endif
+    #ifndef SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS
+      #define SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS (SAMPLE_WINDOW_MILLIS * 4)
+    #endif
+    #ifndef SAMPLE_ADAPTIVE_QUIET_SAMPLES
+      #define SAMPLE_ADAPTIVE_QUIET_SAMPLES 5
+    #endif
+    #if SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS > SAMPLE_WINDOW_MILLIS || SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS < SAMPLE_WINDOW_MILLIS
+      #error "SAMPLE_WINDOW_MILLIS must be between SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS and SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS"
+    #endif
+    #if SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS < ACQUISITION_TIMEOUT_MILLIS * 2
+      #error "SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS is too short, a read would start before the previous one could time out"
+    #endif
+    #if SENSORS_WINDOW_STATS && SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS / SENSORS_WINDOW_READS < ACQUISITION_TIMEOUT_MILLIS * 2
+      #error "SENSORS_WINDOW_READS is too high for SAMPLE_ADAPTIVE_MIN_WINDOW_MILLIS"
+    #endif
+    #define SAMPLE_WINDOW_MAX_MILLIS SAMPLE_ADAPTIVE_MAX_WINDOW_MILLIS
+  #else
+    #define SAMPLE_WINDOW_MAX_MILLIS SAMPLE_WINDOW_MILLIS
+  #endif
+
+  // A value is only published again when it has changed by more than its deadband (see SensorRegistry.h),
+  // at most every PUBLISH_MIN_INTERVAL_MILLIS and at least every PUBLISH_MAX_INTERVAL_MILLIS (heartbeat).
+  // Set PUBLISH_MAX_INTERVAL_MILLIS to 0 to publish every sample.
+  #ifndef PUBLISH_MIN_INTERVAL_MILLIS
+    #define PUBLISH_MIN_INTERVAL_MILLIS 0
+  #endif
+  #ifndef PUBLISH_MAX_INTERVAL_MILLIS
+    #define PUBLISH_MAX_INTERVAL_MILLIS (SAMPLE_WINDOW_MILLIS * 5)
+  #endif
+
+  // The entities become unavailable in Home Assistant when nothing has been received for this long.
+  // The heartbeat is only checked when a sample is published, hence the margin of two of the longest samples.
+  #ifndef HOME_ASSISTANT_EXPIRE_AFTER_SECONDS
+    #define HOME_ASSISTANT_EXPIRE_AFTER_SECONDS ((PUBLISH_MAX_INTERVAL_MILLIS + SAMPLE_WINDOW_MAX_MILLIS * 2) / 1000)
+  #endif
+  #if (PUBLISH_MAX_INTERVAL_MILLIS + SAMPLE_WINDOW_MAX_MILLIS * 2) > HOME_ASSISTANT_EXPIRE_AFTER_SECONDS * 1000
+    #error "PUBLISH_MAX_INTERVAL_MILLIS is too long for HOME_ASSISTANT_EXPIRE_AFTER_SECONDS, the entities would expire between heartbeats"
+  #endif
+
+  // The diagnostics, including the health of the device (heap, stack, loop latency, signal, reconnections, uptime),
+  // are published at most this often
+  #ifndef HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS
+    #define HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS PUBLISH_MAX_INTERVAL_MILLIS
+  #endif
+  #if HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS > PUBLISH_MAX_INTERVAL_MILLIS + SAMPLE_WINDOW_MAX_MILLIS
+    #error "HOME_ASSISTANT_HEALTH_INTERVAL_MILLIS is too long for HOME_ASSISTANT_EXPIRE_AFTER_SECONDS, the health entities would expire"
+  #endif
+
+  // Set USE_SAMPLE_SPOOL to 1 to keep the samples taken while the broker is unreachable in RAM, then on flash
+  // (LittleFS) once the RAM is full, and replay them once reconnected (see SampleSpool.h). They are dropped otherwise.
+  // It mounts LittleFS and obtains the time via SNTP, hence it is off by default.
+  #ifndef USE_SAMPLE_SPOOL
+    #define USE_SAMPLE_SPOOL 0
+  #endif
+  #if USE_SAMPLE_SPOOL
+    #ifndef SAMPLE_SPOOL_RAM_SAMPLES
+      #define SAMPLE_SPOOL_RAM_SAMPLES 16
+    #endif
+    // samples are moved to flash this many at a time, one file each
+    #ifndef SAMPLE_SPOOL_BLOCK_SAMPLES
+      #define SAMPLE_SPOOL_BLOCK_SAMPLES 8
+    #endif
+    // the oldest file is deleted when there are more, 180 blocks of 8 samples is a day with 1 minute samples
+    #ifndef SAMPLE_SPOOL_FLASH_BLOCKS
+      #define SAMPLE_SPOOL_FLASH_BLOCKS 180
+    #endif
+    // one spooled sample is replayed at most this often, so the backlog does not flood the broker
+    #ifndef SAMPLE_SPOOL_REPLAY_INTERVAL_MILLIS
+      #define SAMPLE_SPOOL_REPLAY_INTERVAL_MILLIS 250
+    #endif
+    #if SAMPLE_SPOOL_BLOCK_SAMPLES > SAMPLE_SPOOL_RAM_SAMPLES
+      #error "SAMPLE_SPOOL_BLOCK_SAMPLES must not be larger than SAMPLE_SPOOL_RAM_SAMPLES"
+    #endif
+    // the samples are timestamped with the wall clock
+    #ifndef SNTP_SERVER
+      #define SNTP_SERVER "pool.ntp.org"
+    #endif
+  #endif
+#else
+  #define USE_SAMPLE_SPOOL 0
+  #define SAMPLE_ADAPTIVE 0
 #endif
 
 #if HOME_ASSISTANT_MQTT_TLS
@@ -1,5 +1,22 @@
 #include "config.h"
 #include "sensors.h"
+#include "LoopStats.h"
+#include "SampleClock.h"
+#include "BootTimeline.h"
+#include "Profiler.h"
+#include "Logger.h"
+
+#if SENSORS_SCHEDULE
+#include "TimerWheel.h"
+#endif
+
+#if USE_TASKS
+#include "BoundedQueue.h"
+#endif
+
+#if SAMPLE_CLOCK_ALIGN_WALL
+#include <sys/time.h>
+#endif
 
 #if HAVE_WIFI
 #include "WiFiManager.h"
@@ -8,12 +25,69 @@
 #if HAVE_NETWORK
 #include "ServiceDiscovery.h"
 #include "HomeAssistant.h"
+#include "Diagnostics.h"
+#include "SampleSpool.h"
+#include "SampleRate.h"
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #else
-#include <ArduinoJson.h>
+#include "SensorsJson.h"
+#include "SerialFrame.h"
+#include "SerialLink.h"
+#include "SensorRegistry.h"
 #endif
 
 FuFarmSensors sensors;
 FuFarmSensorsData sensorsData;
+#if !SENSORS_SCHEDULE
+static SampleClock sampleClock(SAMPLE_WINDOW_MILLIS);
+#endif
+#if SENSORS_WINDOW_STATS
+// reads in the middle of the window, they only feed the statistics of the sample
+static SampleClock readClock(SAMPLE_WINDOW_MILLIS / SENSORS_WINDOW_READS);
+#endif
+#if SAMPLE_ADAPTIVE
+static FuFarmSampleRate sampleRate;
+#endif
+#if SENSORS_SCHEDULE
+// the groups of sensors that are fitted with their intervals, the index of each is the id of its timer
+struct SensorsScheduleEntry
+{
+  uint16_t groups;
+  uint32_t intervalMs;
+};
+static const SensorsScheduleEntry sensorsSchedule[] = {
+  // the water level is current on every read, this also takes a sample at least every window
+  {SENSORS_GROUP_WATER_LEVEL, SAMPLE_WINDOW_MILLIS},
+#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
+  {SENSORS_GROUP_AIR, SENSORS_AIR_INTERVAL_MILLIS},
+#endif
+#ifdef HAVE_ENS160
+  {SENSORS_GROUP_AIR_QUALITY, SENSORS_AIR_QUALITY_INTERVAL_MILLIS},
+#endif
+#ifdef HAVE_TEMP_WET
+  {SENSORS_GROUP_TEMP_WET, SENSORS_TEMP_WET_INTERVAL_MILLIS},
+#endif
+#if defined(HAVE_LIGHT) || defined(HAVE_CO2) || defined(HAVE_MOISTURE)
+  {SENSORS_GROUP_ANALOG, SENSORS_ANALOG_INTERVAL_MILLIS},
+#endif
+#if defined(HAVE_EC) || defined(HAVE_PH)
+  {SENSORS_GROUP_WATER, SENSORS_WATER_INTERVAL_MILLIS},
+#endif
+#ifdef HAVE_FLOW
+  {SENSORS_GROUP_FLOW, SENSORS_FLOW_INTERVAL_MILLIS},
+#endif
+};
+static TimerWheel schedule(SENSORS_SCHEDULE_TICK_MILLIS);
+#endif
+static uint32_t waterLevelLatency = 0; // ms from the edge to the publish of the last water level change
+static BootTimeline bootTimeline;
+static Logger logger;
+#if USE_PROFILER
+// the spans of the sensor and network tasks are told apart by their core
+static Profiler profiler([]() -> uint32_t { return micros(); }, []() -> uint8_t { return (uint8_t)xPortGetCoreID(); });
+#endif
 static boolean calibrationMode = false;
 
 // Wifi control
@@ -34,24 +108,82 @@ WiFiUDP udpClient;
 ServiceDiscovery discovery(udpClient);
 #endif
 FuFarmHomeAssistant ha(tcpClient);
+#if USE_SAMPLE_SPOOL
+static SampleSpool spool;
+static uint32_t spoolReplayedMillis = 0;
+#if SENSORS_SCHEDULE
+static uint32_t spooledMillis = 0;
+#endif
+#endif
 #else
-JsonDocument doc;
+SerialLink serialLink(SERIAL_BAUD, SERIAL_FORMAT_BINARY);
+
+// Size of a sample in a binary frame: the overhead and each value, probes are preceded by their number
+#define FUFARM_FRAME_NUMBER_SIZE(...) +SERIAL_FRAME_MAX_VALUE_LENGTH
+#define FUFARM_FRAME_PROBES_SIZE(id, field, count, max, ...) +1 + (max) * SERIAL_FRAME_MAX_VALUE_LENGTH
+static const size_t frameCapacity =
+    SERIAL_FRAME_OVERHEAD FUFARM_SENSORS(FUFARM_FRAME_NUMBER_SIZE, FUFARM_FRAME_PROBES_SIZE, FUFARM_FRAME_NUMBER_SIZE);
+#undef FUFARM_FRAME_NUMBER_SIZE
+#undef FUFARM_FRAME_PROBES_SIZE
 #endif // HAVE_NETWORK
 
+// Tasks
+#if USE_TASKS
+// A sample and the diagnostics of the sensor task taken along with it, so that the network task does not read
+// the state of the sensor task
+struct FuFarmSnapshot
+{
+  FuFarmSensorsData data;
+  FuFarmDiagnostics diagnostics;
+};
+
+// Snapshots are handed from the sensor task to the network task
+static BoundedQueue<FuFarmSnapshot, TASKS_QUEUE_CAPACITY> snapshots(TASKS_QUEUE_POLICY);
+static BoundedQueue<FuFarmWaterLevelEvent, TASKS_QUEUE_CAPACITY> waterLevelEvents(DROP_OLDEST);
+static LoopStats sensorLoopStats, networkLoopStats;
+static TaskHandle_t sensorTaskHandle = nullptr, networkTaskHandle = nullptr;
+static void sensorTask(void *param);
+static void networkTask(void *param);
+#else
+static LoopStats loopStats;
+#endif // USE_TASKS
+
 void setup()
 {
-  Serial.begin(9600);
+  PROFILE_SCOPE("setup");
+#if HAVE_NETWORK
+  Serial.begin(SERIAL_BAUD);
+  logger.begin();
+#else
+  // Serial also carries the samples, the messages are written between them, see maintainNetwork()
+  serialLink.begin();
+#endif
 
   // https://www.arduino.cc/reference/en/language/functions/analog-io/analogreference/
   // no need to set the reference voltage on ESP32-S3 because it offers reads in millivolts
   analogReadResolution(12); // change to 12-bit resolution
 
-  sensors.begin();
-
   // if calibration toggle is shorted then we are in calibration mode
 #ifdef SUPPORTS_CALIBRATION
   pinMode(CALIBRATION_TOGGLE_PIN, INPUT_PULLUP);
   calibrationMode = digitalRead(CALIBRATION_TOGGLE_PIN) == 0;
+#endif
+
+#if HAVE_WIFI
+  // started first so that the association runs in the background while the sensors are initialised
+  if (!calibrationMode)
+  {
+    wifiManager.begin();
+#if HOME_ASSISTANT_MQTT_TLS
+    tcpClient.setCACert(root_ca_certs);
+#endif
+  }
+#endif // HAVE_WIFI
+
+  sensors.begin();
+  bootTimeline.mark(BOOT_SENSORS, millis());
+
+#ifdef SUPPORTS_CALIBRATION
   if (calibrationMode)
   {
     Serial.println(F("Calibration toggle has been shorted hence enter calibration mode. To exit, remove the short and reset."));
@@ -72,20 +204,27 @@ void setup()
   }
 #endif
 
-#if HAVE_WIFI
-  wifiManager.begin();
-#if HOME_ASSISTANT_MQTT_TLS
-  tcpClient.setCACert(root_ca_certs);
+#if SAMPLE_CLOCK_ALIGN_WALL || USE_SAMPLE_SPOOL
+  // the time is obtained in the background, samples are aligned and timestamped once it is available
+  configTime(0, 0, SNTP_SERVER);
+#endif
+
+#if USE_SAMPLE_SPOOL
+  spool.begin();
 #endif
-#endif // HAVE_WIFI
 
 #if HAVE_NETWORK
   ha.setUniqueDeviceId(wifiManager.macAddress(), MAC_ADDRESS_LENGTH);
-  Serial.print(F("Home Assistant Unique Device ID: "));
-  Serial.println(ha.getUniqueId());
+  LOG_INFO("Home Assistant Unique Device ID: %s", ha.getUniqueId());
 #if NETWORK_SERVICE_DISCOVERY
-  discovery.begin(wifiManager.localIP(), wifiManager.hostname(), wifiManager.macAddress());
-  discovery.onHaEndpointUpdated([](NetworkEndpoint *endpoint) { ha.connect(endpoint); });
+  // started once connected, see maintainNetwork()
+  discovery.onHaEndpointUpdated([](NetworkEndpoint *endpoint) {
+    bootTimeline.mark(BOOT_BROKER, millis());
+    ha.connect(endpoint);
+  });
+#if NETWORK_SERVICE_DISCOVERY_CACHE
+  discovery.restore();
+#endif
 #else
   NetworkEndpoint haEndpoint = {
     .type = NetworkEndpointType::DNS,
@@ -94,85 +233,544 @@ void setup()
     .port = HOME_ASSISTANT_MQTT_PORT,
   };
   ha.connect(&haEndpoint);
+  bootTimeline.mark(BOOT_BROKER, millis());
 #endif
 #endif // HAVE_NETWORK
-} // end setup
 
-static uint32_t timepoint = millis();
+#if SENSORS_SCHEDULE
+  for (const SensorsScheduleEntry &entry : sensorsSchedule)
+  {
+    schedule.add(entry.intervalMs, millis());
+  }
+#else
+  sampleClock.begin(millis());
+#endif
+#if SENSORS_WINDOW_STATS
+  readClock.begin(millis());
+#endif
 
-void loop()
+#if USE_TASKS
+  // Sensors and network are on different cores so that a slow sensor does not stall MQTT keep alives
+  // and a slow broker or WiFi reconnection does not stall sampling.
+  xTaskCreatePinnedToCore(sensorTask, "sensors", TASKS_SENSOR_STACK_SIZE, nullptr, 1, &sensorTaskHandle, TASKS_SENSOR_CORE);
+  xTaskCreatePinnedToCore(networkTask, "network", TASKS_NETWORK_STACK_SIZE, nullptr, 1, &networkTaskHandle,
+                          TASKS_NETWORK_CORE);
+#endif
+} // end setup
+
+#if SAMPLE_CLOCK_ALIGN_WALL
+/**
+ * Gets the wall-clock time in milliseconds since the epoch.
+ *
+ * @param dest The destination for the time.
+ * @return false if the time has not been obtained via SNTP yet.
+ */
+static bool wallClockMillis(uint64_t *dest)
 {
-  if (calibrationMode)
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  if (now.tv_sec < 1609459200) // 2021-01-01, anything earlier means the time is not set yet
   {
-    sensors.calibration();
-    return; // nothing else can happen when in calibration mode
+    return false;
   }
 
-  if ((millis() - timepoint) >= SAMPLE_WINDOW_MILLIS)
+  *dest = (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+  return true;
+}
+#endif
+
+#if !HAVE_NETWORK
+/**
+ * Prints a sample via Serial as a line of JSON.
+ */
+static void writeJson(FuFarmSensorsData *data)
+{
+  // write the json into a buffer on the stack (no allocation)
+  char buffer[sensorsJsonCapacity];
+  JsonWriter json(buffer, sizeof(buffer));
+  writeSensorsJson(json, data);
+
+  Serial.write((const uint8_t *)json.c_str(), json.length());
+  Serial.println();
+}
+
+/**
+ * Prints a sample via Serial as a binary frame.
+ */
+static void writeFrame(FuFarmSensorsData *data)
+{
+  // write the frame into a buffer on the stack, see SensorRegistry.h and SerialFrame.h
+  uint8_t buffer[frameCapacity];
+  SerialFrameWriter frame(buffer, sizeof(buffer));
+#define FUFARM_FRAME_NUMBER(id, field, json, deviceClass, unit, stateClass, name, icon, precision, bit, ...) \
+  frame.value(bit, data->field, FUFARM_DECIMALS(precision));
+#define FUFARM_FRAME_PROBES(id, field, count, max, json, deviceClass, unit, name, precision, bit, ...) \
+  frame.values(bit, data->field, data->count, FUFARM_DECIMALS(precision));
+#define FUFARM_FRAME_BINARY(id, field, json, deviceClass, name, icon, bit, ...) frame.value(bit, data->field);
+  FUFARM_SENSORS(FUFARM_FRAME_NUMBER, FUFARM_FRAME_PROBES, FUFARM_FRAME_BINARY)
+#undef FUFARM_FRAME_NUMBER
+#undef FUFARM_FRAME_PROBES
+#undef FUFARM_FRAME_BINARY
+
+  size_t length = frame.end(serialLink.nextSequence());
+  Serial.write(buffer, length);
+}
+#endif // !HAVE_NETWORK
+
+#if HAVE_NETWORK
+/**
+ * Prints when each phase of the boot was reached, once the first sample has been published.
+ */
+static void reportBootTimeline()
+{
+  char phases[LOG_LINE_LENGTH];
+  size_t length = 0;
+  phases[0] = '\0';
+  for (uint8_t i = 0; i < BOOT_PHASES && length < sizeof(phases); i++)
   {
-    timepoint = millis();
-    sensors.read(&sensorsData);
+    BootPhase phase = (BootPhase)i;
+    if (bootTimeline.reached(phase))
+    {
+      int written = snprintf(phases + length, sizeof(phases) - length, " %s %lu", BootTimeline::name(phase),
+                             (unsigned long)bootTimeline.at(phase));
+      length += written > 0 ? written : 0;
+    }
+  }
+  LOG_INFO("Boot phases (ms):%s", phases);
+}
+#endif
+
 #if HAVE_NETWORK
-    ha.update(&sensorsData);
+/**
+ * Fills in the health of the device: memory, stack, loop latency, connectivity and uptime.
+ */
+static void collectHealth(FuFarmDiagnostics *diagnostics)
+{
+  diagnostics->freeHeap = esp_get_free_heap_size();
+  diagnostics->largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#if USE_TASKS
+  uint32_t sensorHeadroom = uxTaskGetStackHighWaterMark(sensorTaskHandle);
+  uint32_t networkHeadroom = uxTaskGetStackHighWaterMark(networkTaskHandle);
+  diagnostics->stackHeadroom = sensorHeadroom < networkHeadroom ? sensorHeadroom : networkHeadroom;
+  uint32_t sensorLatency = sensorLoopStats.max();
+  uint32_t networkLatency = networkLoopStats.max();
+  diagnostics->loopLatency = sensorLatency > networkLatency ? sensorLatency : networkLatency;
 #else
-    // populate json
-#if defined(HAVE_DHT22) || defined(HAVE_AHT20)
-    doc["tempair"] = sensorsData.temperature.air;
-    doc["humidity"] = sensorsData.humidity;
+  diagnostics->stackHeadroom = uxTaskGetStackHighWaterMark(nullptr); // the Arduino loop task
+  diagnostics->loopLatency = loopStats.max();
 #endif
-#ifdef HAVE_ENS160
-    doc["aqi"] = sensorsData.airQuality.index;
-    doc["tvoc"] = sensorsData.airQuality.tvoc;
-    doc["eco2"] = sensorsData.airQuality.eco2;
+#if HAVE_WIFI
+  diagnostics->wifiSignal = wifiManager.connected() ? wifiManager.rssi() : 0;
 #endif
-#ifdef HAVE_TEMP_WET
-    doc["tempwet"] = sensorsData.temperature.wet;
+#if NETWORK_SERVICE_DISCOVERY
+  diagnostics->discoveryUpdates = discovery.updates();
 #endif
-#ifdef HAVE_CO2
-    doc["co2"] = sensorsData.co2;
+  diagnostics->uptime = (uint32_t)(esp_timer_get_time() / 1000000); // millis() wraps after 49 days
+  diagnostics->resetReason = (uint8_t)esp_reset_reason();
+  diagnostics->logDropped = logger.dropped();
+}
 #endif
-#ifdef HAVE_EC
-    doc["ec"] = sensorsData.ec;
+
+/**
+ * Fills in the diagnostics of the sampling: jitter, window and those of the sensors.
+ * With USE_TASKS, the sensor task calls this when it takes a sample so that they are handed over with it.
+ */
+static void collectSampleDiagnostics(FuFarmDiagnostics *diagnostics)
+{
+#if SENSORS_SCHEDULE
+  diagnostics->sampleJitter = schedule.lastJitter();
+#else
+  diagnostics->sampleJitter = sampleClock.lastJitter();
 #endif
-#ifdef HAVE_PH
-    doc["ph"] = sensorsData.ph;
+#if SAMPLE_ADAPTIVE
+  diagnostics->sampleWindow = sampleRate.window();
+#else
+  diagnostics->sampleWindow = SAMPLE_WINDOW_MILLIS;
 #endif
-#ifdef HAVE_FLOW
-    doc["flow"] = sensorsData.flow;
+  sensors.diagnostics(diagnostics);
+}
+
+/**
+ * Publishes a sample to Home Assistant or prints it via Serial when there is no network.
+ *
+ * @param data The sample.
+ * @param diagnostics The diagnostics filled in by collectSampleDiagnostics() with the sample, the others are
+ *                    filled in here.
+ */
+static void publish(FuFarmSensorsData *data, FuFarmDiagnostics *diagnostics)
+{
+  PROFILE_SCOPE("publish");
+#if HAVE_NETWORK
+  diagnostics->waterLevelLatency = waterLevelLatency;
+#if HAVE_WIFI
+  diagnostics->wifiConnectTime = wifiManager.connectTime();
+  diagnostics->wifiOutage = wifiManager.lastOutage();
+#endif
+  diagnostics->bootTime = bootTimeline.at(BOOT_FIRST_PUBLISH);
+  collectHealth(diagnostics);
+#if USE_SAMPLE_SPOOL
+  if (!ha.connected())
+  {
+    // kept until the broker is reachable again, see replaySpool()
+#if SENSORS_SCHEDULE
+    // the fast groups would fill the spool in minutes, one sample per window is kept like without the schedule
+    if (spooledMillis != 0 && millis() - spooledMillis < SAMPLE_WINDOW_MILLIS)
+    {
+      return;
+    }
+    spooledMillis = millis();
+#endif
+    spool.push(data);
+    LOG_INFO("MQTT not connected, samples spooled: %lu", (unsigned long)spool.size());
+    return;
+  }
+#endif
+  ha.update(data, false);
+  if (ha.connected() && bootTimeline.mark(BOOT_FIRST_PUBLISH, millis()))
+  {
+    diagnostics->bootTime = bootTimeline.at(BOOT_FIRST_PUBLISH);
+    reportBootTimeline();
+  }
+  ha.updateDiagnostics(diagnostics);
+#else
+  (void)diagnostics; // only published to Home Assistant
+  if (serialLink.binary())
+  {
+    writeFrame(data);
+  }
+  else
+  {
+    writeJson(data);
+  }
 #endif
-#ifdef HAVE_LIGHT
-    doc["light"] = sensorsData.light;
+}
+
+#if USE_SAMPLE_SPOOL
+/**
+ * Publishes the oldest spooled sample once connected, one every SAMPLE_SPOOL_REPLAY_INTERVAL_MILLIS at most
+ * so that a long backlog does not flood the broker or starve the live samples.
+ */
+static void replaySpool()
+{
+  if (!ha.connected() || millis() - spoolReplayedMillis < SAMPLE_SPOOL_REPLAY_INTERVAL_MILLIS)
+  {
+    return;
+  }
+  spoolReplayedMillis = millis();
+
+  SpooledSample sample;
+  if (spool.peek(&sample) && ha.publishSpooled(&sample))
+  {
+    spool.drop();
+  }
+}
+#endif
+
+/**
+ * Publishes a change of the water level straight away, without waiting for the next sample.
+ * Without a network, the change is only printed with the next sample so that the JSON stream stays uniform.
+ */
+static void publishWaterLevel(FuFarmWaterLevelEvent *event)
+{
+#if HAVE_NETWORK && defined(HAVE_WATER_LEVEL_STATE)
+  if (ha.updateWaterLevel(event->state))
+  {
+    waterLevelLatency = (micros() - event->edgeMicros) / 1000;
+  }
+#endif
+}
+
+/**
+ * Starts reading the sensors when the sample window elapses and collects the conversions that are complete.
+ * With SAMPLE_ADAPTIVE, the window is then adapted to how much the values moved.
+ * With SENSORS_SCHEDULE, only the groups of sensors whose interval elapsed are read.
+ *
+ * @param dest The destination for the sensor data.
+ * @return true when a read completed and the destination was populated.
+ */
+static bool sample(FuFarmSensorsData *dest)
+{
+  PROFILE_SCOPE("sample");
+  sensors.maintain();
+
+#if SENSORS_SCHEDULE
+  uint16_t expired = schedule.poll(millis());
+  if (expired != 0)
+  {
+    uint16_t groups = 0;
+    for (uint8_t i = 0; i < sizeof(sensorsSchedule) / sizeof(sensorsSchedule[0]); i++)
+    {
+      if (expired & (1U << i))
+      {
+        groups |= sensorsSchedule[i].groups;
+      }
+    }
+    sensors.startGroups(groups);
+  }
+#else
+  if (sampleClock.due(millis()))
+  {
+    sensors.startRead();
+#if SAMPLE_CLOCK_ALIGN_WALL
+    // millis() and the wall clock drift apart slowly, so the next deadline is aligned after every sample
+    uint64_t wall;
+    if (wallClockMillis(&wall))
+    {
+      sampleClock.align(millis(), wall);
+    }
 #endif
-#ifdef HAVE_MOISTURE
-    doc["moisture"] = sensorsData.moisture;
+  }
 #endif
-#ifdef HAVE_WATER_LEVEL_STATE
-    doc["water_level"] = sensorsData.waterLevelState;
+#if SENSORS_WINDOW_STATS
+  if (readClock.due(millis()))
+  {
+    // ignored when it falls on the read that closes the window
+    sensors.startRead(false);
+  }
 #endif
 
-    serializeJson(doc, Serial);
-    Serial.println();
-    Serial.flush();
+  if (!sensors.poll(dest))
+  {
+    return false;
+  }
+
+#if SAMPLE_ADAPTIVE
+  uint32_t window = sampleRate.update(dest, millis());
+  if (window != sampleClock.period())
+  {
+    sampleClock.setPeriod(millis(), window);
+#if SENSORS_WINDOW_STATS
+    readClock.setPeriod(millis(), window / SENSORS_WINDOW_READS);
 #endif
   }
+#endif
+  return true;
+}
 
+/**
+ * Returns how long to sleep for before sampling again.
+ * We never sleep past the next sample deadline and while a sensor read is in progress or the water level
+ * is settling, we only sleep until that is due.
+ */
+static uint32_t sampleSleep()
+{
+#if SENSORS_SCHEDULE
+  uint32_t sleep = min((uint32_t)500, schedule.nextIn(millis()));
+#else
+  uint32_t sleep = min((uint32_t)500, sampleClock.nextIn(millis()));
+#endif
+#if SENSORS_WINDOW_STATS
+  sleep = min(sleep, readClock.nextIn(millis()));
+#endif
+  return min(sleep, sensors.nextDueIn());
+}
+
+/**
+ * Sleeps for the given time or until an interrupt (e.g. a water level change) wakes the calling task up.
+ */
+static void sampleWait(uint32_t ms)
+{
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+#if USE_PROFILER && HAVE_NETWORK
+static void printProfile(const char *text, void *context)
+{
+  Serial.print(text);
+}
+
+/**
+ * Answers the PROFILE and TRACE commands sent over Serial (see USE_PROFILER), the other input is ignored.
+ * Without a network, the serial link answers them instead.
+ */
+static void maintainProfiler()
+{
+  static char line[8];
+  static uint8_t lineLength = 0;
+  while (Serial.available() > 0)
+  {
+    char received = (char)Serial.read();
+    if (received != '\n' && received != '\r')
+    {
+      if (lineLength < sizeof(line) - 1)
+      {
+        line[lineLength++] = (char)toupper((unsigned char)received);
+      }
+      continue;
+    }
+
+    line[lineLength] = '\0';
+    lineLength = 0;
+    if (strcmp(line, "PROFILE") == 0)
+    {
+      profiler.writeSummary(printProfile, nullptr);
+      Serial.println();
+    }
+    else if (strcmp(line, "TRACE") == 0)
+    {
+      profiler.writeTrace(printProfile, nullptr);
+      Serial.println();
+    }
+  }
+}
+#endif
+
+/**
+ * Maintains the network which includes checking for WiFi connection, server connection, and sending PINGs.
+ * Without a network, maintains the serial link instead (commands from the host).
+ */
+static void maintainNetwork()
+{
 #if HAVE_WIFI
   wifiManager.maintain();
+  if (wifiManager.connected())
+  {
+    bootTimeline.mark(BOOT_NETWORK, millis());
+  }
 #endif // HAVE_WIFI
 #if HAVE_NETWORK
 #if NETWORK_SERVICE_DISCOVERY
-  discovery.maintain();
+  // mDNS needs the IP address, so it is only started once the first connection is up
+  static bool discoveryStarted = false;
+  if (wifiManager.connected())
+  {
+    if (!discoveryStarted)
+    {
+      discovery.begin(wifiManager.localIP(), wifiManager.hostname(), wifiManager.macAddress());
+      discoveryStarted = true;
+    }
+    discovery.maintain();
+  }
 #endif
   ha.maintain();
+  if (ha.connected())
+  {
+    bootTimeline.mark(BOOT_MQTT, millis());
+  }
+#if USE_SAMPLE_SPOOL
+  replaySpool();
+#endif
+#if USE_PROFILER
+  maintainProfiler();
+#endif
+#else
+  serialLink.maintain();
+  logger.drain();
 #endif // HAVE_NETWORK
+}
+
+// The stats are only printed when Serial is not used for the JSON stream
+#if USE_TASKS
+static void reportLoopStats()
+{
+#if HAVE_NETWORK
+  LOG_INFO("Loop latency (us) sensors max/avg: %lu/%lu, network max/avg: %lu/%lu, snapshots lost: %lu",
+           (unsigned long)sensorLoopStats.max(), (unsigned long)sensorLoopStats.average(),
+           (unsigned long)networkLoopStats.max(), (unsigned long)networkLoopStats.average(),
+           (unsigned long)snapshots.dropped());
+#endif
+  // cleared by the task that records them, the sensor task would otherwise race with this one
+  sensorLoopStats.requestReset();
+  networkLoopStats.requestReset();
+}
+
+static void sensorTask(void *param)
+{
+  FuFarmSnapshot snapshot{};
+  FuFarmWaterLevelEvent event;
+  for (;;)
+  {
+    uint32_t started = micros();
+    if (sensors.pollWaterLevel(&event))
+    {
+      waterLevelEvents.push(event);
+    }
+    if (sample(&snapshot.data))
+    {
+      collectSampleDiagnostics(&snapshot.diagnostics);
+      snapshots.push(snapshot);
+    }
+    sensorLoopStats.record(micros() - started);
+
+    sampleWait(sampleSleep());
+  }
+}
+
+static void networkTask(void *param)
+{
+  FuFarmSnapshot snapshot;
+  FuFarmWaterLevelEvent event;
+  for (;;)
+  {
+    uint32_t started = micros();
+    maintainNetwork();
+    while (waterLevelEvents.pop(&event))
+    {
+      publishWaterLevel(&event);
+    }
+    while (snapshots.pop(&snapshot))
+    {
+      publish(&snapshot.data, &snapshot.diagnostics);
+      reportLoopStats();
+    }
+    networkLoopStats.record(micros() - started);
+
+    vTaskDelay(pdMS_TO_TICKS(TASKS_NETWORK_INTERVAL_MILLIS));
+  }
+}
+#else
+static void reportLoopStats()
+{
+#if HAVE_NETWORK
+  LOG_INFO("Loop latency (us) max/avg: %lu/%lu", (unsigned long)loopStats.max(), (unsigned long)loopStats.average());
+#endif
+  loopStats.requestReset();
+}
+#endif // USE_TASKS
+
+void loop()
+{
+  if (calibrationMode)
+  {
+    sensors.calibration();
+    return; // nothing else can happen when in calibration mode
+  }
+
+#if USE_TASKS
+  // the work is done by the sensor and network tasks created in setup
+  vTaskDelete(NULL);
+#else
+  uint32_t started = micros();
+
+  FuFarmWaterLevelEvent event;
+  if (sensors.pollWaterLevel(&event))
+  {
+    publishWaterLevel(&event);
+  }
+
+  // The conversions complete in the background while the network is maintained below
+  if (sample(&sensorsData))
+  {
+    FuFarmDiagnostics diagnostics{};
+    collectSampleDiagnostics(&diagnostics);
+    publish(&sensorsData, &diagnostics);
+    reportLoopStats();
+  }
+
+  maintainNetwork();
+  loopStats.record(micros() - started);
 
   // This delay should be short so that the networking stuff is maintained correctly.
-  // Network maintenance includes checking for WiFi connection, server connection, and sending PINGs.
-  // Updating of sensor values happens over a longer delay by checking elapsed time above.
-  delay(500);
+  // Updating of sensor values happens over a longer delay by checking the sample clock in sample().
+  sampleWait(sampleSleep());
+#endif // USE_TASKS
 }
 
 void beforeReset()
 {
-  // TODO: save configuration and/or state so that we can resume after reboot (will be useful with auto dosing)
+  // TODO: save configuration so that we can resume after reboot (will be useful with auto dosing)
+  sensors.save();
+#if USE_SAMPLE_SPOOL
+  spool.save();
+#endif
 }
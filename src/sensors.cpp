@@ -1,28 +1,71 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 #include "sensors.h"
+#include "Profiler.h"
+#include "Logger.h"
 
 #define KVALUEADDR 0x00
 
+#if SENSORS_SCHEDULE
+// the samples of the analog channels are reduced as often as the channels read the most often need them
+#define ANALOG_WINDOW_MILLIS min(SENSORS_ANALOG_INTERVAL_MILLIS, SENSORS_WATER_INTERVAL_MILLIS)
+#else
+#define ANALOG_WINDOW_MILLIS SAMPLE_WINDOW_MILLIS
+#endif
+
 FuFarmSensors* FuFarmSensors::_instance = nullptr;
 
+FuFarmSensors::FuFarmSensors() :
+#ifdef HAVE_I2C
+  i2c(Wire, I2C_SDA_PIN, I2C_SCL_PIN, I2C_CLOCK_HZ, I2C_TIMEOUT_MILLIS),
+  i2cCycleStats(),
+#endif
+#if HAVE_AHT20
+  aht20(i2c),
+  aht20Health(SENSORS_RECOVERY_RESET_MILLIS, SENSORS_RECOVERY_BACKOFF_MIN_MILLIS, SENSORS_RECOVERY_BACKOFF_MAX_MILLIS),
+#endif
+#ifdef HAVE_ENS160
+  ens160(i2c),
+  ens160Health(SENSORS_RECOVERY_RESET_MILLIS, SENSORS_RECOVERY_BACKOFF_MIN_MILLIS, SENSORS_RECOVERY_BACKOFF_MAX_MILLIS),
+#endif
+#ifdef HAVE_TEMP_WET
+  ds18(ds),
+#endif
 #ifdef HAVE_FLOW
-static void sen0217InterruptHandler()
-{
-  // An instance will always exist because the interrupt is attached when an instance method is called.
-  // There is therefore no need to check if it is null.
-  // The function is also static meaning it cannot be referenced outside this file.
-  FuFarmSensors::instance()->sen0217Interrupt();
-}
+  flowMeter(SENSORS_SEN0217_PULSES_PER_LITRE),
 #endif
-
+#ifdef HAVE_WATER_LEVEL_STATE
+  waterLevel(SENSORS_SEN0204_DEBOUNCE_MILLIS),
+#endif
+#ifdef HAVE_ANALOG
+  analog(ANALOG_WINDOW_MILLIS),
+#endif
+  readGroups(SENSORS_GROUPS_ALL),
+  queuedGroups(0),
+#if SENSORS_WINDOW_STATS
+  closesWindow(false),
+#endif
+  airTask(this, &FuFarmSensors::startAir, &FuFarmSensors::collectAir, &FuFarmSensors::abortAir),
 #ifdef HAVE_ENS160
-FuFarmSensors::FuFarmSensors() : ens160(&Wire, /* I2C Address */ 0x53)
-#else
-FuFarmSensors::FuFarmSensors()
+  airQualityTask(this, &FuFarmSensors::startAirQuality, &FuFarmSensors::collectAirQuality, &FuFarmSensors::abortAirQuality),
+#endif
+#ifdef HAVE_TEMP_WET
+  tempWetTask(this, &FuFarmSensors::startTempWet, &FuFarmSensors::collectTempWet, &FuFarmSensors::abortTempWet),
 #endif
+  analogTask(this, &FuFarmSensors::startAnalog, &FuFarmSensors::collectAnalog),
+  acquisition(ACQUISITION_TIMEOUT_MILLIS)
 {
   _instance = this;
+
+  // The order matters only slightly: the slowest conversions are started first.
+#ifdef HAVE_TEMP_WET
+  acquisition.add(&tempWetTask);
+#endif
+  acquisition.add(&airTask);
+#ifdef HAVE_ENS160
+  acquisition.add(&airQualityTask);
+#endif
+  acquisition.add(&analogTask);
 }
 
 FuFarmSensors::~FuFarmSensors()
@@ -30,58 +73,48 @@ FuFarmSensors::~FuFarmSensors()
   _instance = nullptr;
 }
 
-void FuFarmSensors::initialiseAHT20()
-{
-#if HAVE_AHT20
-  uint8_t status = -1, count = 0;
-  while ((status = aht20.begin()) != 0)
-  {
-    Serial.print(F("AHT20 sensor initialisation failed. Error status: "));
-    Serial.println(status);
-    count++;
-    if (count > 10)
-    {
-      Serial.println(F("Could not initialise AHT20 sensor - continuing without it"));
-      break;
-    }
-    delay(1000);
-  }
-#endif
-}
-
-
 void FuFarmSensors::begin()
 {
+  PROFILE_SCOPE("sensors.begin");
+  current.temperature.air = SENSORS_TEMPERATURE_INVALID;
+  current.humidity = -1;
+  invalidateAirQuality();
+
 #ifdef HAVE_WATER_LEVEL_STATE
-  pinMode(SENSORS_SEN0204_PIN, INPUT);
+  waterLevel.begin(SENSORS_SEN0204_PIN);
 #endif
 
 #ifdef HAVE_DHT22
   dht.setup(SENSORS_DHT22_PIN, DHTesp::DHT22);
-#elif HAVE_AHT20
-  initialiseAHT20();
 #endif
 
-#ifdef HAVE_ENS160
-  uint8_t status = -1, count = 0;
-  while ((status = ens160.begin()) != NO_ERR)
-  {
-    Serial.print(F("ENS160 sensor initialisation failed. Error status: "));
-    Serial.println(status);
-    count++;
-    if (count > 5)
-    {
-      Serial.println(F("Could not initialise ENS160 sensor - continuing without it"));
-      break;
-    }
-    delay(1000);
-  }
+  // The AHT20 and ENS160 are initialised by maintain() so that a missing or failing sensor does not hold up the boot
+#ifdef HAVE_I2C
+  i2c.begin();
 #endif
 
 #ifdef HAVE_FLOW
-  pulseCount = 0;
-  pinMode(SENSORS_SEN0217_PIN, INPUT);
-  attachInterrupt(digitalPinToInterrupt(SENSORS_SEN0217_PIN), sen0217InterruptHandler, RISING);
+  flowMeter.begin(SENSORS_SEN0217_PIN);
+  flowSavedMillis = millis();
+#endif
+
+#ifdef HAVE_LIGHT
+  lightChannel = analog.addChannel(SENSORS_LIGHT_PIN);
+#endif
+#ifdef HAVE_CO2
+  co2Channel = analog.addChannel(SENSORS_CO2_PIN);
+#endif
+#ifdef HAVE_EC
+  ecChannel = analog.addChannel(SENSORS_EC_PIN);
+#endif
+#ifdef HAVE_PH
+  phChannel = analog.addChannel(SENSORS_PH_PIN);
+#endif
+#ifdef HAVE_MOISTURE
+  moistureChannel = analog.addChannel(SENSORS_MOISTURE_PIN, false);
+#endif
+#ifdef HAVE_ANALOG
+  analog.begin();
 #endif
 
 #ifdef HAVE_EC
@@ -94,6 +127,10 @@ void FuFarmSensors::begin()
 
 #ifdef HAVE_TEMP_WET
   ds.begin(SENSORS_DS18S20_PIN); // Wet temperature chip i/o
+
+  // The ROM codes found here are reused on every read, see startTempWet()
+  uint8_t probes = ds18.enumerate();
+  LOG_INFO("Found DS18S20 probes: %u", probes);
 #endif
 }
 
@@ -182,97 +219,412 @@ void FuFarmSensors::calibration(uint32_t readIntervalMs)
   }
 }
 
+void FuFarmSensors::maintain()
+{
+  maintainHealth(millis());
+#ifdef HAVE_ANALOG
+  analog.maintain(millis());
+#endif
+#ifdef HAVE_FLOW
+  if ((millis() - flowSavedMillis) >= FLOW_TOTAL_SAVE_INTERVAL_MILLIS)
+  {
+    flowSavedMillis = millis();
+    flowMeter.save();
+  }
+#endif
+}
+
+void FuFarmSensors::maintainHealth(uint32_t now)
+{
+  // Each step is a single short I2C transaction, the waiting happens between calls
+#if HAVE_AHT20
+  if (aht20Health.tick(now) && !acquisition.busy())
+  {
+    uint8_t status = aht20.begin();
+    if (status != 0)
+    {
+      LOG_ERROR("AHT20 sensor initialisation failed. Error status: %u", status);
+    }
+    aht20Health.initialised(now, status == 0);
+  }
+#endif
+#ifdef HAVE_ENS160
+  if (ens160Health.tick(now) && !acquisition.busy())
+  {
+    uint8_t status = ens160.begin();
+    if (status != 0)
+    {
+      LOG_ERROR("ENS160 sensor initialisation failed. Error status: %u", status);
+    }
+    ens160Health.initialised(now, status == 0);
+  }
+#endif
+}
+
+void FuFarmSensors::diagnostics(FuFarmDiagnostics *dest) const
+{
+#if HAVE_AHT20
+  dest->aht20Failures = aht20Health.failures();
+#endif
+#ifdef HAVE_ENS160
+  dest->ens160Failures = ens160Health.failures();
+#endif
+#ifdef HAVE_I2C
+  dest->i2cErrors = i2c.stats().errors;
+  dest->i2cCycleMicros = (uint32_t)i2cCycleStats.totalMicros;
+  dest->i2cMaxMicros = i2cCycleStats.maxMicros;
+#endif
+}
+
+void FuFarmSensors::save()
+{
+#ifdef HAVE_FLOW
+  flowMeter.save();
+#endif
+}
+
 void FuFarmSensors::read(FuFarmSensorsData *dest)
 {
-  dest->light = readLight();
+  startRead();
+  while (!poll(dest))
+  {
+    delay(1);
+  }
+}
+
+void FuFarmSensors::startRead(bool closesWindow)
+{
+#if SENSORS_WINDOW_STATS
+  this->closesWindow = this->closesWindow || closesWindow;
+#else
+  (void)closesWindow; // without the window statistics every read is a sample
+#endif
+  if (!acquisition.busy())
+  {
+    startAcquisition(SENSORS_GROUPS_ALL);
+  }
+}
+
+void FuFarmSensors::startGroups(uint16_t groups)
+{
+  if (acquisition.busy())
+  {
+    queuedGroups |= groups;
+    return;
+  }
+  startAcquisition(groups);
+}
+
+void FuFarmSensors::startAcquisition(uint16_t groups)
+{
+  readGroups = groups;
+#ifdef HAVE_I2C
+  i2c.resetStats();
+#endif
+  acquisition.start(millis());
+}
+
+bool FuFarmSensors::poll(FuFarmSensorsData *dest)
+{
+  PROFILE_SCOPE("sensors.poll");
+  if (!acquisition.poll(millis()))
+  {
+    return false;
+  }
+
+  completeRead();
+#if SENSORS_WINDOW_STATS
+  addToWindow();
+  if (!closesWindow)
+  {
+    return false; // only feeds the statistics
+  }
+  closesWindow = false;
+  current.stats = windowStats;
+  windowStats = FuFarmSensorsWindowStats();
+#endif
+  *dest = current;
+
+  // groups that fell due during the read are read straight away
+  if (queuedGroups != 0)
+  {
+    startAcquisition(queuedGroups);
+    queuedGroups = 0;
+  }
+  return true;
+}
+
+#if SENSORS_WINDOW_STATS
+// failed reads are left out of the statistics
+template <typename T>
+static void addToWindow(WindowStats &stats, T value, bool signedValue)
+{
+  if (sensorValueValid(value, signedValue))
+  {
+    stats.add((float)value);
+  }
+}
+
+void FuFarmSensors::addToWindow()
+{
+#define FUFARM_STATS_NUMBER(id, field, json, deviceClass, ...) \
+  ::addToWindow(windowStats.id, current.field, sensorsSigned(deviceClass));
+#define FUFARM_STATS_PROBES(id, field, count, max, json, deviceClass, ...)          \
+  for (uint8_t i = 0; i < current.count; i++)                                       \
+  {                                                                                 \
+    ::addToWindow(windowStats.id[i], current.field[i], sensorsSigned(deviceClass)); \
+  }
+#define FUFARM_STATS_BINARY(...)
+  FUFARM_SENSORS(FUFARM_STATS_NUMBER, FUFARM_STATS_PROBES, FUFARM_STATS_BINARY)
+#undef FUFARM_STATS_NUMBER
+#undef FUFARM_STATS_PROBES
+#undef FUFARM_STATS_BINARY
+}
+#endif
 
-  float airTemperature = -1;
+bool FuFarmSensors::pollWaterLevel(FuFarmWaterLevelEvent *dest)
+{
+#ifdef HAVE_WATER_LEVEL_STATE
+  if (waterLevel.maintain())
+  {
+    dest->state = waterLevel.state();
+    dest->edgeMicros = waterLevel.changedAtMicros();
+    return true;
+  }
+#endif
+  return false;
+}
+
+uint32_t FuFarmSensors::nextDueIn() const
+{
+  uint32_t due = acquisition.nextDueIn(millis());
+#ifdef HAVE_WATER_LEVEL_STATE
+  due = min(due, waterLevel.nextDueIn());
+#endif
+  return due;
+}
+
+int32_t FuFarmSensors::startAir(uint32_t)
+{
+  if (!(readGroups & SENSORS_GROUP_AIR))
+  {
+    return -1; // the values of the last read are kept
+  }
 #ifdef HAVE_DHT22
+  // The DHT22 library reads synchronously, there is nothing to wait for
   TempAndHumidity th = dht.getTempAndHumidity();
-  airTemperature = dest->temperature.air = th.temperature;
-  dest->humidity = th.humidity;
+  current.temperature.air = th.temperature;
+  current.humidity = th.humidity;
+  return -1;
 #elif HAVE_AHT20
-  if (aht20.startMeasurementReady(true))
+  if (!aht20Health.ok())
   {
-    airTemperature = dest->temperature.air = aht20.getTemperature_C();
-    dest->humidity = aht20.getHumidity_RH();
+    current.temperature.air = SENSORS_TEMPERATURE_INVALID;
+    current.humidity = -1;
+    return -1;
   }
-  else
+  if (!aht20.trigger())
   {
-    Serial.println(F("AHT20 sensor not ready - resetting"));
-    airTemperature = dest->temperature.air = -1;
-    dest->humidity = -1;
-    aht20.reset();
-    initialiseAHT20();
+    abortAir();
+    return -1;
   }
+  return AHT20_MEASUREMENT_MILLIS;
+#else
+  current.temperature.air = SENSORS_TEMPERATURE_INVALID;
+  current.humidity = -1;
+  return -1;
+#endif
+}
+
+bool FuFarmSensors::collectAir(uint32_t)
+{
+  PROFILE_SCOPE("sensors.collectAir");
+#if HAVE_AHT20
+  // false while the sensor is busy (or the data is corrupted) hence it is tried again until the timeout
+  return aht20.read(&current.temperature.air, &current.humidity);
 #else
-  airTemperature = dest->temperature.air = -1;
-  dest->humidity = -1;
+  return true;
 #endif
+}
 
+void FuFarmSensors::abortAir()
+{
+  current.temperature.air = SENSORS_TEMPERATURE_INVALID;
+  current.humidity = -1;
+#if HAVE_AHT20
+  // the sensor is initialised again by maintain() once it had time to reset
+  LOG_WARN("AHT20 sensor not ready - resetting");
+  aht20.reset();
+  aht20Health.failed(millis());
+#endif
+}
+
+int32_t FuFarmSensors::startAirQuality(uint32_t)
+{
 #ifdef HAVE_ENS160
-  if (dest->temperature.air != -1 && dest->humidity != -1)
+  if (!(readGroups & SENSORS_GROUP_AIR_QUALITY))
+  {
+    return -1;
+  }
+  if (!ens160Health.ok())
   {
-    ens160.setTempAndHum(dest->temperature.air, dest->humidity);
+    // backing off after a failure, the last readings would otherwise be republished as if they were current
+    invalidateAirQuality();
+    return -1;
+  }
+
+  // The ENS160 measures continuously (once per second) so the values can be collected straight away.
+  // The compensation only applies to the measurements that follow, using the air values from the previous
+  // read does not lose accuracy and means we do not have to wait for the air temperature to be collected.
+  if (sensorValueValid(current.temperature.air, true) && sensorValueValid(current.humidity))
+  {
+    if (!ens160.setTempAndHum(current.temperature.air, current.humidity))
+    {
+      abortAirQuality();
+      return -1;
+    }
   }
   else
   {
-    Serial.println(F("Could not set air temperature and humidity for ENS160. Its values might not be accurate."));
+    LOG_WARN("Could not set air temperature and humidity for ENS160. Its values might not be accurate.");
   }
+  return 0;
+#else
+  return -1;
+#endif
+}
 
-  uint8_t status = ens160.getENS160Status();
-  if (status != DFRobot_ENS160::eSensorStatus_t::eNormalOperation)
+bool FuFarmSensors::collectAirQuality(uint32_t)
+{
+  PROFILE_SCOPE("sensors.collectAirQuality");
+#ifdef HAVE_ENS160
+  // status and measurements are read at once
+  ENS160Reading reading;
+  if (!ens160.read(&reading))
+  {
+    abortAirQuality();
+  }
+  else if (reading.validity != ENS160_VALIDITY_NORMAL)
   {
-    Serial.print(F("ENS160 is not yet in normal operation mode (initial phase can take upto 1 hour). Current mode: "));
-    Serial.println(status);
+    LOG_INFO("ENS160 is not yet in normal operation mode (initial phase can take upto 1 hour). Current mode: %u",
+             reading.validity);
+    invalidateAirQuality();
   }
   else
   {
-    dest->airQuality.index = convertENS160AQItoHA(ens160.getAQI());
-    dest->airQuality.tvoc = ens160.getTVOC();
-    dest->airQuality.eco2 = ens160.getECO2();
+    current.airQuality.index = convertENS160AQItoHA(reading.aqi);
+    current.airQuality.tvoc = reading.tvoc;
+    current.airQuality.eco2 = reading.eco2;
   }
 #endif
+  return true;
+}
 
-  dest->flow = readFlow();
-  dest->co2 = readCO2();
+void FuFarmSensors::abortAirQuality()
+{
+#ifdef HAVE_ENS160
+  // there is no soft reset, the sensor is initialised again by maintain()
+  LOG_WARN("ENS160 sensor not responding");
+  ens160Health.failed(millis());
+  invalidateAirQuality();
+#endif
+}
 
-  float calibrationTemperature = airTemperature;
-#ifdef HAVE_TEMP_WET
-  float wetTemperature = dest->temperature.wet = readTempWet();
-  calibrationTemperature = wetTemperature;
-  if (wetTemperature == -1000 || wetTemperature == -1001 || wetTemperature == -1002)
+void FuFarmSensors::invalidateAirQuality()
+{
+  current.airQuality.index = UINT16_MAX;
+  current.airQuality.tvoc = UINT16_MAX;
+  current.airQuality.eco2 = UINT16_MAX;
+}
+
+int32_t FuFarmSensors::startAnalog(uint32_t)
+{
+  PROFILE_SCOPE("sensors.startAnalog");
+  // The samples were taken across the window, reducing them is fast and is done while the slower conversions are in progress
+  if (readGroups & SENSORS_GROUP_ANALOG)
   {
-    calibrationTemperature = airTemperature;
+    current.light = readLight();
+    current.co2 = readCO2();
+    current.moisture = readMoisture();
   }
+  if (readGroups & SENSORS_GROUP_WATER)
+  {
+#ifdef HAVE_EC
+    ecVoltage = readAnalog(ecChannel, &current.variance.ec);
 #endif
-
-  dest->ec = readEC(calibrationTemperature);
-  dest->ph = readPH(calibrationTemperature);
-  dest->moisture = readMoisture();
-  dest->waterLevelState = readWaterLevelState();
+#ifdef HAVE_PH
+    phVoltage = readAnalog(phChannel, &current.variance.ph);
+#endif
+  }
+  return -1;
 }
 
-#ifdef HAVE_FLOW
-void FuFarmSensors::sen0217Interrupt()
+bool FuFarmSensors::collectAnalog(uint32_t)
 {
-  pulseCount += 1;
+  return true;
 }
+
+void FuFarmSensors::completeRead()
+{
+  PROFILE_SCOPE("sensors.completeRead");
+#ifdef HAVE_I2C
+  i2cCycleStats = i2c.stats();
+#endif
+  if (readGroups & SENSORS_GROUP_FLOW)
+  {
+    current.flow = readFlow();
+    current.flowTotal = readFlowTotal();
+  }
+
+  // the probes are calibrated at 25 °C, which is used when no temperature could be read
+  float calibrationTemperature = sensorValueValid(current.temperature.air, true) ? current.temperature.air : 25;
+#ifdef HAVE_TEMP_WET
+  // the first probe is used for calibration
+  float wetTemperature = current.temperature.wet[0];
+  if (sensorValueValid(wetTemperature, true))
+  {
+    calibrationTemperature = wetTemperature;
+  }
 #endif
 
+  // EC and pH need temperature compensation hence they are computed only once the temperatures are known
+  if (readGroups & SENSORS_GROUP_WATER)
+  {
+    current.ec = readEC(calibrationTemperature);
+    current.ph = readPH(calibrationTemperature);
+  }
+  current.waterLevelState = readWaterLevelState();
+  current.groups = readGroups | SENSORS_GROUP_WATER_LEVEL;
+}
+
 bool FuFarmSensors::readWaterLevelState()
 {
 #ifdef HAVE_WATER_LEVEL_STATE
-  return (bool)digitalRead(SENSORS_SEN0204_PIN);
+  return waterLevel.state();
 #else
   return false;
 #endif
 }
 
+float FuFarmSensors::readAnalog(uint8_t channel, float *variance)
+{
+  // -1 when the channel has no samples, e.g. read again before the sampler took any
+#ifdef HAVE_ANALOG
+  AnalogReading reading = analog.reduce(channel);
+  *variance = reading.count > 0 ? reading.variance : -1;
+  return reading.count > 0 ? reading.value : -1;
+#else
+  return -1;
+#endif
+}
+
 int32_t FuFarmSensors::readLight()
 {
+  PROFILE_SCOPE("sensors.readLight");
 #ifdef HAVE_LIGHT
-  float voltage = analogReadMilliVolts(SENSORS_LIGHT_PIN);
+  float voltage = readAnalog(lightChannel, &current.variance.light);
+  if (voltage < 0)
+    return -1; // no samples
   return (int32_t)(voltage / 10.0);
 #else
   return -1;
@@ -281,11 +633,12 @@ int32_t FuFarmSensors::readLight()
 
 int32_t FuFarmSensors::readCO2()
 {
+  PROFILE_SCOPE("sensors.readCO2");
 #ifdef HAVE_CO2
   // Calculate CO2 concentration in ppm
-  float voltage = analogReadMilliVolts(SENSORS_CO2_PIN);
-  if (voltage == 0.0)
-    return -1.0; // Error
+  float voltage = readAnalog(co2Channel, &current.variance.co2);
+  if (voltage <= 0.0)
+    return -1.0; // Error or no samples
   else if (voltage < 400.0)
     return -2.0; // Preheating
   else
@@ -300,9 +653,11 @@ int32_t FuFarmSensors::readCO2()
 
 float FuFarmSensors::readEC(float temperature)
 {
+  PROFILE_SCOPE("sensors.readEC");
 #ifdef HAVE_EC
-  float voltage = analogReadMilliVolts(SENSORS_EC_PIN);
-  return ecProbe.readEC(voltage, temperature);
+  if (ecVoltage < 0)
+    return -1; // no samples
+  return ecProbe.readEC(ecVoltage, temperature);
 #else
   return -1;
 #endif
@@ -310,26 +665,30 @@ float FuFarmSensors::readEC(float temperature)
 
 float FuFarmSensors::readPH(float temperature)
 {
+  PROFILE_SCOPE("sensors.readPH");
 #ifdef HAVE_PH
-  float voltage = analogReadMilliVolts(SENSORS_PH_PIN);
-  return phProbe.readPH(voltage, temperature);
+  if (phVoltage < 0)
+    return -1; // no samples
+  return phProbe.readPH(phVoltage, temperature);
 #else
   return -1;
 #endif
 }
 
 float FuFarmSensors::readFlow()
+{
+  PROFILE_SCOPE("sensors.readFlow");
+#ifdef HAVE_FLOW
+  return flowMeter.rate();
+#else
+  return -1;
+#endif
+}
+
+float FuFarmSensors::readFlowTotal()
 {
 #ifdef HAVE_FLOW
-  /*
-   * From YF-S201 manual:
-   * Pulse Characteristic:F=7Q(L/MIN).
-   * 2L/MIN=16HZ 4L/MIN=32.5HZ 6L/MIN=49.3HZ 8L/MIN=65.5HZ 10L/MIN=82HZ
-   * sample_window is in milli seconds, so hz is pulseCount * 1000 / SAMPLE_WINDOW_MILLIS
-   * */
-  float hertz = (float)(pulseCount * 1000.0) / SAMPLE_WINDOW_MILLIS;
-  pulseCount = 0; // reset flow counter
-  return hertz / 7.0;
+  return flowMeter.total();
 #else
   return -1;
 #endif
@@ -337,11 +696,14 @@ float FuFarmSensors::readFlow()
 
 int32_t FuFarmSensors::readMoisture()
 {
+  PROFILE_SCOPE("sensors.readMoisture");
 #ifdef HAVE_MOISTURE
   // Need to calibrate this
   int dry = 587;
   int wet = 84;
-  int reading = analogRead(SENSORS_MOISTURE_PIN);
+  float reading = readAnalog(moistureChannel, &current.variance.moisture);
+  if (reading < 0)
+    return -1; // no samples
   return (int32_t)(100.0 * (dry - reading) / (dry - wet));
 #else
   return -1;
@@ -350,58 +712,88 @@ int32_t FuFarmSensors::readMoisture()
 
 float FuFarmSensors::readTempWet()
 {
+  PROFILE_SCOPE("sensors.readTempWet");
 #ifdef HAVE_TEMP_WET
-  // returns the temperature from one DS18S20 in DEG Celsius
-  byte data[12];
-  byte addr[8];
-
-  if (!ds.search(addr))
+  // blocking version used when calibrating
+  if (startTempWet(millis()) >= 0)
   {
-    // no more sensors on chain, reset search
-    ds.reset_search();
-    return -1000;
+    delay(DS18S20_EARLIEST_COMPLETION_MILLIS);
+    uint32_t started = millis();
+    while (!collectTempWet(millis()) && (millis() - started) < DS18S20_CONVERSION_MILLIS)
+    {
+      delay(10);
+    }
   }
+  return current.temperature.wet[0];
+#else
+  return -1;
+#endif
+}
 
-  if (OneWire::crc8(addr, 7) != addr[7])
+int32_t FuFarmSensors::startTempWet(uint32_t now)
+{
+#ifdef HAVE_TEMP_WET
+  if (!(readGroups & SENSORS_GROUP_TEMP_WET))
   {
-    // Serial.println(F("CRC is not valid!"));
-    return -1001;
+    return -1;
   }
 
-  if (addr[0] != 0x10 && addr[0] != 0x28)
+  // The bus is searched again only if a read failed (e.g. probe replaced) or, now and then, for missing probes
+  if (ds18.needsEnumeration(now))
   {
-    // Serial.print(F("Device is not recognized"));
-    return -1002;
+    ds18.enumerate();
   }
 
-  ds.reset();
-  ds.select(addr);
-  ds.write(0x44, 1); // start conversion, with parasite power on at the end
-
-  byte present = ds.reset();
-  if (!present)
+  int32_t wait = ds18.startConversion();
+  if (wait < 0)
   {
-    // TODO: decide if we should return invalid
+    // no more sensors on chain
+    current.temperature.wetCount = 0;
+    for (uint8_t i = 0; i < SENSORS_DS18S20_MAX_PROBES; i++)
+    {
+      current.temperature.wet[i] = -1000;
+    }
   }
-  ds.select(addr);
-  ds.write(0xBE); // Read Scratchpad
+  return wait;
+#else
+  return -1;
+#endif
+}
 
-  for (int i = 0; i < 9; i++)
-  { // we need 9 bytes
-    data[i] = ds.read();
+bool FuFarmSensors::collectTempWet(uint32_t)
+{
+  PROFILE_SCOPE("sensors.collectTempWet");
+#ifdef HAVE_TEMP_WET
+  if (!ds18.conversionComplete())
+  {
+    return false;
   }
 
-  ds.reset_search();
-
-  byte MSB = data[1];
-  byte LSB = data[0];
-
-  float tempRead = ((MSB << 8) | LSB); // using two's compliment
-  float TemperatureSum = tempRead / 16;
+  current.temperature.wetCount = ds18.count();
+  for (uint8_t i = 0; i < SENSORS_DS18S20_MAX_PROBES; i++)
+  {
+    if (i >= ds18.count())
+    {
+      current.temperature.wet[i] = -1000;
+    }
+    else if (!ds18.readTemperature(i, &current.temperature.wet[i]))
+    {
+      // Serial.println(F("CRC is not valid!"));
+      current.temperature.wet[i] = -1001;
+    }
+  }
+#endif
+  return true;
+}
 
-  return TemperatureSum;
-#else
-  return -1;
+void FuFarmSensors::abortTempWet()
+{
+#ifdef HAVE_TEMP_WET
+  // the conversion never completed, which can only happen if the probes are holding the bus
+  for (uint8_t i = 0; i < SENSORS_DS18S20_MAX_PROBES; i++)
+  {
+    current.temperature.wet[i] = -1001;
+  }
 #endif
 }
 
@@ -2,7 +2,19 @@
 #define SENSORS_H
 
 #include <stdint.h>
+#include <math.h>
 #include "config.h"
+#include "Acquisition.h"
+#include "AnalogSampler.h"
+#include "DeviceHealth.h"
+#include "Diagnostics.h"
+#include "FlowMeter.h"
+#include "WaterLevelSwitch.h"
+
+#include "SensorRegistry.h"
+#if SENSORS_WINDOW_STATS
+#include "WindowStats.h"
+#endif
 
 #ifdef HAVE_EC
 #include <DFRobot_EC.h>
@@ -17,19 +29,37 @@
 #endif
 
 #ifdef HAVE_TEMP_WET
-#include <OneWire.h>
+#include "DS18S20Bus.h"
+#endif
+
+#ifdef HAVE_I2C
+#include "WireI2CBus.h"
 #endif
 
 #ifdef HAVE_AHT20
-#include <DFRobot_AHT20.h>
+#include "AHT20Sensor.h"
 #endif
 
 #ifdef HAVE_ENS160
-#include <DFRobot_ENS160.h>
+#include "ENS160Sensor.h"
 #endif
 
 #include "config.h"
 
+#if SENSORS_WINDOW_STATS
+// The statistics of the reads of a window, one per value of the sensor registry (and per probe)
+#define FUFARM_STATS_NUMBER(id, ...) WindowStats id;
+#define FUFARM_STATS_PROBES(id, field, count, max, ...) WindowStats id[max];
+#define FUFARM_STATS_BINARY(...)
+struct FuFarmSensorsWindowStats
+{
+  FUFARM_SENSORS(FUFARM_STATS_NUMBER, FUFARM_STATS_PROBES, FUFARM_STATS_BINARY)
+};
+#undef FUFARM_STATS_NUMBER
+#undef FUFARM_STATS_PROBES
+#undef FUFARM_STATS_BINARY
+#endif
+
 struct FuFarmSensorsData
 {
   // light intensity (lux)
@@ -41,6 +71,9 @@ struct FuFarmSensorsData
   // measured in L/min
   float flow;
 
+  // total volume that has flowed through the sensor (L)
+  float flowTotal;
+
   // measured in ppm
   int32_t co2;
   struct FuFarmSensorsTemperature
@@ -48,8 +81,11 @@ struct FuFarmSensorsData
     // measured in °C
     float air;
 
-    // measured in °C
-    float wet;
+    // measured in °C, one value per probe on the DS18S20 bus
+    float wet[SENSORS_DS18S20_MAX_PROBES];
+
+    // number of probes found on the DS18S20 bus
+    uint8_t wetCount;
   } temperature;
 
   // measured in mS/cm
@@ -74,6 +110,54 @@ struct FuFarmSensorsData
     // range: 400–65000, unit: ppm (parts per million)
     uint16_t eco2;
   } airQuality;
+
+  // Variance of the ADC samples each analog value was computed from, -1 when there were none.
+  // The unit is mV² except for moisture which is in raw ADC counts².
+  struct FuFarmSensorsAnalogVariance
+  {
+    float light;
+    float co2;
+    float ec;
+    float ph;
+    float moisture;
+  } variance;
+
+#if SENSORS_WINDOW_STATS
+  // Statistics of the reads taken during the window, the values above are those of the last read
+  FuFarmSensorsWindowStats stats;
+#endif
+
+  // The groups of sensors (SENSORS_GROUP_*) that were read for this sample, the values of the others are those
+  // of their last read. All of them unless SENSORS_SCHEDULE is set.
+  uint16_t groups;
+};
+
+// The air temperature could not be read. The temperatures can be below zero, so their failures are reported
+// below absolute zero instead of with -1, like those of the DS18S20.
+#define SENSORS_TEMPERATURE_INVALID -1000
+
+// The sensors report a failure with a value that is out of their range: -1 for any value that could not be read,
+// -2 for the CO2 sensor preheating, SENSORS_TEMPERATURE_INVALID for the air temperature, -1000 to -1002 for the
+// DS18S20 and UINT16_MAX for the air quality.
+// These return false for them, e.g. to leave them out of statistics. signedValue is true for the values that can
+// be below zero (see sensorsSigned()).
+inline bool sensorValueValid(float value, bool signedValue = false)
+{
+  return !isnan(value) && (signedValue ? value > SENSORS_TEMPERATURE_INVALID : value >= 0);
+}
+inline bool sensorValueValid(int32_t value, bool = false) { return value >= 0; }
+inline bool sensorValueValid(uint16_t value, bool = false) { return value != UINT16_MAX; }
+
+/**
+ * A change of the water level, reported as soon as it happens rather than with the next sample.
+ */
+struct FuFarmWaterLevelEvent
+{
+  // the new level
+  bool state;
+
+  // time (micros()) of the edge that started the change
+  uint32_t edgeMicros;
 };
 
 /**
@@ -110,42 +194,116 @@ public:
    */
   void calibration(uint32_t readIntervalMs = 1000U);
 
+  /**
+   * Takes the samples that are due for the analog sensors, recovers I2C sensors that failed and saves the
+   * flow total from time to time. Nothing here blocks for more than a few milliseconds.
+   * This should be called periodically inside the main loop of the firmware.
+   */
+  void maintain();
+
+  /**
+   * Saves the state that should survive a reboot (e.g. the flow total).
+   * This should be called before a reset.
+   */
+  void save();
+
   /**
    * Reads all sensor data and stores it in the provided FuFarmSensorsData structure.
+   * This blocks until all conversions are complete. Prefer startRead() and poll() in the main loop.
    *
    * @param dest The destination structure to store the sensor data.
    */
   void read(FuFarmSensorsData *dest);
 
   /**
-   * Returns existing instance (singleton) of the FuFarmSensors class.
-   * It may be a null pointer if the FuFarmSensors object was never constructed or it was destroyed.
+   * Starts reading all sensors without waiting for the conversions to complete.
+   * Conversions on different devices (e.g. AHT20, DS18S20) run at the same time.
+   * Nothing happens if a read is already in progress, except that it then closes the window if asked to.
+   *
+   * @param closesWindow With SENSORS_WINDOW_STATS, false for a read in the middle of the window that only feeds
+   *                     the statistics, poll() then never returns true for it.
    */
-  inline static FuFarmSensors *instance() { return _instance; }
+  void startRead(bool closesWindow = true);
 
-#ifdef HAVE_FLOW
+  /**
+   * Starts reading some groups of sensors (SENSORS_GROUP_*) like startRead(), the other values are kept from their
+   * last read. If a read is already in progress, the groups are read as soon as it completes.
+   *
+   * @param groups The groups to read.
+   */
+  void startGroups(uint16_t groups);
 
   /**
-   * Interrupt handler for the flow sensor.
-   * This should only be called from the interrupt handler.
+   * Collects the conversions that are complete.
+   * This should be called frequently (e.g. on every loop) while a read is in progress.
+   *
+   * @param dest The destination structure to store the sensor data once all the conversions are complete.
+   * @return true if the read completed and the destination was populated, false otherwise. With
+   *         SENSORS_WINDOW_STATS, only the read that closes the window populates the destination, with the
+   *         statistics of all the reads of the window.
    */
-  void sen0217Interrupt();
-#endif
+  bool poll(FuFarmSensorsData *dest);
+
+  /**
+   * Returns true if a read is in progress.
+   */
+  inline bool reading() const { return acquisition.busy(); }
+
+  /**
+   * Checks whether the water level has changed since the last call.
+   * This should be called on every loop so that changes are published without waiting for the next sample.
+   *
+   * @param dest The destination for the change.
+   * @return true if the level changed and the destination was populated.
+   */
+  bool pollWaterLevel(FuFarmWaterLevelEvent *dest);
+
+  /**
+   * Returns the number of milliseconds until the next pending conversion or water level change is due,
+   * UINT32_MAX if nothing is pending. This can be used to decide how long to sleep for in the main loop.
+   */
+  uint32_t nextDueIn() const;
+
+  /**
+   * Populates the diagnostics that relate to the sensors (e.g. failure counters).
+   *
+   * @param dest The destination for the diagnostics.
+   */
+  void diagnostics(FuFarmDiagnostics *dest) const;
+
+  /**
+   * Returns the engine used for reading so that the timings of the last read can be inspected.
+   */
+  inline const AcquisitionEngine &acquisitionStats() const { return acquisition; }
+
+  /**
+   * Returns existing instance (singleton) of the FuFarmSensors class.
+   * It may be a null pointer if the FuFarmSensors object was never constructed or it was destroyed.
+   */
+  inline static FuFarmSensors *instance() { return _instance; }
 
 
 private:
+#ifdef HAVE_I2C
+  WireI2CBus i2c; // Shared by the AHT20 and ENS160
+  I2CBusStats i2cCycleStats; // bus usage of the last read
+#endif
+
 #ifdef HAVE_DHT22
   DHTesp dht; // Temperature and Humidity
 #elif HAVE_AHT20
-  DFRobot_AHT20 aht20; // Temperature and Humidity
+  AHT20Sensor aht20; // Temperature and Humidity
+  DeviceHealth aht20Health;
 #endif
 
 #ifdef HAVE_ENS160
-  DFRobot_ENS160_I2C ens160; // Air Quality & MultiGas
+  ENS160Sensor ens160; // Air Quality & MultiGas
+  DeviceHealth ens160Health;
 #endif
 
 #ifdef HAVE_TEMP_WET
   OneWire ds; // Wet temperature chip i/o
+  DS18S20Bus ds18; // Wet temperature probes on the bus
 #endif
 
 #ifdef HAVE_EC
@@ -157,19 +315,91 @@ private:
 #endif
 
 #ifdef HAVE_FLOW
-  volatile int pulseCount; // Flow Sensor
+  FlowMeter flowMeter; // Flow Sensor
+  uint32_t flowSavedMillis; // when the flow total was last saved
+#endif
+
+#ifdef HAVE_WATER_LEVEL_STATE
+  WaterLevelSwitch waterLevel; // Water Level Sensor
+#endif
+
+#ifdef HAVE_ANALOG
+  AnalogSampler analog; // Light, CO2, EC, pH and Moisture
+#endif
+#ifdef HAVE_LIGHT
+  uint8_t lightChannel;
+#endif
+#ifdef HAVE_CO2
+  uint8_t co2Channel;
+#endif
+#ifdef HAVE_EC
+  uint8_t ecChannel;
+#endif
+#ifdef HAVE_PH
+  uint8_t phChannel;
+#endif
+#ifdef HAVE_MOISTURE
+  uint8_t moistureChannel;
+#endif
+
+private:
+  // Values are collected here as the conversions complete and copied out when the read is complete.
+  FuFarmSensorsData current;
+  uint16_t readGroups;   // by the read in progress
+  uint16_t queuedGroups; // to read once it completes
+#if SENSORS_WINDOW_STATS
+  FuFarmSensorsWindowStats windowStats; // of the reads completed since the window started
+  bool closesWindow; // the read in progress closes the window
+#endif
+#ifdef HAVE_EC
+  float ecVoltage;
+#endif
+#ifdef HAVE_PH
+  float phVoltage;
+#endif
+
+  // The tasks run by the acquisition engine, one per device (or group of devices) with its own conversion time.
+  AcquisitionMethodTask<FuFarmSensors> airTask;
+#ifdef HAVE_ENS160
+  AcquisitionMethodTask<FuFarmSensors> airQualityTask;
+#endif
+#ifdef HAVE_TEMP_WET
+  AcquisitionMethodTask<FuFarmSensors> tempWetTask;
+#endif
+  AcquisitionMethodTask<FuFarmSensors> analogTask;
+  AcquisitionEngine acquisition;
+
+private:
+  int32_t startAir(uint32_t now);
+  bool collectAir(uint32_t now);
+  void abortAir();
+  int32_t startAirQuality(uint32_t now);
+  bool collectAirQuality(uint32_t now);
+  void abortAirQuality();
+  void invalidateAirQuality();
+  int32_t startTempWet(uint32_t now);
+  bool collectTempWet(uint32_t now);
+  void abortTempWet();
+  int32_t startAnalog(uint32_t now);
+  bool collectAnalog(uint32_t now);
+  void startAcquisition(uint16_t groups);
+  void completeRead();
+#if SENSORS_WINDOW_STATS
+  void addToWindow();
 #endif
 
 private:
+  float readAnalog(uint8_t channel, float *variance);
   int32_t readLight();
   int32_t readCO2();
   float readEC(float temperature);
   float readPH(float temperature);
   float readFlow();
+  float readFlowTotal();
   int32_t readMoisture();
   float readTempWet();
   bool readWaterLevelState();
-  void initialiseAHT20();
+  void maintainHealth(uint32_t now);
 
 private:
   char buffer[10];
@@ -0,0 +1,215 @@
+#include <unity.h>
+#include "Acquisition.h"
+
+/**
+ * A task whose conversion takes a fixed time and that may still be busy when it is first collected.
+ */
+class FakeTask : public AcquisitionTask
+{
+public:
+  FakeTask(int32_t wait, uint8_t busyPolls = 0) : wait(wait), busyPolls(busyPolls) {}
+
+  int32_t start(uint32_t now) override
+  {
+    starts++;
+    startedAt = now;
+    return wait;
+  }
+
+  bool collect(uint32_t now) override
+  {
+    collects++;
+    if (busyPolls > 0)
+    {
+      busyPolls--;
+      return false;
+    }
+    collectedAt = now;
+    return true;
+  }
+
+  void abort() override { aborts++; }
+
+  int32_t wait;
+  uint8_t busyPolls;
+  uint8_t starts = 0;
+  uint8_t collects = 0;
+  uint8_t aborts = 0;
+  uint32_t startedAt = 0;
+  uint32_t collectedAt = 0;
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_tasks_overlap(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask slow(750), fast(100), instant(0);
+  engine.add(&slow);
+  engine.add(&fast);
+  engine.add(&instant);
+
+  engine.start(1000);
+  TEST_ASSERT_TRUE(engine.busy());
+  // every conversion is started before any is collected
+  TEST_ASSERT_EQUAL(1, slow.starts);
+  TEST_ASSERT_EQUAL(1, fast.starts);
+  TEST_ASSERT_EQUAL(1, instant.starts);
+
+  TEST_ASSERT_FALSE(engine.poll(1000));
+  TEST_ASSERT_EQUAL(1, instant.collects);
+  TEST_ASSERT_EQUAL(0, fast.collects);
+
+  TEST_ASSERT_FALSE(engine.poll(1100));
+  TEST_ASSERT_EQUAL(1100, fast.collectedAt);
+  TEST_ASSERT_EQUAL(0, slow.collects);
+
+  TEST_ASSERT_TRUE(engine.poll(1750));
+  TEST_ASSERT_FALSE(engine.busy());
+  TEST_ASSERT_EQUAL(1750, slow.collectedAt);
+
+  // the cycle takes as long as the slowest task, not the sum of all of them
+  TEST_ASSERT_EQUAL_UINT32(750, engine.lastDuration());
+  TEST_ASSERT_EQUAL_UINT32(0 + 100 + 750, engine.lastSerialDuration());
+  TEST_ASSERT_EQUAL(0, engine.lastTimeouts());
+}
+
+void test_poll_completes_once(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask task(10);
+  engine.add(&task);
+
+  engine.start(0);
+  TEST_ASSERT_TRUE(engine.poll(10));
+  TEST_ASSERT_FALSE(engine.poll(20));
+  TEST_ASSERT_EQUAL(1, task.collects);
+}
+
+void test_start_ignored_while_busy(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask task(100);
+  engine.add(&task);
+
+  engine.start(0);
+  engine.start(50);
+  TEST_ASSERT_EQUAL(1, task.starts);
+  TEST_ASSERT_TRUE(engine.poll(100));
+}
+
+void test_busy_task_polled_again(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask task(10, 2);
+  engine.add(&task);
+
+  engine.start(0);
+  TEST_ASSERT_FALSE(engine.poll(10));
+  TEST_ASSERT_FALSE(engine.poll(15));
+  TEST_ASSERT_TRUE(engine.poll(20));
+  TEST_ASSERT_EQUAL(3, task.collects);
+  TEST_ASSERT_EQUAL(0, engine.lastTimeouts());
+}
+
+void test_timeout_aborts_pending_tasks(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask stuck(10, 255), late(5000), fine(10);
+  engine.add(&stuck);
+  engine.add(&late);
+  engine.add(&fine);
+
+  engine.start(0);
+  TEST_ASSERT_FALSE(engine.poll(10));
+  TEST_ASSERT_EQUAL(1, fine.collects);
+  TEST_ASSERT_FALSE(engine.poll(1999));
+  TEST_ASSERT_EQUAL(0, stuck.aborts);
+
+  TEST_ASSERT_TRUE(engine.poll(2000));
+  TEST_ASSERT_EQUAL(1, stuck.aborts);
+  TEST_ASSERT_EQUAL(1, late.aborts);
+  TEST_ASSERT_EQUAL(0, late.collects);
+  TEST_ASSERT_EQUAL(0, fine.aborts);
+  TEST_ASSERT_EQUAL(2, engine.lastTimeouts());
+  TEST_ASSERT_FALSE(engine.busy());
+}
+
+void test_task_not_started(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask missing(-1), present(20);
+  engine.add(&missing);
+  engine.add(&present);
+
+  engine.start(0);
+  TEST_ASSERT_TRUE(engine.poll(20));
+  TEST_ASSERT_EQUAL(0, missing.collects);
+  TEST_ASSERT_EQUAL(0, missing.aborts);
+}
+
+void test_next_due_in(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask slow(750), fast(100);
+  engine.add(&slow);
+  engine.add(&fast);
+
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, engine.nextDueIn(0));
+
+  engine.start(1000);
+  TEST_ASSERT_EQUAL_UINT32(100, engine.nextDueIn(1000));
+  TEST_ASSERT_EQUAL_UINT32(40, engine.nextDueIn(1060));
+  TEST_ASSERT_EQUAL_UINT32(0, engine.nextDueIn(1100));
+  TEST_ASSERT_EQUAL_UINT32(0, engine.nextDueIn(1200)); // overdue
+
+  engine.poll(1100);
+  TEST_ASSERT_EQUAL_UINT32(650, engine.nextDueIn(1100));
+
+  engine.poll(1750);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, engine.nextDueIn(1750));
+}
+
+void test_millis_wrap(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask task(100);
+  engine.add(&task);
+
+  uint32_t start = UINT32_MAX - 49;
+  engine.start(start);
+  TEST_ASSERT_EQUAL_UINT32(100, engine.nextDueIn(start));
+  TEST_ASSERT_FALSE(engine.poll(start + 99));
+  TEST_ASSERT_TRUE(engine.poll(start + 100));
+  TEST_ASSERT_EQUAL_UINT32(100, engine.lastDuration());
+}
+
+void test_add_limit(void)
+{
+  AcquisitionEngine engine(2000);
+  FakeTask tasks[ACQUISITION_MAX_TASKS + 1] = {
+    FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0), FakeTask(0),
+  };
+  for (uint8_t i = 0; i < ACQUISITION_MAX_TASKS; i++)
+  {
+    TEST_ASSERT_TRUE(engine.add(&tasks[i]));
+  }
+  TEST_ASSERT_FALSE(engine.add(&tasks[ACQUISITION_MAX_TASKS]));
+  TEST_ASSERT_FALSE(engine.add(nullptr));
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_tasks_overlap);
+  RUN_TEST(test_poll_completes_once);
+  RUN_TEST(test_start_ignored_while_busy);
+  RUN_TEST(test_busy_task_polled_again);
+  RUN_TEST(test_timeout_aborts_pending_tasks);
+  RUN_TEST(test_task_not_started);
+  RUN_TEST(test_next_due_in);
+  RUN_TEST(test_millis_wrap);
+  RUN_TEST(test_add_limit);
+  return UNITY_END();
+}
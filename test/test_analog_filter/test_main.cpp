@@ -0,0 +1,129 @@
+#include <unity.h>
+#include "AnalogFilter.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_sort(void)
+{
+  uint16_t values[] = {5, 3, 4095, 0, 3, 1};
+  const uint16_t sorted[] = {0, 1, 3, 3, 5, 4095};
+  analogSort(values, 6);
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(sorted, values, 6);
+}
+
+void test_median(void)
+{
+  uint16_t odd[] = {5, 1, 3};
+  TEST_ASSERT_EQUAL_FLOAT(3, analogMedian(odd, 3));
+
+  uint16_t even[] = {4, 1, 3, 2};
+  TEST_ASSERT_EQUAL_FLOAT(2.5f, analogMedian(even, 4));
+
+  // spikes at both ends do not move the median
+  uint16_t noisy[] = {100, 4095, 101, 0, 99, 100, 4095};
+  TEST_ASSERT_EQUAL_FLOAT(100, analogMedian(noisy, 7));
+}
+
+void test_trimmed_mean_discards_spikes(void)
+{
+  uint16_t values[] = {100, 101, 99, 100, 4095, 0, 100, 102, 98, 100};
+  AnalogReading reading = analogTrimmedMean(values, 10, 20);
+  // 0, 98 and 102, 4095 are discarded, 99, 100, 100, 100, 100, 101 are kept
+  TEST_ASSERT_EQUAL(6, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(100, reading.value);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f / 3, reading.variance);
+}
+
+void test_plain_mean(void)
+{
+  uint16_t values[] = {4, 1, 3, 2};
+  AnalogReading reading = analogTrimmedMean(values, 4, 0);
+  TEST_ASSERT_EQUAL(4, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(2.5f, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(1.25f, reading.variance);
+}
+
+void test_trim_half_is_median(void)
+{
+  uint16_t values[] = {100, 4095, 101, 0, 99, 100};
+  AnalogReading reading = analogTrimmedMean(values, 6, 50);
+  TEST_ASSERT_EQUAL(6, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(100, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(0, reading.variance);
+}
+
+void test_no_samples(void)
+{
+  uint16_t values[1] = {123};
+  AnalogReading reading = analogTrimmedMean(values, 0, 20);
+  TEST_ASSERT_EQUAL(0, reading.count);
+}
+
+void test_one_sample(void)
+{
+  uint16_t values[] = {42};
+  AnalogReading reading = analogTrimmedMean(values, 1, 20);
+  TEST_ASSERT_EQUAL(1, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(42, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(0, reading.variance);
+
+  uint16_t median[] = {42};
+  TEST_ASSERT_EQUAL_FLOAT(42, analogMedian(median, 1));
+}
+
+void test_two_samples(void)
+{
+  // too few samples to trim any
+  uint16_t values[] = {20, 10};
+  AnalogReading reading = analogTrimmedMean(values, 2, 20);
+  TEST_ASSERT_EQUAL(2, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(15, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(25, reading.variance);
+
+  uint16_t median[] = {20, 10};
+  TEST_ASSERT_EQUAL_FLOAT(15, analogMedian(median, 2));
+}
+
+void test_all_equal(void)
+{
+  uint16_t values[10];
+  for (uint16_t i = 0; i < 10; i++)
+  {
+    values[i] = 2048;
+  }
+  AnalogReading reading = analogTrimmedMean(values, 10, 20);
+  TEST_ASSERT_EQUAL(6, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(2048, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(0, reading.variance);
+}
+
+void test_variance_at_full_scale(void)
+{
+  // a small spread on top of a large value, where the naive sum of squares loses the variance in float
+  uint16_t values[48];
+  for (uint16_t i = 0; i < 48; i++)
+  {
+    values[i] = (i & 1) ? 4095 : 4094;
+  }
+  AnalogReading reading = analogTrimmedMean(values, 48, 0);
+  TEST_ASSERT_EQUAL(48, reading.count);
+  TEST_ASSERT_EQUAL_FLOAT(4094.5f, reading.value);
+  TEST_ASSERT_EQUAL_FLOAT(0.25f, reading.variance);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_sort);
+  RUN_TEST(test_median);
+  RUN_TEST(test_trimmed_mean_discards_spikes);
+  RUN_TEST(test_plain_mean);
+  RUN_TEST(test_trim_half_is_median);
+  RUN_TEST(test_no_samples);
+  RUN_TEST(test_one_sample);
+  RUN_TEST(test_two_samples);
+  RUN_TEST(test_all_equal);
+  RUN_TEST(test_variance_at_full_scale);
+  return UNITY_END();
+}
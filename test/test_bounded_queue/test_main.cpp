@@ -0,0 +1,138 @@
+#include <unity.h>
+#include <thread>
+#include "BoundedQueue.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fifo(void)
+{
+  BoundedQueue<int, 3> queue(DROP_OLDEST);
+  int item;
+  TEST_ASSERT_FALSE(queue.pop(&item));
+
+  TEST_ASSERT_TRUE(queue.push(1));
+  TEST_ASSERT_TRUE(queue.push(2));
+  TEST_ASSERT_EQUAL(2, queue.size());
+  TEST_ASSERT_TRUE(queue.pop(&item));
+  TEST_ASSERT_EQUAL(1, item);
+
+  // wraps around a capacity that is not a power of two
+  TEST_ASSERT_TRUE(queue.push(3));
+  TEST_ASSERT_TRUE(queue.push(4));
+  for (int expected = 2; expected <= 4; expected++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(&item));
+    TEST_ASSERT_EQUAL(expected, item);
+  }
+  TEST_ASSERT_FALSE(queue.pop(&item));
+  TEST_ASSERT_EQUAL_UINT32(0, queue.dropped());
+}
+
+void test_drop_oldest(void)
+{
+  BoundedQueue<int, 3> queue(DROP_OLDEST);
+  for (int i = 1; i <= 3; i++)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_FALSE(queue.push(4));
+  TEST_ASSERT_FALSE(queue.push(5));
+  TEST_ASSERT_EQUAL(3, queue.size());
+  TEST_ASSERT_EQUAL_UINT32(2, queue.dropped());
+
+  int item;
+  for (int expected = 3; expected <= 5; expected++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(&item));
+    TEST_ASSERT_EQUAL(expected, item);
+  }
+}
+
+void test_coalesce(void)
+{
+  BoundedQueue<int, 3> queue(COALESCE);
+  for (int i = 1; i <= 3; i++)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_FALSE(queue.push(4));
+  TEST_ASSERT_FALSE(queue.push(5));
+  TEST_ASSERT_EQUAL(3, queue.size());
+  TEST_ASSERT_EQUAL_UINT32(2, queue.dropped());
+
+  // the oldest items are kept and the newest slot holds the latest item
+  const int expected[] = {1, 2, 5};
+  int item;
+  for (int i = 0; i < 3; i++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(&item));
+    TEST_ASSERT_EQUAL(expected[i], item);
+  }
+}
+
+// Two producers push their own sequences while the main thread pops, the items of each producer must stay in order
+// and every item must be either received or counted as dropped
+static void stress(BoundedQueuePolicy policy)
+{
+  static const uint32_t count = 200000;
+  BoundedQueue<uint32_t, 8> queue(policy);
+
+  auto produce = [&queue](uint32_t producer)
+  {
+    for (uint32_t i = 0; i < count; i++)
+    {
+      queue.push(producer << 24 | i);
+    }
+  };
+  std::thread first(produce, 0);
+  std::thread second(produce, 1);
+
+  uint32_t received = 0;
+  int64_t last[2] = {-1, -1};
+  bool ordered = true;
+  uint32_t item;
+  while (received + queue.dropped() < 2 * count)
+  {
+    if (!queue.pop(&item))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t producer = item >> 24;
+    int64_t sequence = item & 0xffffff;
+    if (producer > 1 || sequence <= last[producer])
+    {
+      ordered = false;
+    }
+    last[producer] = sequence;
+    received++;
+  }
+  first.join();
+  second.join();
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL(0, queue.size());
+  TEST_ASSERT_EQUAL_UINT32(2 * count, received + queue.dropped());
+}
+
+void test_threads_drop_oldest(void)
+{
+  stress(DROP_OLDEST);
+}
+
+void test_threads_coalesce(void)
+{
+  stress(COALESCE);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo);
+  RUN_TEST(test_drop_oldest);
+  RUN_TEST(test_coalesce);
+  RUN_TEST(test_threads_drop_oldest);
+  RUN_TEST(test_threads_coalesce);
+  return UNITY_END();
+}
@@ -0,0 +1,283 @@
+#include <unity.h>
+#include <string.h>
+#include "I2CBus.h"
+#include "ENS160Sensor.h"
+
+#define MOCK_MAX_TRANSACTIONS 8
+
+/**
+ * A bus that records the transactions, answers reads from a scripted response and takes a fixed time per transaction.
+ */
+class MockI2CBus : public I2CBus
+{
+public:
+  struct Transaction
+  {
+    uint8_t address;
+    uint8_t tx[32];
+    uint8_t txLength;
+    uint8_t rxLength;
+  };
+
+  Transaction transactions[MOCK_MAX_TRANSACTIONS];
+  uint8_t count = 0;
+  uint8_t response[32] = {};
+  bool fail = false; // the next transactions are not acknowledged
+  bool stuck = false; // a failed transaction leaves the bus stuck, recover() frees it
+  uint8_t recoverCalls = 0;
+  uint32_t micros = 0;
+  uint32_t duration = 100; // of a transaction
+
+protected:
+  bool transfer(uint8_t address, const uint8_t *tx, uint8_t txLength, uint8_t *rx, uint8_t rxLength) override
+  {
+    if (count < MOCK_MAX_TRANSACTIONS)
+    {
+      Transaction &transaction = transactions[count];
+      transaction.address = address;
+      if (txLength > 0)
+      {
+        memcpy(transaction.tx, tx, txLength);
+      }
+      transaction.txLength = txLength;
+      transaction.rxLength = rxLength;
+    }
+    count++;
+    micros += duration;
+    if (fail)
+    {
+      return false;
+    }
+    if (rxLength > 0)
+    {
+      memcpy(rx, response, rxLength);
+    }
+    return true;
+  }
+
+  uint32_t clockMicros() override { return micros; }
+
+  bool recover() override
+  {
+    recoverCalls++;
+    return stuck;
+  }
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_probe(void)
+{
+  MockI2CBus bus;
+  TEST_ASSERT_TRUE(bus.probe(0x38));
+  TEST_ASSERT_EQUAL(1, bus.count);
+  TEST_ASSERT_EQUAL(0x38, bus.transactions[0].address);
+  TEST_ASSERT_EQUAL(0, bus.transactions[0].txLength);
+  TEST_ASSERT_EQUAL(0, bus.transactions[0].rxLength);
+
+  bus.fail = true;
+  TEST_ASSERT_FALSE(bus.probe(0x39));
+}
+
+void test_read_registers_single_transaction(void)
+{
+  MockI2CBus bus;
+  const uint8_t registers[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+  memcpy(bus.response, registers, sizeof(registers));
+
+  uint8_t data[6] = {};
+  TEST_ASSERT_TRUE(bus.readRegisters(0x53, 0x20, data, sizeof(data)));
+  // the register address is written then all the registers are read after a repeated start
+  TEST_ASSERT_EQUAL(1, bus.count);
+  TEST_ASSERT_EQUAL(1, bus.transactions[0].txLength);
+  TEST_ASSERT_EQUAL(0x20, bus.transactions[0].tx[0]);
+  TEST_ASSERT_EQUAL(6, bus.transactions[0].rxLength);
+  TEST_ASSERT_EQUAL_MEMORY(registers, data, sizeof(data));
+}
+
+void test_write_and_read(void)
+{
+  MockI2CBus bus;
+  const uint8_t command[] = {0xAC, 0x33, 0x00};
+  TEST_ASSERT_TRUE(bus.write(0x38, command, sizeof(command)));
+  TEST_ASSERT_EQUAL(3, bus.transactions[0].txLength);
+  TEST_ASSERT_EQUAL_MEMORY(command, bus.transactions[0].tx, sizeof(command));
+  TEST_ASSERT_EQUAL(0, bus.transactions[0].rxLength);
+
+  bus.response[0] = 0x1C;
+  uint8_t status = 0;
+  TEST_ASSERT_TRUE(bus.read(0x38, &status, 1));
+  TEST_ASSERT_EQUAL(0, bus.transactions[1].txLength);
+  TEST_ASSERT_EQUAL(1, bus.transactions[1].rxLength);
+  TEST_ASSERT_EQUAL(0x1C, status);
+}
+
+void test_write_registers(void)
+{
+  MockI2CBus bus;
+  const uint8_t values[] = {1, 2, 3, 4};
+  TEST_ASSERT_TRUE(bus.writeRegisters(0x53, 0x13, values, sizeof(values)));
+  const uint8_t expected[] = {0x13, 1, 2, 3, 4};
+  TEST_ASSERT_EQUAL(5, bus.transactions[0].txLength);
+  TEST_ASSERT_EQUAL_MEMORY(expected, bus.transactions[0].tx, sizeof(expected));
+
+  // too long to fit with the register address, rejected without touching the bus
+  uint8_t tooLong[16] = {};
+  TEST_ASSERT_FALSE(bus.writeRegisters(0x53, 0x00, tooLong, sizeof(tooLong)));
+  TEST_ASSERT_EQUAL(1, bus.count);
+  TEST_ASSERT_TRUE(bus.writeRegisters(0x53, 0x00, tooLong, sizeof(tooLong) - 1));
+}
+
+void test_stats(void)
+{
+  MockI2CBus bus;
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().averageMicros());
+
+  bus.duration = 100;
+  bus.probe(0x38);
+  bus.duration = 300;
+  bus.probe(0x38);
+  bus.duration = 200;
+  bus.probe(0x38);
+
+  TEST_ASSERT_EQUAL_UINT32(3, bus.stats().transactions);
+  TEST_ASSERT_EQUAL_UINT32(200, bus.stats().lastMicros);
+  TEST_ASSERT_EQUAL_UINT32(300, bus.stats().maxMicros);
+  TEST_ASSERT_EQUAL_UINT32(600, (uint32_t)bus.stats().totalMicros);
+  TEST_ASSERT_EQUAL_UINT32(200, bus.stats().averageMicros());
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().errors);
+}
+
+void test_stats_clock_wrap(void)
+{
+  MockI2CBus bus;
+  bus.micros = UINT32_MAX - 49;
+  bus.duration = 100;
+  bus.probe(0x38);
+  TEST_ASSERT_EQUAL_UINT32(100, bus.stats().lastMicros);
+}
+
+void test_failure_recovers(void)
+{
+  MockI2CBus bus;
+  bus.probe(0x38);
+  TEST_ASSERT_EQUAL(0, bus.recoverCalls);
+
+  // a device that does not answer, the bus is not stuck
+  bus.fail = true;
+  TEST_ASSERT_FALSE(bus.probe(0x38));
+  TEST_ASSERT_EQUAL(1, bus.recoverCalls);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().errors);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().recoveries);
+
+  // a device holds SDA low and is freed
+  bus.stuck = true;
+  uint8_t data[2];
+  TEST_ASSERT_FALSE(bus.readRegisters(0x53, 0x00, data, sizeof(data)));
+  TEST_ASSERT_EQUAL(2, bus.recoverCalls);
+  TEST_ASSERT_EQUAL_UINT32(2, bus.stats().errors);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().recoveries);
+  TEST_ASSERT_EQUAL_UINT32(3, bus.stats().transactions);
+}
+
+void test_reset_stats_keeps_errors(void)
+{
+  MockI2CBus bus;
+  bus.fail = true;
+  bus.stuck = true;
+  bus.probe(0x38);
+  bus.resetStats();
+
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().transactions);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().lastMicros);
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().maxMicros);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)bus.stats().totalMicros);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().errors);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().recoveries);
+}
+
+void test_ens160_begin(void)
+{
+  MockI2CBus bus;
+  ENS160Sensor sensor(bus);
+  bus.response[0] = 0x60; // part ID, little endian
+  bus.response[1] = 0x01;
+  TEST_ASSERT_EQUAL(0, sensor.begin());
+
+  TEST_ASSERT_EQUAL(3, bus.count);
+  TEST_ASSERT_EQUAL(ENS160_I2C_ADDRESS, bus.transactions[0].address);
+  TEST_ASSERT_EQUAL(0x00, bus.transactions[0].tx[0]);
+  TEST_ASSERT_EQUAL(2, bus.transactions[0].rxLength);
+  const uint8_t config[] = {0x11, 0x00};
+  const uint8_t opmode[] = {0x10, 0x02};
+  TEST_ASSERT_EQUAL(2, bus.transactions[1].txLength);
+  TEST_ASSERT_EQUAL_MEMORY(config, bus.transactions[1].tx, sizeof(config));
+  TEST_ASSERT_EQUAL(2, bus.transactions[2].txLength);
+  TEST_ASSERT_EQUAL_MEMORY(opmode, bus.transactions[2].tx, sizeof(opmode));
+}
+
+void test_ens160_begin_errors(void)
+{
+  MockI2CBus bus;
+  ENS160Sensor sensor(bus);
+  bus.response[0] = 0x61;
+  bus.response[1] = 0x01;
+  TEST_ASSERT_EQUAL(2, sensor.begin());
+
+  bus.fail = true;
+  TEST_ASSERT_EQUAL(1, sensor.begin());
+}
+
+void test_ens160_read(void)
+{
+  MockI2CBus bus;
+  ENS160Sensor sensor(bus);
+  // status (validity 1 in bits 2-3), AQI, TVOC 0x0123 and eCO2 0x0456, little endian
+  const uint8_t registers[] = {0x84, 0x03, 0x23, 0x01, 0x56, 0x04};
+  memcpy(bus.response, registers, sizeof(registers));
+
+  ENS160Reading reading;
+  TEST_ASSERT_TRUE(sensor.read(&reading));
+  // all the values in a single transaction
+  TEST_ASSERT_EQUAL(1, bus.count);
+  TEST_ASSERT_EQUAL(0x20, bus.transactions[0].tx[0]);
+  TEST_ASSERT_EQUAL(ENS160_VALIDITY_WARM_UP, reading.validity);
+  TEST_ASSERT_EQUAL(3, reading.aqi);
+  TEST_ASSERT_EQUAL(0x0123, reading.tvoc);
+  TEST_ASSERT_EQUAL(0x0456, reading.eco2);
+
+  bus.fail = true;
+  TEST_ASSERT_FALSE(sensor.read(&reading));
+}
+
+void test_ens160_compensation(void)
+{
+  MockI2CBus bus;
+  ENS160Sensor sensor(bus);
+  TEST_ASSERT_TRUE(sensor.setTempAndHum(25.0f, 50.0f));
+
+  // (25 + 273.15) * 64 = 19081 and 50 * 512 = 25600, little endian after the register address
+  const uint8_t expected[] = {0x13, 0x89, 0x4A, 0x00, 0x64};
+  TEST_ASSERT_EQUAL(1, bus.count);
+  TEST_ASSERT_EQUAL(5, bus.transactions[0].txLength);
+  TEST_ASSERT_EQUAL_MEMORY(expected, bus.transactions[0].tx, sizeof(expected));
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_probe);
+  RUN_TEST(test_read_registers_single_transaction);
+  RUN_TEST(test_write_and_read);
+  RUN_TEST(test_write_registers);
+  RUN_TEST(test_stats);
+  RUN_TEST(test_stats_clock_wrap);
+  RUN_TEST(test_failure_recovers);
+  RUN_TEST(test_reset_stats_keeps_errors);
+  RUN_TEST(test_ens160_begin);
+  RUN_TEST(test_ens160_begin_errors);
+  RUN_TEST(test_ens160_read);
+  RUN_TEST(test_ens160_compensation);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <stdio.h>
+#include <thread>
+#include "LogBuffer.h"
+
+#define PRODUCERS 4
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_push_pop(void)
+{
+  LogBuffer<4, 16> buffer;
+  uint8_t level;
+  char text[16];
+  TEST_ASSERT_FALSE(buffer.pop(&level, text));
+
+  TEST_ASSERT_TRUE(buffer.push(1, "first"));
+  TEST_ASSERT_TRUE(buffer.push(3, "second"));
+  TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL(1, level);
+  TEST_ASSERT_EQUAL_STRING("first", text);
+  TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL(3, level);
+  TEST_ASSERT_EQUAL_STRING("second", text);
+  TEST_ASSERT_FALSE(buffer.pop(&level, text));
+}
+
+void test_truncates(void)
+{
+  LogBuffer<4, 8> buffer;
+  TEST_ASSERT_TRUE(buffer.push(2, "a line longer than a slot"));
+  uint8_t level;
+  char text[8];
+  TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL_STRING("a line ", text);
+}
+
+void test_full_drops(void)
+{
+  LogBuffer<4, 16> buffer;
+  char text[16];
+  for (int i = 0; i < 4; i++)
+  {
+    snprintf(text, sizeof(text), "line %d", i);
+    TEST_ASSERT_TRUE(buffer.push(2, text));
+  }
+  TEST_ASSERT_FALSE(buffer.push(2, "line 4"));
+  TEST_ASSERT_EQUAL_UINT32(1, buffer.dropped());
+
+  // the oldest lines are kept, and a freed slot takes a line again
+  uint8_t level;
+  TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL_STRING("line 0", text);
+  TEST_ASSERT_TRUE(buffer.push(2, "line 5"));
+  for (int i = 1; i <= 3; i++)
+  {
+    TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  }
+  TEST_ASSERT_TRUE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL_STRING("line 5", text);
+}
+
+void test_threads(void)
+{
+  // several producers log numbered lines while the main thread writes them out, every line must arrive intact and
+  // in the order of its producer, or be counted as dropped
+  static LogBuffer<16, 32> buffer;
+  const uint32_t count = 100000;
+
+  std::thread producers[PRODUCERS];
+  for (uint8_t producer = 0; producer < PRODUCERS; producer++)
+  {
+    producers[producer] = std::thread([producer]()
+                                      {
+                                        char text[32];
+                                        for (uint32_t i = 0; i < count; i++)
+                                        {
+                                          snprintf(text, sizeof(text), "producer %u line %lu", producer,
+                                                   (unsigned long)i);
+                                          buffer.push(producer, text);
+                                        } });
+  }
+
+  uint32_t received = 0;
+  int64_t last[PRODUCERS] = {-1, -1, -1, -1};
+  bool intact = true;
+  bool ordered = true;
+  uint8_t level;
+  char text[32];
+  while (received + buffer.dropped() < PRODUCERS * count)
+  {
+    if (!buffer.pop(&level, text))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    unsigned producer;
+    unsigned long line;
+    if (sscanf(text, "producer %u line %lu", &producer, &line) != 2 || producer != level || producer >= PRODUCERS)
+    {
+      intact = false;
+      continue;
+    }
+    if ((int64_t)line <= last[producer])
+    {
+      ordered = false;
+    }
+    last[producer] = line;
+    received++;
+  }
+  for (std::thread &producer : producers)
+  {
+    producer.join();
+  }
+
+  TEST_ASSERT_TRUE(intact);
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_FALSE(buffer.pop(&level, text));
+  TEST_ASSERT_EQUAL_UINT32(PRODUCERS * count, received + buffer.dropped());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_push_pop);
+  RUN_TEST(test_truncates);
+  RUN_TEST(test_full_drops);
+  RUN_TEST(test_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "LoopStats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_record(void)
+{
+  LoopStats stats;
+  TEST_ASSERT_EQUAL_UINT32(0, stats.iterations());
+  TEST_ASSERT_EQUAL_UINT32(0, stats.average());
+
+  stats.record(10);
+  stats.record(30);
+  stats.record(20);
+  TEST_ASSERT_EQUAL_UINT32(3, stats.iterations());
+  TEST_ASSERT_EQUAL_UINT32(20, stats.last());
+  TEST_ASSERT_EQUAL_UINT32(30, stats.max());
+  TEST_ASSERT_EQUAL_UINT32(20, stats.average());
+}
+
+void test_average_beyond_32_bits(void)
+{
+  // the total of the durations exceeds 32 bits, its average still fits
+  LoopStats stats;
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    stats.record(4000000000U);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4000000000U, stats.average());
+}
+
+void test_reset_on_next_record(void)
+{
+  LoopStats stats;
+  stats.record(100);
+  stats.record(50);
+  stats.requestReset();
+
+  // unchanged until the loop records its next iteration
+  TEST_ASSERT_EQUAL_UINT32(2, stats.iterations());
+  TEST_ASSERT_EQUAL_UINT32(100, stats.max());
+
+  stats.record(20);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.iterations());
+  TEST_ASSERT_EQUAL_UINT32(20, stats.max());
+  TEST_ASSERT_EQUAL_UINT32(20, stats.average());
+
+  // a request is only acted on once
+  stats.record(40);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.iterations());
+  TEST_ASSERT_EQUAL_UINT32(30, stats.average());
+}
+
+void test_threads(void)
+{
+  // the loop records constant durations while another task reads the counters and asks for them to be cleared,
+  // the values it reads are always consistent
+  static LoopStats stats;
+  static std::atomic<bool> done(false);
+  const uint32_t count = 1000000;
+
+  std::thread loop([]()
+                   {
+                     for (uint32_t i = 0; i < count; i++)
+                     {
+                       stats.record(7);
+                     }
+                     done = true; });
+
+  bool consistent = true;
+  uint32_t resets = 0;
+  while (!done)
+  {
+    uint32_t max = stats.max();
+    uint32_t average = stats.average();
+    if ((max != 0 && max != 7) || (average != 0 && average != 7))
+    {
+      consistent = false;
+    }
+    stats.requestReset();
+    resets++;
+  }
+  loop.join();
+
+  TEST_ASSERT_TRUE(consistent);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, resets);
+  TEST_ASSERT_EQUAL_UINT32(7, stats.max());
+  TEST_ASSERT_EQUAL_UINT32(7, stats.average());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_record);
+  RUN_TEST(test_average_beyond_32_bits);
+  RUN_TEST(test_reset_on_next_record);
+  RUN_TEST(test_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include <unity.h>
+#include <thread>
+#include "RingBuffer.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_push_pop_in_order(void)
+{
+  RingBuffer<uint32_t, 4> ring;
+  uint32_t item;
+  TEST_ASSERT_FALSE(ring.pop(&item));
+
+  for (uint32_t i = 0; i < 3; i++)
+  {
+    TEST_ASSERT_TRUE(ring.push(i));
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, ring.size());
+  for (uint32_t i = 0; i < 3; i++)
+  {
+    TEST_ASSERT_TRUE(ring.pop(&item));
+    TEST_ASSERT_EQUAL_UINT32(i, item);
+  }
+  TEST_ASSERT_FALSE(ring.pop(&item));
+  TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+}
+
+void test_full_drops(void)
+{
+  RingBuffer<uint32_t, 4> ring;
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(ring.push(i));
+  }
+  TEST_ASSERT_FALSE(ring.push(4));
+  TEST_ASSERT_FALSE(ring.push(5));
+  TEST_ASSERT_EQUAL_UINT32(2, ring.dropped());
+  TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+
+  // the items kept are the oldest, a drop never overwrites
+  uint32_t item;
+  TEST_ASSERT_TRUE(ring.pop(&item));
+  TEST_ASSERT_EQUAL_UINT32(0, item);
+  TEST_ASSERT_TRUE(ring.push(6));
+}
+
+void test_wraps_around(void)
+{
+  RingBuffer<uint32_t, 4> ring;
+  uint32_t item;
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.push(i + 100));
+    TEST_ASSERT_TRUE(ring.pop(&item));
+    TEST_ASSERT_EQUAL_UINT32(i, item);
+    TEST_ASSERT_TRUE(ring.pop(&item));
+    TEST_ASSERT_EQUAL_UINT32(i + 100, item);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, ring.dropped());
+}
+
+void test_threads(void)
+{
+  // the producer pushes a sequence as fast as it can while the consumer pops it, every item is either received
+  // in order or counted as dropped
+  static RingBuffer<uint32_t, 64> ring;
+  const uint32_t count = 2000000;
+
+  std::thread producer([]()
+                       {
+                         for (uint32_t i = 0; i < count; i++)
+                         {
+                           ring.push(i);
+                         } });
+
+  uint32_t received = 0;
+  uint32_t expected = 0;
+  uint32_t skipped = 0;
+  bool ordered = true;
+  uint32_t item;
+  while (received + ring.dropped() < count || ring.size() > 0)
+  {
+    if (!ring.pop(&item))
+    {
+      continue;
+    }
+    if (item < expected)
+    {
+      ordered = false;
+    }
+    skipped += item - expected;
+    expected = item + 1;
+    received++;
+  }
+  producer.join();
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL_UINT32(count, received + ring.dropped());
+  // the gaps in the sequence are exactly the items reported as dropped
+  TEST_ASSERT_EQUAL_UINT32(ring.dropped(), skipped + (count - expected));
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_push_pop_in_order);
+  RUN_TEST(test_full_drops);
+  RUN_TEST(test_wraps_around);
+  RUN_TEST(test_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,251 @@
+#include <unity.h>
+#include <map>
+#include <vector>
+#include <string.h>
+#include "Spool.h"
+
+// Keeps the blocks in RAM, appending can be made to fail to simulate a full partition
+class FakeSpoolStorage : public SpoolStorage
+{
+public:
+  std::map<uint32_t, std::vector<uint8_t>> blocks;
+  bool available = true;
+  bool full = false;
+
+  bool begin() override { return available; }
+
+  bool find(uint32_t *first, uint32_t *last) override
+  {
+    if (blocks.empty())
+    {
+      return false;
+    }
+    *first = blocks.begin()->first;
+    *last = blocks.rbegin()->first;
+    return true;
+  }
+
+  uint32_t size(uint32_t block) override
+  {
+    auto found = blocks.find(block);
+    return found == blocks.end() ? 0 : found->second.size();
+  }
+
+  bool read(uint32_t block, uint32_t offset, void *dest, uint32_t length) override
+  {
+    auto found = blocks.find(block);
+    if (found == blocks.end() || offset + length > found->second.size())
+    {
+      return false;
+    }
+    memcpy(dest, found->second.data() + offset, length);
+    return true;
+  }
+
+  bool append(uint32_t block, const void *data, uint32_t length) override
+  {
+    if (full)
+    {
+      return false;
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    blocks[block].insert(blocks[block].end(), bytes, bytes + length);
+    return true;
+  }
+
+  void remove(uint32_t block) override { blocks.erase(block); }
+};
+
+struct Record
+{
+  uint32_t value;
+  uint32_t prepared; // number of times the record went through prepare()
+};
+
+static void prepare(Record *record) { record->prepared++; }
+
+// 4 records in RAM, moved to storage 2 at a time, at most 3 blocks
+typedef Spool<Record, 4, 2, 3> TestSpool;
+
+static void push(TestSpool &spool, uint32_t from, uint32_t to)
+{
+  for (uint32_t value = from; value < to; value++)
+  {
+    spool.push(Record{value, 0});
+  }
+}
+
+// replays the whole spool, checking that the values come out in order
+static void expectReplay(TestSpool &spool, uint32_t from, uint32_t to)
+{
+  Record record;
+  for (uint32_t value = from; value < to; value++)
+  {
+    TEST_ASSERT_TRUE(spool.peek(&record));
+    TEST_ASSERT_EQUAL_UINT32(value, record.value);
+    spool.drop();
+  }
+  TEST_ASSERT_FALSE(spool.peek(&record));
+  TEST_ASSERT_EQUAL_UINT32(0, spool.size());
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_ram_only(void)
+{
+  FakeSpoolStorage storage;
+  TestSpool spool(storage, prepare);
+  TEST_ASSERT_TRUE(spool.begin());
+
+  push(spool, 0, 4);
+  TEST_ASSERT_EQUAL_UINT32(4, spool.size());
+  TEST_ASSERT_EQUAL_UINT32(0, spool.stored());
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+  expectReplay(spool, 0, 4);
+}
+
+void test_spills_to_storage(void)
+{
+  FakeSpoolStorage storage;
+  TestSpool spool(storage, prepare);
+  spool.begin();
+
+  // the fifth record moves the 2 oldest to a block
+  push(spool, 0, 5);
+  TEST_ASSERT_EQUAL_UINT32(5, spool.size());
+  TEST_ASSERT_EQUAL_UINT32(2, spool.stored());
+  TEST_ASSERT_EQUAL_UINT32(1, storage.blocks.size());
+  TEST_ASSERT_EQUAL_UINT32(sizeof(SpoolBlockHeader) + 2 * sizeof(Record), storage.size(0));
+
+  Record record;
+  TEST_ASSERT_TRUE(storage.read(0, sizeof(SpoolBlockHeader), &record, sizeof(record)));
+  TEST_ASSERT_EQUAL_UINT32(0, record.value);
+  TEST_ASSERT_EQUAL_UINT32(1, record.prepared);
+
+  push(spool, 5, 9);
+  TEST_ASSERT_EQUAL_UINT32(3, storage.blocks.size());
+  TEST_ASSERT_EQUAL_UINT32(0, spool.dropped());
+  expectReplay(spool, 0, 9);
+}
+
+void test_drop_on_ack(void)
+{
+  FakeSpoolStorage storage;
+  TestSpool spool(storage, prepare);
+  spool.begin();
+  push(spool, 0, 6);
+
+  // a record stays at the head until it is dropped, e.g. when publishing it failed
+  Record record;
+  TEST_ASSERT_TRUE(spool.peek(&record));
+  TEST_ASSERT_EQUAL_UINT32(0, record.value);
+  TEST_ASSERT_TRUE(spool.peek(&record));
+  TEST_ASSERT_EQUAL_UINT32(0, record.value);
+  TEST_ASSERT_EQUAL_UINT32(6, spool.size());
+
+  // a block is deleted once all its records were dropped
+  spool.drop();
+  TEST_ASSERT_EQUAL_UINT32(1, storage.blocks.size());
+  spool.drop();
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+  expectReplay(spool, 2, 6);
+}
+
+void test_oldest_block_dropped_when_full(void)
+{
+  FakeSpoolStorage storage;
+  TestSpool spool(storage, prepare);
+  spool.begin();
+
+  // 3 blocks and a full RAM, the next block replaces the oldest one
+  push(spool, 0, 10);
+  TEST_ASSERT_EQUAL_UINT32(0, spool.dropped());
+  push(spool, 10, 12);
+  TEST_ASSERT_EQUAL_UINT32(2, spool.dropped());
+  TEST_ASSERT_EQUAL_UINT32(3, storage.blocks.size());
+  expectReplay(spool, 2, 12);
+}
+
+void test_storage_full(void)
+{
+  FakeSpoolStorage storage;
+  TestSpool spool(storage, prepare);
+  spool.begin();
+  storage.full = true;
+
+  // nothing can be written, the RAM keeps the newest records
+  push(spool, 0, 6);
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+  TEST_ASSERT_EQUAL_UINT32(2, spool.dropped());
+  expectReplay(spool, 2, 6);
+}
+
+void test_storage_unavailable(void)
+{
+  FakeSpoolStorage storage;
+  storage.available = false;
+  TestSpool spool(storage, prepare);
+  TEST_ASSERT_FALSE(spool.begin());
+
+  push(spool, 0, 6);
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+  TEST_ASSERT_EQUAL_UINT32(2, spool.dropped());
+  expectReplay(spool, 2, 6);
+}
+
+void test_survives_reboot(void)
+{
+  FakeSpoolStorage storage;
+  {
+    TestSpool spool(storage, prepare);
+    spool.begin();
+    push(spool, 0, 7);
+
+    // a block partially replayed before the reboot is replayed from its start
+    Record record;
+    TEST_ASSERT_TRUE(spool.peek(&record));
+    spool.drop();
+    spool.save();
+  }
+
+  TestSpool spool(storage, prepare);
+  spool.begin();
+  TEST_ASSERT_EQUAL_UINT32(7, spool.size());
+  expectReplay(spool, 0, 7);
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+}
+
+void test_discards_other_firmware(void)
+{
+  FakeSpoolStorage storage;
+  // a block written with records of another size
+  SpoolBlockHeader header = {SPOOL_MAGIC, sizeof(Record) + 4};
+  storage.append(7, &header, sizeof(header));
+  storage.append(7, "12345678", 8);
+  {
+    TestSpool spool(storage, prepare);
+    spool.begin();
+    push(spool, 0, 5);
+  }
+
+  TestSpool spool(storage, prepare);
+  spool.begin();
+  TEST_ASSERT_EQUAL_UINT32(2, spool.size());
+  expectReplay(spool, 0, 2);
+  TEST_ASSERT_TRUE(storage.blocks.empty());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ram_only);
+  RUN_TEST(test_spills_to_storage);
+  RUN_TEST(test_drop_on_ack);
+  RUN_TEST(test_oldest_block_dropped_when_full);
+  RUN_TEST(test_storage_full);
+  RUN_TEST(test_storage_unavailable);
+  RUN_TEST(test_survives_reboot);
+  RUN_TEST(test_discards_other_firmware);
+  return UNITY_END();
+}
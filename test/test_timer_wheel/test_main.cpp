@@ -0,0 +1,161 @@
+#include <unity.h>
+#include "TimerWheel.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_periods(void)
+{
+  TimerWheel wheel(10);
+  TEST_ASSERT_EQUAL(0, wheel.add(100, 0));
+  TEST_ASSERT_EQUAL(1, wheel.add(250, 0));
+  TEST_ASSERT_EQUAL(2, wheel.add(1000, 0));
+
+  // due straight away
+  TEST_ASSERT_EQUAL_UINT32(0b111, wheel.poll(0));
+
+  uint32_t expirations[3] = {0, 0, 0};
+  for (uint32_t now = 10; now <= 1000; now += 10)
+  {
+    uint16_t expired = wheel.poll(now);
+    for (uint8_t id = 0; id < 3; id++)
+    {
+      if (expired & (1U << id))
+      {
+        expirations[id]++;
+        TEST_ASSERT_EQUAL_UINT32(0, wheel.lastJitter());
+      }
+    }
+    TEST_ASSERT_EQUAL_UINT32(now % 100 == 0, (expired & 0b001) != 0);
+    TEST_ASSERT_EQUAL_UINT32(now % 250 == 0, (expired & 0b010) != 0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(10, expirations[0]);
+  TEST_ASSERT_EQUAL_UINT32(4, expirations[1]);
+  TEST_ASSERT_EQUAL_UINT32(1, expirations[2]);
+}
+
+void test_deadline_beyond_revolution(void)
+{
+  // 1000 ms is 100 ticks, the timer comes round in its slot 6 times before it is due
+  TimerWheel wheel(10);
+  wheel.add(1000, 0);
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(0));
+  for (uint32_t now = 10; now < 1000; now += 10)
+  {
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.poll(now));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(1000));
+  TEST_ASSERT_EQUAL_UINT32(1000, wheel.nextIn(1000));
+}
+
+void test_poll_between_ticks(void)
+{
+  TimerWheel wheel(10);
+  wheel.add(25, 0);
+  wheel.poll(0);
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.poll(24));
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(27));
+  TEST_ASSERT_EQUAL_UINT32(2, wheel.lastJitter());
+  // the next deadline is derived from the previous one, not from the late poll
+  TEST_ASSERT_EQUAL_UINT32(23, wheel.nextIn(27));
+}
+
+void test_late_poll_skips_periods(void)
+{
+  TimerWheel wheel(10);
+  wheel.add(100, 0);
+  wheel.poll(0);
+
+  // the deadlines 100 to 500 were missed, the timer expires once rather than 5 times
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(550));
+  TEST_ASSERT_EQUAL_UINT32(450, wheel.lastJitter());
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.poll(560));
+  TEST_ASSERT_EQUAL_UINT32(40, wheel.nextIn(560));
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.poll(599));
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(600));
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.lastJitter());
+}
+
+void test_late_poll_beyond_revolution(void)
+{
+  // more than a revolution of the wheel went past, every slot is visited once
+  TimerWheel wheel(10);
+  wheel.add(30, 0);
+  wheel.add(70, 0);
+  wheel.poll(0);
+  TEST_ASSERT_EQUAL_UINT32(0b11, wheel.poll(1005));
+  // the next deadlines stay on the grid of the periods: 1020 and 1050
+  TEST_ASSERT_EQUAL_UINT32(15, wheel.nextIn(1005));
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.poll(1010));
+  TEST_ASSERT_EQUAL_UINT32(0b01, wheel.poll(1020));
+  TEST_ASSERT_EQUAL_UINT32(0b11, wheel.poll(1050));
+}
+
+void test_millis_wrap(void)
+{
+  TimerWheel wheel(10);
+  uint32_t start = UINT32_MAX - 149;
+  wheel.add(100, start);
+  TEST_ASSERT_EQUAL_UINT32(1, wheel.poll(start));
+
+  uint8_t expirations = 0;
+  for (uint32_t elapsed = 10; elapsed <= 300; elapsed += 10)
+  {
+    uint16_t expired = wheel.poll(start + elapsed);
+    TEST_ASSERT_EQUAL_UINT32(elapsed % 100 == 0, expired);
+    if (expired)
+    {
+      expirations++;
+      TEST_ASSERT_EQUAL_UINT32(0, wheel.lastJitter());
+    }
+  }
+  TEST_ASSERT_EQUAL(3, expirations);
+  TEST_ASSERT_EQUAL_UINT32(100, wheel.nextIn(start + 300));
+}
+
+void test_next_in(void)
+{
+  TimerWheel wheel(10);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wheel.nextIn(0));
+
+  wheel.add(100, 0);
+  wheel.add(30, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.nextIn(0));
+
+  wheel.poll(0);
+  TEST_ASSERT_EQUAL_UINT32(30, wheel.nextIn(0));
+  TEST_ASSERT_EQUAL_UINT32(20, wheel.nextIn(10));
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.nextIn(30));
+  TEST_ASSERT_EQUAL_UINT32(0, wheel.nextIn(45)); // overdue
+
+  wheel.poll(30);
+  TEST_ASSERT_EQUAL_UINT32(30, wheel.nextIn(30));
+  wheel.poll(90);
+  TEST_ASSERT_EQUAL_UINT32(10, wheel.nextIn(90));
+}
+
+void test_add_limit(void)
+{
+  TimerWheel wheel(10);
+  TEST_ASSERT_EQUAL(-1, wheel.add(0, 0));
+  for (uint8_t i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++)
+  {
+    TEST_ASSERT_EQUAL(i, wheel.add(100 + i, 0));
+  }
+  TEST_ASSERT_EQUAL(-1, wheel.add(100, 0));
+  TEST_ASSERT_EQUAL_UINT32(0xffff, wheel.poll(0));
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_periods);
+  RUN_TEST(test_deadline_beyond_revolution);
+  RUN_TEST(test_poll_between_ticks);
+  RUN_TEST(test_late_poll_skips_periods);
+  RUN_TEST(test_late_poll_beyond_revolution);
+  RUN_TEST(test_millis_wrap);
+  RUN_TEST(test_next_in);
+  RUN_TEST(test_add_limit);
+  return UNITY_END();
+}
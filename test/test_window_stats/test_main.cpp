@@ -0,0 +1,96 @@
+#include <unity.h>
+#include "WindowStats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_empty(void)
+{
+  WindowStats stats;
+  TEST_ASSERT_EQUAL(0, stats.count());
+  TEST_ASSERT_TRUE(isnan(stats.mean()));
+  TEST_ASSERT_TRUE(isnan(stats.min()));
+  TEST_ASSERT_TRUE(isnan(stats.max()));
+  TEST_ASSERT_TRUE(isnan(stats.stddev()));
+}
+
+void test_values(void)
+{
+  WindowStats stats;
+  const float values[] = {2, 4, 4, 4, 5, 5, 7, 9};
+  for (float value : values)
+  {
+    stats.add(value);
+  }
+  TEST_ASSERT_EQUAL(8, stats.count());
+  TEST_ASSERT_EQUAL_FLOAT(5, stats.mean());
+  TEST_ASSERT_EQUAL_FLOAT(2, stats.min());
+  TEST_ASSERT_EQUAL_FLOAT(9, stats.max());
+  // sample standard deviation, the sum of the squared differences is 32
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, sqrtf(32.0f / 7), stats.stddev());
+}
+
+void test_negative_values(void)
+{
+  WindowStats stats;
+  stats.add(-3);
+  stats.add(-1);
+  TEST_ASSERT_EQUAL_FLOAT(-2, stats.mean());
+  TEST_ASSERT_EQUAL_FLOAT(-3, stats.min());
+  TEST_ASSERT_EQUAL_FLOAT(-1, stats.max());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, sqrtf(2), stats.stddev());
+}
+
+void test_single_value(void)
+{
+  WindowStats stats;
+  stats.add(21.5f);
+  TEST_ASSERT_EQUAL(1, stats.count());
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, stats.mean());
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, stats.min());
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, stats.max());
+  TEST_ASSERT_EQUAL_FLOAT(0, stats.stddev());
+}
+
+void test_reset(void)
+{
+  WindowStats stats;
+  stats.add(100);
+  stats.add(200);
+  stats.reset();
+  TEST_ASSERT_EQUAL(0, stats.count());
+  TEST_ASSERT_TRUE(isnan(stats.mean()));
+
+  // the extremes of the previous window are forgotten
+  stats.add(150);
+  TEST_ASSERT_EQUAL_FLOAT(150, stats.min());
+  TEST_ASSERT_EQUAL_FLOAT(150, stats.max());
+}
+
+void test_large_offset(void)
+{
+  // a small spread far from zero, where the sum of the squares in a float would lose the variance entirely
+  WindowStats stats;
+  const uint16_t count = 10000;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    stats.add((i & 1) ? 100002.0f : 99998.0f);
+  }
+  TEST_ASSERT_EQUAL(count, stats.count());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 100000.0f, stats.mean());
+  TEST_ASSERT_EQUAL_FLOAT(99998.0f, stats.min());
+  TEST_ASSERT_EQUAL_FLOAT(100002.0f, stats.max());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f * sqrtf((float)count / (count - 1)), stats.stddev());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_empty);
+  RUN_TEST(test_values);
+  RUN_TEST(test_negative_values);
+  RUN_TEST(test_single_value);
+  RUN_TEST(test_reset);
+  RUN_TEST(test_large_offset);
+  return UNITY_END();
+}